@@ -0,0 +1,98 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "Benchmark.hpp"
+
+#include <json/json.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+
+
+double BenchmarkResult::pixelMicsPerSecond() const
+{
+	return double(pixels) * mics / seconds;
+}
+
+double BenchmarkResult::nsPerEvaluation() const
+{
+	return seconds * 1e9 / (double(pixels) * mics);
+}
+
+Benchmark::Benchmark(double minSeconds, int rounds, std::string const & filter)
+: minSeconds_(minSeconds),
+	rounds_(std::max(1, rounds)),
+	filter_(filter)
+{
+	// no code
+}
+
+void Benchmark::run(std::string const & name, std::string const & geometry, int type, int mics, long pixels,
+		std::function<void()> const & body)
+{
+	if (!filter_.empty() && name.find(filter_) == std::string::npos)
+	{
+		return;
+	}
+
+	typedef std::chrono::steady_clock Clock;
+
+	BenchmarkResult result;
+	result.name = name;
+	result.geometry = geometry;
+	result.type = type;
+	result.mics = mics;
+	result.pixels = pixels;
+	result.iterations = 0;
+	result.seconds = std::numeric_limits<double>::infinity();
+
+	for (int round = 0; round < rounds_; round++)
+	{
+		long iterations = 0;
+		double elapsed = 0;
+		Clock::time_point start = Clock::now();
+		do
+		{
+			body();
+			iterations++;
+			elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+		} while (elapsed < minSeconds_);
+
+		result.iterations += iterations;
+		result.seconds = std::min(result.seconds, elapsed / iterations);
+	}
+
+	printf("%-28s %-28s %5d mics %9ld px %10.3f ms %9.3f ns/eval %10.3g px*mics/s\n",
+		name.c_str(), geometry.c_str(), mics, pixels, result.seconds * 1e3,
+		result.nsPerEvaluation(), result.pixelMicsPerSecond());
+	fflush(stdout);
+
+	results_.push_back(result);
+}
+
+Json::Value Benchmark::toJson() const
+{
+	Json::Value root(Json::objectValue);
+	root["min_seconds"] = minSeconds_;
+	root["rounds"] = rounds_;
+
+	Json::Value & list = root["benchmarks"] = Json::Value(Json::arrayValue);
+	for (BenchmarkResult const & r : results_)
+	{
+		Json::Value v(Json::objectValue);
+		v["name"] = r.name;
+		v["geometry"] = r.geometry;
+		v["type"] = r.type;
+		v["mics"] = r.mics;
+		v["pixels"] = Json::Int64(r.pixels);
+		v["iterations"] = Json::Int64(r.iterations);
+		v["seconds"] = r.seconds;
+		v["pixel_mics_per_second"] = r.pixelMicsPerSecond();
+		v["ns_per_evaluation"] = r.nsPerEvaluation();
+		list.append(v);
+	}
+	return root;
+}
@@ -0,0 +1,52 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Json { class Value; }
+
+
+/** One timed benchmark case. */
+struct BenchmarkResult {
+	std::string name;        //!< what was timed, e.g. "renderSoundOnWall"
+	std::string geometry;    //!< mic array description
+	int type;                //!< mic array type (see createMicArray()), -1 for synthetic arrays
+	int mics;
+	long pixels;             //!< listener positions per iteration
+	long iterations;
+	double seconds;          //!< best time for a single iteration
+
+	/** listener positions * mics per second */
+	double pixelMicsPerSecond() const;
+
+	/** nanoseconds per listener position and mic */
+	double nsPerEvaluation() const;
+};
+
+/**
+ * Times body() by calling it repeatedly for at least minSeconds (at least once),
+ * a few rounds, and keeps the fastest average iteration time of any round.
+ */
+class Benchmark {
+	double minSeconds_;
+	int rounds_;
+	std::string filter_;
+	std::vector<BenchmarkResult> results_;
+public:
+	/** @param filter only run cases whose name contains this (empty runs everything) */
+	Benchmark(double minSeconds, int rounds, std::string const & filter);
+
+	/** Run and record one case, and print a line about it to stdout. */
+	void run(std::string const & name, std::string const & geometry, int type, int mics, long pixels,
+			std::function<void()> const & body);
+
+	std::vector<BenchmarkResult> const & results() const { return results_; }
+
+	/** All results, in the format "make bench" writes to bench_output.json. */
+	Json::Value toJson() const;
+};
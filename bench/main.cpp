@@ -0,0 +1,321 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+// Micro benchmarks for the renderers, run by "make bench".
+//
+
+#include "Benchmark.hpp"
+
+#include "ArgumentParser.h"
+#include "CrossSpectral.hpp"
+#include "DelayAndSum.hpp"
+#include "FakePointSoundSource.hpp"
+#include "FieldBuffer.hpp"
+#include "FieldKernel.hpp"
+#include "FieldPrecision.hpp"
+#include "MicArrayFactory.hpp"
+#include "PolarPattern.hpp"
+#include "RenderSound.hpp"
+#include "SceneSimulator.hpp"
+#include "WorkerPool.hpp"
+#include "arrays/RandomTransducerArray.hpp"
+
+#include <json/json.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+
+namespace {
+	const double speedOfSound = 343;
+	const double audioFrequency = 3000;
+	const double z = 10;
+
+	std::string typeName(int type)
+	{
+		switch (type)
+		{
+		case RING: return "ring";
+		case DOUBLE_RING: return "double_ring";
+		case RECTANGULAR: return "rectangular";
+		case HOMO: return "homogeneous";
+		case RESPEAKER_4_MIC_FOR_RPI: return "respeaker_4";
+		case RESPEAKER_6_MIC_FOR_RPI: return "respeaker_6";
+		case SPIRAL1: return "spiral";
+		case RANDOM: return "random";
+		}
+		return "unknown";
+	}
+
+	/** Keeps the optimizer from dropping computations whose result is unused. */
+	volatile double sink;
+
+	void benchPhasors(Benchmark & bench, std::string const & geometry, int type, std::vector<Transducer> const & mics)
+	{
+		// 64x64 listener positions on the wall
+		std::vector<Pos> listeners;
+		for (double y : linspace(-5, 5, 64))
+		{
+			for (double x : linspace(-5, 5, 64))
+			{
+				listeners.push_back(Pos(x, y, z));
+			}
+		}
+
+		bench.run("getPhasors", geometry, type, mics.size(), listeners.size(), [&]
+		{
+			double sum = 0;
+			for (Pos const & p : listeners)
+			{
+				sum += getPhasors(mics, p, audioFrequency, speedOfSound)[0].real();
+			}
+			sink = sum;
+		});
+
+		std::vector<std::vector<std::complex<double> > > phasors;
+		for (Pos const & p : listeners)
+		{
+			phasors.push_back(getPhasors(mics, p, audioFrequency, speedOfSound));
+		}
+		bench.run("sumPhasors", geometry, type, mics.size(), listeners.size(), [&]
+		{
+			double sum = 0;
+			for (auto const & v : phasors)
+			{
+				sum += sumPhasors(v).real();
+			}
+			sink = sum;
+		});
+
+		bench.run("accumulateField", geometry, type, mics.size(), listeners.size(), [&]
+		{
+			double sum = 0;
+			for (Pos const & p : listeners)
+			{
+				sum += accumulateField(mics, p, audioFrequency, speedOfSound).real();
+			}
+			sink = sum;
+		});
+	}
+
+	void benchWall(Benchmark & bench, std::string const & geometry, int type, std::vector<Transducer> const & mics,
+			int dimension, WorkerPool & pool)
+	{
+		std::vector<double> xvals = linspace(-5, 5, dimension);
+		std::vector<double> yvals = linspace(-5, 5, dimension);
+		FieldBuffer img(dimension, dimension);
+
+		std::ostringstream name;
+		name << "renderSoundOnWall/" << dimension;
+		bench.run(name.str(), geometry, type, mics.size(), long(dimension) * dimension, [&]
+		{
+			renderSoundOnWall(xvals, yvals, z, audioFrequency, mics, speedOfSound, img, pool);
+		});
+
+		for (FieldPrecision precision : { FieldPrecision::DOUBLE, FieldPrecision::FLOAT, FieldPrecision::MIXED })
+		{
+			std::ostringstream precisionName;
+			precisionName << "renderSoundOnWallPrecision/" << fieldPrecisionName(precision) << "/" << dimension;
+			bench.run(precisionName.str(), geometry, type, mics.size(), long(dimension) * dimension, [&]
+			{
+				renderSoundOnWallPrecision(xvals, yvals, z, audioFrequency, mics, speedOfSound, precision, img, pool);
+			});
+		}
+	}
+
+	void benchPolar(Benchmark & bench, std::string const & geometry, int type, std::vector<Transducer> const & mics,
+			std::string const & scratchFile, WorkerPool & pool)
+	{
+		std::vector<double> dB;
+		bench.run("computePolarPattern", geometry, type, mics.size(), polarPatternAngles, [&]
+		{
+			computePolarPattern(z, audioFrequency, mics, speedOfSound, dB, pool);
+		});
+
+		// 20000 directions, plus drawing and writing the png
+		bench.run("renderSoundPolarPattern", geometry, type, mics.size(), 20000, [&]
+		{
+			renderSoundPolarPattern(z, audioFrequency, mics, speedOfSound, geometry, scratchFile);
+		});
+	}
+
+	/** One second of 48 kHz samples for every mic, in both layouts. */
+	void benchSynthesis(Benchmark & bench, std::string const & geometry, int type, std::vector<Transducer> const & mics)
+	{
+		const int samplerate = 48000;
+		FakePointSoundSource source(Pos(1, 2, z), 1.0, audioFrequency, 0.3, speedOfSound);
+		std::vector<Pos> listeners;
+		for (auto const & mic : mics)
+		{
+			listeners.push_back(mic.pos);
+		}
+		std::vector<double> samples(size_t(samplerate) * listeners.size());
+
+		bench.run("synthesizePlanar", geometry, type, mics.size(), samplerate, [&]
+		{
+			source.getSamples(listeners, samplerate, 0, samples.data(), samplerate, SampleLayout::PLANAR);
+			sink = samples[samples.size() / 2];
+		});
+		bench.run("synthesizeInterleaved", geometry, type, mics.size(), samplerate, [&]
+		{
+			source.getSamples(listeners, samplerate, 0, samples.data(), samplerate, SampleLayout::INTERLEAVED);
+			sink = samples[samples.size() / 2];
+		});
+	}
+
+	/** One second of 48 kHz samples of a four source scene, on every mic. */
+	void benchScene(Benchmark & bench, std::string const & geometry, int type, std::vector<Transducer> const & mics,
+			WorkerPool & pool)
+	{
+		const int samplerate = 48000;
+		std::vector<FakePointSoundSource> sources;
+		for (int i = 0; i < 4; i++)
+		{
+			sources.push_back(FakePointSoundSource(Pos(i - 1.5, 0.5 * i, z), 1.0, 500 + 700 * i, 0.1 * i, speedOfSound));
+		}
+		SceneSimulator scene(sources, mics, samplerate);
+		std::vector<double> samples(size_t(samplerate) * mics.size());
+
+		bench.run("simulateScene", geometry, type, mics.size(), samplerate, [&]
+		{
+			scene.render(0, samples.data(), samplerate, SampleLayout::PLANAR, pool);
+			sink = samples[samples.size() / 2];
+		});
+	}
+
+	/** Delay-and-sum image over a 128x128 wall from one second of 48 kHz recording. */
+	void benchDelayAndSum(Benchmark & bench, std::string const & geometry, int type, std::vector<Transducer> const & mics,
+			WorkerPool & pool)
+	{
+		const int samplerate = 48000;
+		const int dimension = 128;
+		FakePointSoundSource source(Pos(2, -3, z), 100.0, audioFrequency, 0.0, speedOfSound);
+		std::vector<double> samples = SceneSimulator({ source }, mics, samplerate).render(0, samplerate, SampleLayout::PLANAR, pool);
+		Recording recording(samplerate, mics.size(), samplerate);
+		for (size_t ch = 0; ch < mics.size(); ch++)
+		{
+			std::copy(samples.begin() + ch * samplerate, samples.begin() + (ch + 1) * samplerate, recording.channel(ch));
+		}
+
+		std::vector<double> vals = linspace(-10, 10, dimension);
+		DelayAndSum das(vals, vals, z, mics, samplerate, speedOfSound);
+		FieldBuffer img;
+		bench.run("delayAndSum", geometry, type, mics.size(), long(dimension) * dimension, [&]
+		{
+			das.image(recording, img, pool);
+			sink = img.at(0, 0);
+		});
+
+		// The same through the cross-spectral matrix: the transform, then imaging all bins
+		CrossSpectralMatrix csm;
+		csm.compute(recording, CrossSpectralSettings(), pool);
+		bench.run("crossSpectralMatrix", geometry, type, mics.size(), samplerate, [&]
+		{
+			csm.compute(recording, CrossSpectralSettings(), pool);
+		});
+		bench.run("beamformCrossSpectral", geometry, type, mics.size(), long(dimension) * dimension, [&]
+		{
+			beamformCrossSpectral(vals, vals, z, csm, mics, speedOfSound, false, img, pool);
+			sink = img.at(0, 0);
+		});
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::string jsonFilename = "bench_output.json";
+	double minSeconds = 0.2;
+	int rounds = 3;
+	int numThreads = 1;
+	int quick = 0;
+	int showHelp = 0;
+	std::string isaArg = "auto";
+	std::string filter;
+
+	ArgumentParser parser;
+	parser.addString("--json", &jsonFilename, "Write results as JSON to this file");
+	parser.addDouble("--min-time", &minSeconds, "Minimum time (s) to repeat each case per round");
+	parser.addInt("--rounds", &rounds, "Rounds per case (the fastest is reported)");
+	parser.addInt("--threads", &numThreads, "Worker threads for the wall renderer (0 = one per core)");
+	parser.addString("--isa", &isaArg, "Field kernel instruction set (auto, scalar, avx2, avx512)");
+	parser.addString("--filter", &filter, "Only run cases whose name contains this");
+	parser.addSwitch("--quick", &quick, "Fewer resolutions and mic counts");
+	parser.addSwitch("-h", &showHelp, "Show this help");
+	parser.parse(argc, argv);
+
+	if (showHelp)
+	{
+		std::cout << parser.getHelp();
+		return 1;
+	}
+
+	FieldKernelIsa isa;
+	if (!parseFieldKernelIsa(isaArg, isa) || !isFieldKernelIsaSupported(isa))
+	{
+		std::cout << "ERROR: instruction set \"" << isaArg << "\" is not available." << std::endl;
+		return 2;
+	}
+	setFieldKernelIsa(isa);
+
+	WorkerPool pool(numThreads);
+	Benchmark bench(minSeconds, rounds, filter);
+	const std::string scratchFile = jsonFilename + ".polar.png";
+
+	std::vector<int> dimensions = quick ? std::vector<int>{ 64, 256 } : std::vector<int>{ 64, 256, 512 };
+	std::vector<int> micCounts = quick ? std::vector<int>{ 8, 256 } : std::vector<int>{ 8, 64, 256, 1024 };
+
+	// Every built-in geometry
+	for (int type = 0; type <= 10; type++)
+	{
+		std::unique_ptr<ITransducerArray> array = createMicArray(type);
+		if (!array)
+		{
+			continue;
+		}
+		std::vector<Transducer> const & mics = array->getTransducers();
+
+		benchPhasors(bench, typeName(type), type, mics);
+		for (int dimension : dimensions)
+		{
+			benchWall(bench, typeName(type), type, mics, dimension, pool);
+		}
+		benchPolar(bench, typeName(type), type, mics, scratchFile, pool);
+		if (type == RESPEAKER_4_MIC_FOR_RPI || type == RESPEAKER_6_MIC_FOR_RPI)
+		{
+			benchDelayAndSum(bench, typeName(type), type, mics, pool);
+		}
+	}
+
+	// Scaling with the number of mics
+	srand48(1);
+	for (int count : micCounts)
+	{
+		RandomTransducerArray array(count, 0.5, 0.5);
+		std::ostringstream geometry;
+		geometry << "random_" << count;
+		benchWall(bench, geometry.str(), -1, array.getTransducers(), 256, pool);
+	}
+	{
+		RandomTransducerArray array(64, 0.5, 0.5);
+		benchSynthesis(bench, "random_64", -1, array.getTransducers());
+		benchScene(bench, "random_64", -1, array.getTransducers(), pool);
+	}
+	std::remove(scratchFile.c_str());
+
+	Json::Value root = bench.toJson();
+	root["isa"] = fieldKernelIsaName(getFieldKernelIsa());
+	root["threads"] = pool.getNumThreads();
+	root["frequency"] = audioFrequency;
+
+	std::ofstream out(jsonFilename);
+	out << root << std::endl;
+	if (!out)
+	{
+		std::cout << "ERROR: could not write " << jsonFilename << std::endl;
+		return 1;
+	}
+	std::cout << "Wrote " << jsonFilename << std::endl;
+	return 0;
+}
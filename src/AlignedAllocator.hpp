@@ -0,0 +1,48 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+
+/** std::allocator replacement handing out memory aligned to Alignment bytes
+    (a full cache line / AVX-512 register by default). */
+template<class T, size_t Alignment = 64>
+struct AlignedAllocator {
+	typedef T value_type;
+
+	template<class U>
+	struct rebind { typedef AlignedAllocator<U, Alignment> other; };
+
+	AlignedAllocator() {}
+
+	template<class U>
+	AlignedAllocator(AlignedAllocator<U, Alignment> const &) {}
+
+	T* allocate(size_t n)
+	{
+		void* p = nullptr;
+		size_t bytes = n * sizeof(T);
+		if (posix_memalign(&p, Alignment, bytes ? bytes : 1) != 0)
+		{
+			throw std::bad_alloc();
+		}
+		return static_cast<T*>(p);
+	}
+
+	void deallocate(T* p, size_t) { free(p); }
+
+	template<class U>
+	bool operator==(AlignedAllocator<U, Alignment> const &) const { return true; }
+
+	template<class U>
+	bool operator!=(AlignedAllocator<U, Alignment> const &) const { return false; }
+};
+
+template<class T>
+using AlignedVector = std::vector<T, AlignedAllocator<T> >;
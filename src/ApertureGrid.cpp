@@ -0,0 +1,123 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "ApertureGrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace {
+	/** Lattices larger than this along one axis are most likely not lattices at all. */
+	const int maxLatticeSize = 4096;
+
+	/** Find origin and spacing so that all values are origin + i*spacing. */
+	bool fitAxis(std::vector<double> values, double tolerance, double & origin, double & spacing, int & count)
+	{
+		std::sort(values.begin(), values.end());
+
+		std::vector<double> distinct;
+		for (double v : values)
+		{
+			if (distinct.empty() || v - distinct.back() > tolerance)
+			{
+				distinct.push_back(v);
+			}
+		}
+
+		origin = distinct.front();
+		if (distinct.size() == 1)
+		{
+			spacing = 1.0;
+			count = 1;
+			return true;
+		}
+
+		spacing = distinct[1] - distinct[0];
+		for (size_t i = 2; i < distinct.size(); i++)
+		{
+			spacing = std::min(spacing, distinct[i] - distinct[i-1]);
+		}
+
+		double last = 0;
+		for (double v : distinct)
+		{
+			double ratio = (v - origin) / spacing;
+			last = std::round(ratio);
+			if (std::fabs(ratio - last) * spacing > tolerance || last >= maxLatticeSize)
+			{
+				return false;
+			}
+		}
+
+		// Use the end points to get the most accurate spacing
+		spacing = (distinct.back() - origin) / last;
+		count = int(last) + 1;
+		return true;
+	}
+}
+
+bool ApertureGrid::isFull() const
+{
+	for (double w : weights)
+	{
+		if (w != 1.0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool isPlanar(std::vector<Transducer> const & transducers)
+{
+	for (Transducer const & t : transducers)
+	{
+		if (t.pos.z != transducers[0].pos.z)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool detectApertureGrid(std::vector<Transducer> const & transducers, ApertureGrid & grid, double tolerance)
+{
+	if (transducers.empty())
+	{
+		return false;
+	}
+
+	std::vector<double> xs;
+	std::vector<double> ys;
+	const double z0 = transducers[0].pos.z;
+	for (Transducer const & t : transducers)
+	{
+		if (std::fabs(t.pos.z - z0) > tolerance)
+		{
+			return false;
+		}
+		xs.push_back(t.pos.x);
+		ys.push_back(t.pos.y);
+	}
+
+	ApertureGrid result;
+	result.z0 = z0;
+	if (!fitAxis(xs, tolerance, result.x0, result.dx, result.nx) ||
+		!fitAxis(ys, tolerance, result.y0, result.dy, result.ny))
+	{
+		return false;
+	}
+
+	result.weights.assign(size_t(result.nx) * result.ny, 0.0);
+	for (Transducer const & t : transducers)
+	{
+		int i = int(std::round((t.pos.x - result.x0) / result.dx));
+		int j = int(std::round((t.pos.y - result.y0) / result.dy));
+		result.weights[size_t(j) * result.nx + i] += 1.0;
+	}
+
+	grid = result;
+	return true;
+}
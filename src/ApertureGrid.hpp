@@ -0,0 +1,37 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include "Transducer.hpp"
+
+#include <vector>
+
+
+/**
+ * Transducer positions expressed as weights on a regular lattice
+ * (x0 + i*dx, y0 + j*dy, z0), i in [0, nx), j in [0, ny).
+ */
+struct ApertureGrid {
+	double x0, y0, z0;
+	double dx, dy;
+	int nx, ny;
+
+	/** nx*ny number of transducers at each lattice point, row major (index j*nx + i). */
+	std::vector<double> weights;
+
+	/** @returns true if every lattice point holds exactly one transducer, which makes
+	    the array factor separable into an x and a y factor. */
+	bool isFull() const;
+};
+
+/** @returns true if all transducers have the same z coordinate */
+bool isPlanar(std::vector<Transducer> const & transducers);
+
+/**
+ * Check if all transducers lie on a common rectangular lattice in a z plane.
+ * The lattice spacing along each axis is the smallest gap between distinct
+ * coordinates, and every coordinate must be a multiple of it (within tolerance).
+ * @returns false (leaving grid untouched) for non-gridded geometries */
+bool detectApertureGrid(std::vector<Transducer> const & transducers, ApertureGrid & grid, double tolerance = 1e-9);
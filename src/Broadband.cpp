@@ -0,0 +1,220 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "Broadband.hpp"
+#include "FarFieldFft.hpp"
+#include "StringParse.hpp"
+#include "TransducerBlock.hpp"
+
+#include <cmath>
+#include <cstdlib>
+
+
+namespace {
+	/** Scale the weights to sum to 1. @returns false if they sum to 0 (or inf) */
+	bool normalize(BroadbandSpectrum & spectrum)
+	{
+		double sum = 0;
+		for (double w : spectrum.weights)
+		{
+			sum += w;
+		}
+		if (!(sum > 0) || !std::isfinite(sum))
+		{
+			return false;
+		}
+		for (double & w : spectrum.weights)
+		{
+			w /= sum;
+		}
+		return true;
+	}
+
+	bool parseDouble(std::string const & text, double & value)
+	{
+		char* end = nullptr;
+		value = strtod(text.c_str(), &end);
+		return !text.empty() && *end == '\0';
+	}
+
+	bool startsWith(std::string const & text, std::string const & prefix)
+	{
+		return text.compare(0, prefix.size(), prefix) == 0;
+	}
+
+	/** Per-transducer state while rendering one row. */
+	struct RowScratch {
+		std::vector<double> d, amp;
+		std::vector<double> pRe, pIm;
+		std::vector<double> rRe, rIm;
+
+		explicit RowScratch(size_t n)
+		: d(n), amp(n), pRe(n), pIm(n), rRe(n), rIm(n)
+		{
+			// no code
+		}
+	};
+}
+
+BroadbandSpectrum bandSpectrum(double fLow, double fHigh, int numBins)
+{
+	BroadbandSpectrum spectrum;
+	for (int i = 0; i < numBins; i++)
+	{
+		spectrum.frequencies.push_back(fLow + (i + 0.5) * (fHigh - fLow) / numBins);
+		spectrum.weights.push_back(1.0 / numBins);
+	}
+	return spectrum;
+}
+
+BroadbandSpectrum fractionalOctaveSpectrum(double centerFrequency, int bandsPerOctave, int numBins)
+{
+	double halfWidth = std::pow(2.0, 0.5 / bandsPerOctave);
+	return bandSpectrum(centerFrequency / halfWidth, centerFrequency * halfWidth, numBins);
+}
+
+bool parseBroadbandSpectrum(std::string const & spec, int numBins, BroadbandSpectrum & spectrum)
+{
+	if (numBins < 1)
+	{
+		return false;
+	}
+
+	std::vector<std::string> parts = splitString(spec, ':');
+	double a, b;
+	if (parts.size() == 2 && parts[0] == "octave" && parseDouble(parts[1], a) && a > 0)
+	{
+		spectrum = fractionalOctaveSpectrum(a, 1, numBins);
+		return true;
+	}
+	if (parts.size() == 2 && parts[0] == "third-octave" && parseDouble(parts[1], a) && a > 0)
+	{
+		spectrum = fractionalOctaveSpectrum(a, 3, numBins);
+		return true;
+	}
+	if (parts.size() == 3 && parts[0] == "band" && parseDouble(parts[1], a) && parseDouble(parts[2], b) && 0 < a && a < b)
+	{
+		spectrum = bandSpectrum(a, b, numBins);
+		return true;
+	}
+	if (startsWith(spec, "custom:"))
+	{
+		BroadbandSpectrum result;
+		for (std::string const & item : splitString(spec.substr(7), ','))
+		{
+			std::vector<std::string> fw = splitString(item, '=');
+			if (fw.size() != 2 || !parseDouble(fw[0], a) || !parseDouble(fw[1], b) || a <= 0 || b < 0)
+			{
+				return false;
+			}
+			result.frequencies.push_back(a);
+			result.weights.push_back(b);
+		}
+		if (result.frequencies.empty() || !normalize(result))
+		{
+			return false;
+		}
+		spectrum = result;
+		return true;
+	}
+	return false;
+}
+
+void renderBroadbandOnWall(
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		BroadbandSpectrum const & spectrum,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		FieldBuffer & img,
+		WorkerPool & pool)
+{
+	TransducerBlock block(transducers);
+	const size_t M = block.size();
+	const size_t numBins = spectrum.frequencies.size();
+	img.resize(xvals.size(), yvals.size());
+
+	std::vector<double> k(numBins);
+	for (size_t n = 0; n < numBins; n++)
+	{
+		k[n] = 2 * M_PI * spectrum.frequencies[n] / speedOfSound;
+	}
+
+	const bool evenlySpaced = isEvenlySpaced(spectrum.frequencies);
+	const size_t anchorInterval = evenlySpaced ? broadbandAnchorInterval : 1;
+	const double dk = evenlySpaced ? (k.back() - k.front()) / (numBins - 1) : 0;
+
+	pool.parallelFor(yvals.size(), [&](size_t yind)
+	{
+		RowScratch s(M);
+		double* __restrict d = s.d.data();
+		double* __restrict amp = s.amp.data();
+		double* __restrict pRe = s.pRe.data();
+		double* __restrict pIm = s.pIm.data();
+		double* __restrict rRe = s.rRe.data();
+		double* __restrict rIm = s.rIm.data();
+		double const * tx = block.x();
+		double const * ty = block.y();
+		double const * tz = block.z();
+		const double y = yvals[yind];
+		double* dst = img.row(yind);
+
+		for (size_t xind = 0; xind < xvals.size(); xind++)
+		{
+			const double x = xvals[xind];
+
+			// Frequency independent part
+			for (size_t j = 0; j < M; j++)
+			{
+				double d2 = sqr(x - tx[j]) + sqr(y - ty[j]) + sqr(z - tz[j]);
+				d[j] = std::sqrt(d2);
+				amp[j] = 1.0 / d2;
+			}
+			if (evenlySpaced)
+			{
+				for (size_t j = 0; j < M; j++)
+				{
+					rRe[j] = cos(dk * d[j]);
+					rIm[j] = sin(dk * d[j]);
+				}
+			}
+
+			double power = 0;
+			for (size_t n = 0; n < numBins; n++)
+			{
+				if (n % anchorInterval == 0)
+				{
+					const double kn = k[n];
+					for (size_t j = 0; j < M; j++)
+					{
+						pRe[j] = cos(kn * d[j]);
+						pIm[j] = sin(kn * d[j]);
+					}
+				}
+				else
+				{
+					for (size_t j = 0; j < M; j++)
+					{
+						double re = pRe[j] * rRe[j] - pIm[j] * rIm[j];
+						double im = pRe[j] * rIm[j] + pIm[j] * rRe[j];
+						pRe[j] = re;
+						pIm[j] = im;
+					}
+				}
+
+				double re = 0;
+				double im = 0;
+				for (size_t j = 0; j < M; j++)
+				{
+					re += amp[j] * pRe[j];
+					im += amp[j] * pIm[j];
+				}
+				// rms^2 of the phasor re + i*im
+				power += spectrum.weights[n] * 0.5 * (sqr(re) + sqr(im));
+			}
+			dst[xind] = std::sqrt(power);
+		}
+	});
+}
@@ -0,0 +1,65 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include "FieldBuffer.hpp"
+#include "Transducer.hpp"
+#include "WorkerPool.hpp"
+
+#include <string>
+#include <vector>
+
+
+/** Number of frequency bins between exact phasor evaluations (see renderBroadbandOnWall()). */
+const int broadbandAnchorInterval = 32;
+
+/** Discrete source spectrum: a set of frequencies and their share of the total power. */
+struct BroadbandSpectrum {
+	std::vector<double> frequencies;   //!< Hz
+	std::vector<double> weights;       //!< relative power of each frequency, sums to 1
+};
+
+/** numBins equally weighted frequencies at the centers of numBins equal slices of [fLow, fHigh]. */
+BroadbandSpectrum bandSpectrum(double fLow, double fHigh, int numBins);
+
+/**
+ * Flat spectrum over the 1/bandsPerOctave octave band around centerFrequency
+ * (bandsPerOctave = 1 for octave bands, 3 for third-octave bands). */
+BroadbandSpectrum fractionalOctaveSpectrum(double centerFrequency, int bandsPerOctave, int numBins);
+
+/**
+ * Parse one of
+ *   octave:FC              octave band around FC
+ *   third-octave:FC        third-octave band around FC
+ *   band:FLOW:FHIGH        flat spectrum from FLOW to FHIGH
+ *   custom:F1=W1,F2=W2...  given frequencies with relative power W
+ * The bands are sampled with numBins frequencies. Weights are normalized to sum to 1.
+ * @returns false on malformed input, or custom weights summing to 0 */
+bool parseBroadbandSpectrum(std::string const & spec, int numBins, BroadbandSpectrum & spectrum);
+
+/**
+ * Broadband version of renderSoundOnWall(): every pixel gets the rms value of
+ * the sum over all frequencies in the spectrum, i.e.
+ *
+ *   sqrt(sum_n weights[n] * rms(frequencies[n])^2)
+ *
+ * (different frequencies are uncorrelated, so their powers add up).
+ *
+ * The wall is traversed once. Distances and amplitudes are computed once per
+ * pixel and transducer and shared by all frequencies. For evenly spaced
+ * frequencies (all band spectra) the phasor of frequency n+1 is that of n
+ * rotated by exp(i*dk*d), so sin/cos is only evaluated every
+ * broadbandAnchorInterval bins, which keeps the rounding error below ~1e-13
+ * relative. Other spectra evaluate every phasor exactly.
+ */
+void renderBroadbandOnWall(
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		BroadbandSpectrum const & spectrum,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		FieldBuffer & img,
+		WorkerPool & pool);
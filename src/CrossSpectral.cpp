@@ -0,0 +1,386 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "CrossSpectral.hpp"
+#include "Fft.hpp"
+#include "FieldKernel.hpp"
+#include "FieldKernelSimd.hpp"
+#include "SinCos.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+
+namespace {
+	/** Frames transformed before they are added to the matrix. */
+	const size_t batchFrames = 16;
+
+	/** Bins per job when adding a batch to the matrix. */
+	const size_t binsPerJob = 8;
+
+	/** Pixels per imaging job; the steering phasors of a segment stay in L2. */
+	const size_t segmentSize = 128;
+
+	/** Steering phasors of every mic for a segment of pixels, stored [mic][pixel]. */
+	struct Steering {
+		AlignedVector<double> d;
+		AlignedVector<double> aRe, aIm;         // at the current bin
+		AlignedVector<double> stepRe, stepIm;   // rotation from one FFT bin to the next
+
+		explicit Steering(size_t numMics)
+		: d(numMics * segmentSize),
+			aRe(numMics * segmentSize), aIm(numMics * segmentSize),
+			stepRe(numMics * segmentSize), stepIm(numMics * segmentSize)
+		{
+			// no code
+		}
+	};
+
+	/**
+	 * Band summed 2 Re sum_{i<k} a_i R_ik conj(a_k) (the off diagonal part of
+	 * w^H R w) for count pixels, vectorized over the pixels. Consecutive stored
+	 * bins are mostly consecutive FFT bins, so the steering phasors are rotated
+	 * from bin to bin, and re-anchored with sinCos() where bins are skipped. */
+	inline __attribute__((always_inline))
+	void crossPower(CrossSpectralMatrix const & csm, double const * binWeights, double cyclesPerMeterPerBin,
+			size_t count, Steering & s, double* __restrict dst)
+	{
+		const size_t M = csm.numMics();
+		const size_t W = segmentSize;
+		double* __restrict aRe = s.aRe.data();
+		double* __restrict aIm = s.aIm.data();
+		double* __restrict stepRe = s.stepRe.data();
+		double* __restrict stepIm = s.stepIm.data();
+		double const * __restrict d = s.d.data();
+
+		for (size_t j = 0; j < M * W; j++)
+		{
+			sinCos(2 * M_PI * cyclesPerMeterPerBin * d[j], stepIm[j], stepRe[j]);
+		}
+		std::fill(dst, dst + count, 0.0);
+
+		for (size_t b = 0; b < csm.numBins(); b++)
+		{
+			if (b > 0 && csm.binIndex(b) == csm.binIndex(b - 1) + 1)
+			{
+				for (size_t j = 0; j < M * W; j++)
+				{
+					double re = aRe[j] * stepRe[j] - aIm[j] * stepIm[j];
+					double im = aRe[j] * stepIm[j] + aIm[j] * stepRe[j];
+					aRe[j] = re;
+					aIm[j] = im;
+				}
+			}
+			else
+			{
+				const double cycles = cyclesPerMeterPerBin * csm.binIndex(b);
+				for (size_t j = 0; j < M * W; j++)
+				{
+					double c = cycles * d[j];
+					sinCos(2 * M_PI * (c - std::floor(c)), aIm[j], aRe[j]);
+				}
+			}
+
+			// Re(R_ik * a_i conj(a_k)), with a_i conj(a_k) = C + iS
+			double const * re = csm.pairsRe(b);
+			double const * im = csm.pairsIm(b);
+			const double weight = 2 * binWeights[b];
+			for (size_t i = 0; i + 1 < M; i++)
+			{
+				for (size_t k = i + 1; k < M; k++)
+				{
+					const double r = weight * *re++;
+					const double m = weight * *im++;
+					double const * __restrict iRe = aRe + i * W;
+					double const * __restrict iIm = aIm + i * W;
+					double const * __restrict kRe = aRe + k * W;
+					double const * __restrict kIm = aIm + k * W;
+					for (size_t px = 0; px < count; px++)
+					{
+						double C = iRe[px] * kRe[px] + iIm[px] * kIm[px];
+						double S = iIm[px] * kRe[px] - iRe[px] * kIm[px];
+						dst[px] += r * C - m * S;
+					}
+				}
+			}
+		}
+	}
+
+	struct SegmentKernel {
+		typedef void (*Function)(CrossSpectralMatrix const &, double const *, double, size_t, Steering &, double*);
+
+		static void generic(CrossSpectralMatrix const & csm, double const * binWeights, double cyclesPerMeterPerBin,
+				size_t count, Steering & s, double* dst)
+		{
+			crossPower(csm, binWeights, cyclesPerMeterPerBin, count, s, dst);
+		}
+
+#if FIELD_KERNEL_HAVE_X86_SIMD
+		__attribute__((target("avx2,fma")))
+		static void avx2(CrossSpectralMatrix const & csm, double const * binWeights, double cyclesPerMeterPerBin,
+				size_t count, Steering & s, double* dst)
+		{
+			crossPower(csm, binWeights, cyclesPerMeterPerBin, count, s, dst);
+		}
+
+		__attribute__((target("avx512f")))
+		static void avx512(CrossSpectralMatrix const & csm, double const * binWeights, double cyclesPerMeterPerBin,
+				size_t count, Steering & s, double* dst)
+		{
+			crossPower(csm, binWeights, cyclesPerMeterPerBin, count, s, dst);
+		}
+#endif
+
+		static Function select(FieldKernelIsa isa)
+		{
+			switch (isa)
+			{
+#if FIELD_KERNEL_HAVE_X86_SIMD
+			case FieldKernelIsa::AVX2: return &avx2;
+			case FieldKernelIsa::AVX512: return &avx512;
+#endif
+			default: return &generic;
+			}
+		}
+	};
+}
+
+bool parseCrossSpectralBand(std::string const & arg, CrossSpectralSettings & settings)
+{
+	double low, high;
+	char extra;
+	if (sscanf(arg.c_str(), "%lf:%lf%c", &low, &high, &extra) != 2 || low < 0 || high <= low)
+	{
+		return false;
+	}
+	settings.minFrequency = low;
+	settings.maxFrequency = high;
+	return true;
+}
+
+std::vector<size_t> crossSpectralBins(CrossSpectralSettings const & settings, int samplerate)
+{
+	const size_t N = settings.frameSize;
+	const double maxFrequency = settings.maxFrequency > 0 ? settings.maxFrequency : samplerate / 2.0;
+	std::vector<size_t> bins;
+	for (size_t b = 0; b <= N / 2; b++)
+	{
+		double f = double(b) * samplerate / N;
+		if (f >= settings.minFrequency && f <= maxFrequency)
+		{
+			bins.push_back(b);
+		}
+	}
+	return bins;
+}
+
+CrossSpectralMatrix::CrossSpectralMatrix()
+: numMics_(0),
+	frameSize_(0),
+	samplerate_(0),
+	numFrames_(0),
+	windowPower_(0)
+{
+	// no code
+}
+
+bool CrossSpectralMatrix::compute(Recording const & recording, CrossSpectralSettings const & settings, WorkerPool & pool)
+{
+	const size_t N = settings.frameSize;
+	const size_t M = recording.numChannels();
+	const int fs = recording.samplerate();
+	if (N < 2 || nextPowerOfTwo(N) != N || recording.numSamples() < N || M == 0 || fs <= 0)
+	{
+		return false;
+	}
+
+	std::vector<size_t> bins = crossSpectralBins(settings, fs);
+	if (bins.empty())
+	{
+		return false;
+	}
+
+	numMics_ = M;
+	frameSize_ = N;
+	samplerate_ = fs;
+	bins_ = bins;
+	const size_t hop = N / 2;
+	numFrames_ = 1 + (recording.numSamples() - N) / hop;
+
+	// Periodic Hann window
+	std::vector<double> window(N);
+	windowPower_ = 0;
+	for (size_t n = 0; n < N; n++)
+	{
+		window[n] = 0.5 - 0.5 * std::cos(2 * M_PI * n / N);
+		windowPower_ += window[n] * window[n];
+	}
+
+	const size_t B = bins_.size();
+	const size_t P = numPairs();
+	diagonal_.assign(B * M, 0.0);
+	re_.assign(B * P, 0.0);
+	im_.assign(B * P, 0.0);
+
+	// Spectra of one batch of frames, [frame][bin][mic]
+	AlignedVector<double> specRe(batchFrames * B * M);
+	AlignedVector<double> specIm(batchFrames * B * M);
+	const Fft fft(N);
+	const size_t channelPairs = (M + 1) / 2;
+
+	for (size_t f0 = 0; f0 < numFrames_; f0 += batchFrames)
+	{
+		const size_t frames = std::min(batchFrames, numFrames_ - f0);
+
+		// Two real channels per complex FFT: z = x_a + i x_b
+		pool.parallelFor(frames * channelPairs, [&](size_t job)
+		{
+			const size_t frame = job / channelPairs;
+			const size_t a = (job % channelPairs) * 2;
+			const size_t start = (f0 + frame) * hop;
+			float const * xa = recording.channel(a) + start;
+			float const * xb = a + 1 < M ? recording.channel(a + 1) + start : nullptr;
+
+			std::vector<std::complex<double> > z(N);
+			for (size_t n = 0; n < N; n++)
+			{
+				z[n] = std::complex<double>(window[n] * xa[n], xb ? window[n] * xb[n] : 0.0);
+			}
+			fft.forward(z.data());
+
+			for (size_t b = 0; b < B; b++)
+			{
+				const size_t k = bins_[b];
+				const std::complex<double> zk = z[k];
+				const std::complex<double> zn = std::conj(z[(N - k) % N]);
+				const std::complex<double> xA = 0.5 * (zk + zn);
+				const std::complex<double> xB = std::complex<double>(0, -0.5) * (zk - zn);
+
+				const size_t base = (frame * B + b) * M;
+				specRe[base + a] = xA.real();
+				specIm[base + a] = xA.imag();
+				if (xb)
+				{
+					specRe[base + a + 1] = xB.real();
+					specIm[base + a + 1] = xB.imag();
+				}
+			}
+		});
+
+		pool.parallelFor((B + binsPerJob - 1) / binsPerJob, [&](size_t job)
+		{
+			const size_t b1 = std::min(B, (job + 1) * binsPerJob);
+			for (size_t b = job * binsPerJob; b < b1; b++)
+			{
+				double* __restrict diagonal = diagonal_.data() + b * M;
+				for (size_t frame = 0; frame < frames; frame++)
+				{
+					double const * __restrict xRe = specRe.data() + (frame * B + b) * M;
+					double const * __restrict xIm = specIm.data() + (frame * B + b) * M;
+					double* __restrict re = re_.data() + b * P;
+					double* __restrict im = im_.data() + b * P;
+
+					for (size_t i = 0; i < M; i++)
+					{
+						diagonal[i] += xRe[i] * xRe[i] + xIm[i] * xIm[i];
+						for (size_t k = i + 1; k < M; k++)
+						{
+							// X_i * conj(X_k)
+							re[k - i - 1] += xRe[i] * xRe[k] + xIm[i] * xIm[k];
+							im[k - i - 1] += xIm[i] * xRe[k] - xRe[i] * xIm[k];
+						}
+						re += M - i - 1;
+						im += M - i - 1;
+					}
+				}
+			}
+		});
+	}
+
+	const double scale = 1.0 / numFrames_;
+	for (double & v : diagonal_) { v *= scale; }
+	for (double & v : re_) { v *= scale; }
+	for (double & v : im_) { v *= scale; }
+	return true;
+}
+
+std::complex<double> CrossSpectralMatrix::at(size_t b, size_t i, size_t k) const
+{
+	if (i == k)
+	{
+		return diagonal(b)[i];
+	}
+	if (i > k)
+	{
+		return std::conj(at(b, k, i));
+	}
+	const size_t pair = i * numMics_ - i * (i + 1) / 2 + (k - i - 1);
+	return std::complex<double>(pairsRe(b)[pair], pairsIm(b)[pair]);
+}
+
+bool beamformCrossSpectral(
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		CrossSpectralMatrix const & csm,
+		const std::vector<Transducer>& mics,
+		const double speedOfSound,
+		bool removeDiagonal,
+		FieldBuffer & img,
+		WorkerPool & pool)
+{
+	const size_t M = mics.size();
+	if (M == 0 || M != csm.numMics())
+	{
+		return false;
+	}
+
+	// Parseval for a real signal: bins strictly between DC and Nyquist count twice.
+	// Dividing by M^2 makes w = a / M, the average of the aligned mics.
+	// The diagonal (|a_i| = 1) adds the same power to every pixel.
+	std::vector<double> binWeights(csm.numBins());
+	double diagonalPower = 0;
+	for (size_t b = 0; b < csm.numBins(); b++)
+	{
+		const size_t k = csm.binIndex(b);
+		const double twoSided = k == 0 || 2 * k == csm.frameSize() ? 1 : 2;
+		binWeights[b] = twoSided / (csm.frameSize() * csm.windowPower() * M * M);
+		for (size_t i = 0; i < M && !removeDiagonal; i++)
+		{
+			diagonalPower += binWeights[b] * csm.diagonal(b)[i];
+		}
+	}
+
+	// Phase k*d of a bin, in cycles per meter
+	const double cyclesPerMeterPerBin = double(csm.samplerate()) / csm.frameSize() / speedOfSound;
+	SegmentKernel::Function kernel = SegmentKernel::select(getFieldKernelIsa());
+	const size_t segments = (xvals.size() + segmentSize - 1) / segmentSize;
+
+	img.resize(xvals.size(), yvals.size());
+	pool.parallelFor(yvals.size() * segments, [&](size_t job)
+	{
+		const size_t y = job / segments;
+		const size_t x0 = (job % segments) * segmentSize;
+		const size_t count = std::min(segmentSize, xvals.size() - x0);
+
+		// Unused pixels of the last segment keep distance 0
+		Steering steering(M);
+		for (size_t i = 0; i < M; i++)
+		{
+			for (size_t px = 0; px < count; px++)
+			{
+				steering.d[i * segmentSize + px] = Pos(xvals[x0 + px], yvals[y], z).dist(mics[i].pos);
+			}
+		}
+
+		double* dst = img.row(y) + x0;
+		kernel(csm, binWeights.data(), cyclesPerMeterPerBin, count, steering, dst);
+		for (size_t px = 0; px < count; px++)
+		{
+			dst[px] = std::sqrt(std::max(diagonalPower + dst[px], 0.0));
+		}
+	});
+	return true;
+}
@@ -0,0 +1,102 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include "AlignedAllocator.hpp"
+#include "FieldBuffer.hpp"
+#include "Recording.hpp"
+#include "Transducer.hpp"
+#include "WorkerPool.hpp"
+
+#include <complex>
+#include <string>
+#include <vector>
+
+
+struct CrossSpectralSettings {
+	size_t frameSize = 1024;     //!< STFT frame length (a power of two); frames overlap by half
+	double minFrequency = 0;     //!< lowest frequency (Hz) included
+	double maxFrequency = 0;     //!< highest frequency (Hz) included, 0 means samplerate / 2
+};
+
+/** Parse "FLOW:FHIGH" (Hz) into the band of settings. */
+bool parseCrossSpectralBand(std::string const & arg, CrossSpectralSettings & settings);
+
+/**
+ * FFT bins of a settings.frameSize frame at samplerate which fall in the band
+ * (at most up to Nyquist), as used by CrossSpectralMatrix::compute(). */
+std::vector<size_t> crossSpectralBins(CrossSpectralSettings const & settings, int samplerate);
+
+/**
+ * Cross-spectral matrix of a recording: for every STFT bin b in the band,
+ *
+ *   R[b]_ik = mean over frames of X_i[b] * conj(X_k[b])
+ *
+ * with X_i the Hann windowed spectrum of channel i. Each channel is
+ * transformed once (two real channels per complex FFT), in batches of frames
+ * so that memory does not grow with the recording length. R is Hermitian, so
+ * only the diagonal and the pairs i < k are stored.
+ */
+class CrossSpectralMatrix {
+	size_t numMics_;
+	size_t frameSize_;
+	int samplerate_;
+	size_t numFrames_;
+	double windowPower_;
+	std::vector<size_t> bins_;
+	AlignedVector<double> diagonal_;   // per bin, R_ii of every mic
+	AlignedVector<double> re_, im_;    // per bin, R_ik for i < k, row major
+
+public:
+	CrossSpectralMatrix();
+
+	/**
+	 * @return false if the frame size is not a power of two, no bin falls in
+	 *         the band, or the recording is shorter than one frame. */
+	bool compute(Recording const & recording, CrossSpectralSettings const & settings, WorkerPool & pool);
+
+	size_t numMics() const { return numMics_; }
+	size_t numBins() const { return bins_.size(); }
+	size_t numFrames() const { return numFrames_; }
+	size_t frameSize() const { return frameSize_; }
+	int samplerate() const { return samplerate_; }
+
+	/** FFT bin index of the b:th stored bin. */
+	size_t binIndex(size_t b) const { return bins_[b]; }
+	double binFrequency(size_t b) const { return double(bins_[b]) * samplerate_ / frameSize_; }
+
+	/** Sum of the squared window, for converting spectral power back to signal power. */
+	double windowPower() const { return windowPower_; }
+
+	/** R[b]_ik for any i, k. */
+	std::complex<double> at(size_t b, size_t i, size_t k) const;
+
+	double const * diagonal(size_t b) const { return diagonal_.data() + b * numMics_; }
+	double const * pairsRe(size_t b) const { return re_.data() + b * numPairs(); }
+	double const * pairsIm(size_t b) const { return im_.data() + b * numPairs(); }
+	size_t numPairs() const { return numMics_ * (numMics_ - 1) / 2; }
+};
+
+/**
+ * Frequency domain (steered response power) acoustic camera: for every pixel
+ * and bin, the power w^H R w of the beam steered at the pixel, with w_i the
+ * phase of the getPhasors() phasor of mic i (as 1 / numMics weights).
+ * The pixel is the rms of the beam summed over the band, on the same scale as
+ * DelayAndSum.
+ *
+ * Cost is pixels * bins * mics^2 / 2, independent of the recording length.
+ * @param removeDiagonal leave out the auto spectra R_ii (uncorrelated mic
+ *        noise); the power is then clamped to zero where it becomes negative.
+ * @return false if mics does not match the matrix. */
+bool beamformCrossSpectral(
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		CrossSpectralMatrix const & csm,
+		const std::vector<Transducer>& mics,
+		const double speedOfSound,
+		bool removeDiagonal,
+		FieldBuffer & img,
+		WorkerPool & pool);
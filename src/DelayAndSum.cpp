@@ -0,0 +1,261 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "DelayAndSum.hpp"
+#include "FieldKernel.hpp"
+#include "FieldKernelSimd.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace {
+	/** Samples per beam chunk: the recording chunk then stays in L1 while a row of pixels is summed. */
+	const size_t chunkSize = 1024;
+
+	/** Mics summed in registers per pass over the beam. */
+	const size_t micsPerPass = 8;
+
+	/** Independent partial sums, so the power sum vectorizes. */
+	const size_t lanes = 16;
+
+	/**
+	 * Add G interpolated, delayed channels to the beam. The first pass starts from
+	 * zero instead of reading the beam, and the last one returns the beam power
+	 * instead of storing it, so with at most micsPerPass mics the beam never
+	 * leaves the registers. */
+	template <size_t G, bool First, bool Last>
+	inline __attribute__((always_inline))
+	double addMics(float const * const * x, float const * w0, float const * w1, size_t count, float* __restrict beam)
+	{
+		float partial[lanes] = { 0 };
+		const size_t full = count / lanes * lanes;
+		for (size_t j = 0; j < full; j += lanes)
+		{
+			for (size_t l = 0; l < lanes; l++)
+			{
+				float b = First ? 0.0f : beam[j + l];
+#pragma GCC unroll 8
+				for (size_t g = 0; g < G; g++)
+				{
+					b += w0[g] * x[g][j + l] + w1[g] * x[g][j + l + 1];
+				}
+				if (Last)
+				{
+					partial[l] += b * b;
+				}
+				else
+				{
+					beam[j + l] = b;
+				}
+			}
+		}
+
+		double power = 0;
+		for (size_t j = full; j < count; j++)
+		{
+			float b = First ? 0.0f : beam[j];
+			for (size_t g = 0; g < G; g++)
+			{
+				b += w0[g] * x[g][j] + w1[g] * x[g][j + 1];
+			}
+			if (Last)
+			{
+				power += b * b;
+			}
+			else
+			{
+				beam[j] = b;
+			}
+		}
+
+		for (size_t l = 0; l < lanes; l++)
+		{
+			power += partial[l];
+		}
+		return power;
+	}
+
+	template <size_t G>
+	inline __attribute__((always_inline))
+	double lastPass(bool first, float const * const * x, float const * w0, float const * w1, size_t count, float* beam)
+	{
+		return first ? addMics<G, true, true>(x, w0, w1, count, beam) : addMics<G, false, true>(x, w0, w1, count, beam);
+	}
+
+	/** Sum of the squared beam of one pixel over count samples; x, w0 and w1 hold one entry per mic. */
+	inline __attribute__((always_inline))
+	double beamPower(size_t numMics, float const * const * x, float const * w0, float const * w1, size_t count, float* beam)
+	{
+		size_t i = 0;
+		for (; i + micsPerPass < numMics; i += micsPerPass)
+		{
+			if (i == 0)
+			{
+				addMics<micsPerPass, true, false>(x, w0, w1, count, beam);
+			}
+			else
+			{
+				addMics<micsPerPass, false, false>(x + i, w0 + i, w1 + i, count, beam);
+			}
+		}
+
+		const bool first = i == 0;
+		x += i;
+		w0 += i;
+		w1 += i;
+		switch (numMics - i)
+		{
+		case 1: return lastPass<1>(first, x, w0, w1, count, beam);
+		case 2: return lastPass<2>(first, x, w0, w1, count, beam);
+		case 3: return lastPass<3>(first, x, w0, w1, count, beam);
+		case 4: return lastPass<4>(first, x, w0, w1, count, beam);
+		case 5: return lastPass<5>(first, x, w0, w1, count, beam);
+		case 6: return lastPass<6>(first, x, w0, w1, count, beam);
+		case 7: return lastPass<7>(first, x, w0, w1, count, beam);
+		default: return lastPass<8>(first, x, w0, w1, count, beam);
+		}
+	}
+
+	/** Per job scratch: channel pointers and interpolation weights of the current pixel. */
+	struct PixelTaps {
+		std::vector<float const *> x;
+		AlignedVector<float> w0, w1;
+		AlignedVector<float> beam;
+
+		explicit PixelTaps(size_t numMics) : x(numMics), w0(numMics), w1(numMics), beam(chunkSize) {}
+	};
+
+	/** Beam power summed over [n0, n0 + count) for each of a row of pixels. */
+	struct RowKernel {
+		typedef void (*Function)(Recording const &, size_t, size_t, size_t, size_t,
+				int32_t const *, float const *, PixelTaps &, double*);
+
+		static inline __attribute__((always_inline))
+		void run(Recording const & recording, size_t numMics, size_t width, size_t n0, size_t count,
+				int32_t const * offsets, float const * fractions, PixelTaps & taps, double* power)
+		{
+			for (size_t px = 0; px < width; px++)
+			{
+				for (size_t i = 0; i < numMics; i++)
+				{
+					taps.x[i] = recording.channel(i) + n0 + offsets[px * numMics + i];
+					taps.w1[i] = fractions[px * numMics + i];
+					taps.w0[i] = 1.0f - taps.w1[i];
+				}
+				power[px] += beamPower(numMics, taps.x.data(), taps.w0.data(), taps.w1.data(), count, taps.beam.data());
+			}
+		}
+
+		static void generic(Recording const & recording, size_t numMics, size_t width, size_t n0, size_t count,
+				int32_t const * offsets, float const * fractions, PixelTaps & taps, double* power)
+		{
+			run(recording, numMics, width, n0, count, offsets, fractions, taps, power);
+		}
+
+#if FIELD_KERNEL_HAVE_X86_SIMD
+		__attribute__((target("avx2,fma")))
+		static void avx2(Recording const & recording, size_t numMics, size_t width, size_t n0, size_t count,
+				int32_t const * offsets, float const * fractions, PixelTaps & taps, double* power)
+		{
+			run(recording, numMics, width, n0, count, offsets, fractions, taps, power);
+		}
+
+		__attribute__((target("avx512f")))
+		static void avx512(Recording const & recording, size_t numMics, size_t width, size_t n0, size_t count,
+				int32_t const * offsets, float const * fractions, PixelTaps & taps, double* power)
+		{
+			run(recording, numMics, width, n0, count, offsets, fractions, taps, power);
+		}
+#endif
+
+		static Function select(FieldKernelIsa isa)
+		{
+			switch (isa)
+			{
+#if FIELD_KERNEL_HAVE_X86_SIMD
+			case FieldKernelIsa::AVX2: return &avx2;
+			case FieldKernelIsa::AVX512: return &avx512;
+#endif
+			default: return &generic;
+			}
+		}
+	};
+}
+
+DelayAndSum::DelayAndSum(
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		const std::vector<Transducer>& mics,
+		int samplerate,
+		double speedOfSound)
+: width_(xvals.size()),
+	height_(yvals.size()),
+	numMics_(mics.size()),
+	samplerate_(samplerate),
+	maxOffset_(0),
+	offsets_(xvals.size() * yvals.size() * mics.size()),
+	fractions_(xvals.size() * yvals.size() * mics.size())
+{
+	const double samplesPerMeter = samplerate / speedOfSound;
+	std::vector<double> d(numMics_);
+
+	for (size_t y = 0; y < yvals.size(); y++)
+	{
+		for (size_t x = 0; x < xvals.size(); x++)
+		{
+			const Pos pixel(xvals[x], yvals[y], z);
+			for (size_t i = 0; i < numMics_; i++)
+			{
+				d[i] = pixel.dist(mics[i].pos);
+			}
+			const double nearest = numMics_ ? *std::min_element(d.begin(), d.end()) : 0;
+
+			const size_t base = (y * xvals.size() + x) * numMics_;
+			for (size_t i = 0; i < numMics_; i++)
+			{
+				double delay = (d[i] - nearest) * samplesPerMeter;
+				double whole = std::floor(delay);
+				offsets_[base + i] = int32_t(whole);
+				fractions_[base + i] = float(delay - whole);
+				maxOffset_ = std::max(maxOffset_, size_t(whole));
+			}
+		}
+	}
+}
+
+bool DelayAndSum::image(Recording const & recording, FieldBuffer & img, WorkerPool & pool) const
+{
+	if (recording.numChannels() != numMics_ || recording.samplerate() != samplerate_ ||
+			recording.numSamples() <= maxDelay() || numMics_ == 0)
+	{
+		return false;
+	}
+
+	// The same number of samples for every pixel, so that they are comparable
+	const size_t beamLength = recording.numSamples() - maxDelay();
+	RowKernel::Function kernel = RowKernel::select(getFieldKernelIsa());
+
+	img.resize(width_, height_);
+	pool.parallelFor(height_, [&](size_t y)
+	{
+		PixelTaps taps(numMics_);
+		double* power = img.row(y);
+		std::fill(power, power + width_, 0.0);
+
+		int32_t const * offsets = offsets_.data() + y * width_ * numMics_;
+		float const * fractions = fractions_.data() + y * width_ * numMics_;
+		for (size_t n0 = 0; n0 < beamLength; n0 += chunkSize)
+		{
+			kernel(recording, numMics_, width_, n0, std::min(chunkSize, beamLength - n0), offsets, fractions, taps, power);
+		}
+
+		for (int x = 0; x < width_; x++)
+		{
+			power[x] = std::sqrt(power[x] / beamLength) / numMics_;
+		}
+	});
+	return true;
+}
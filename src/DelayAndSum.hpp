@@ -0,0 +1,56 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include "AlignedAllocator.hpp"
+#include "FieldBuffer.hpp"
+#include "Recording.hpp"
+#include "Transducer.hpp"
+#include "WorkerPool.hpp"
+
+#include <cstdint>
+#include <vector>
+
+
+/**
+ * Time domain delay-and-sum acoustic camera: images a multichannel recording
+ * over the same wall grid as renderSoundOnWall().
+ *
+ * For every pixel the channels are shifted by the propagation delay from that
+ * point to each mic (relative to the nearest mic) and averaged. The pixel is
+ * the rms of that beam over the recording, so sources on the wall show up as
+ * peaks. Fractional delays use linear interpolation between samples.
+ *
+ * The integer and fractional delay of every (pixel, mic) pair is computed
+ * once, in the constructor, so one DelayAndSum can image many recordings
+ * (blocks) from the same array.
+ */
+class DelayAndSum {
+	int width_;
+	int height_;
+	size_t numMics_;
+	int samplerate_;
+	size_t maxOffset_;
+	AlignedVector<int32_t> offsets_;    // per pixel, numMics_ integer delays (samples)
+	AlignedVector<float> fractions_;    // per pixel, numMics_ fractional delays in [0, 1)
+
+public:
+	DelayAndSum(
+			const std::vector<double>& xvals,
+			const std::vector<double>& yvals,
+			double z,
+			const std::vector<Transducer>& mics,
+			int samplerate,
+			double speedOfSound);
+
+	/** Largest delay (in whole samples) of any pixel: the beams are this much shorter than the recording. */
+	size_t maxDelay() const { return maxOffset_ + 1; }
+
+	/**
+	 * Image recording (one channel per mic, at the samplerate of the constructor) into img.
+	 * @return false if the channel count or samplerate does not match, or the
+	 *         recording is not longer than maxDelay(). */
+	bool image(Recording const & recording, FieldBuffer & img, WorkerPool & pool) const;
+};
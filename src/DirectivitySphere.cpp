@@ -0,0 +1,186 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "DirectivitySphere.hpp"
+#include "FieldKernel.hpp"
+#include "RenderSound.hpp"
+#include "StringParse.hpp"
+#include "TransducerBlock.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+
+namespace {
+	const char sphereMagic[8] = "ACSPHR1";
+
+	/** Directions evaluated per job */
+	const size_t directionsPerJob = 1024;
+
+	template<class T>
+	void writeRaw(std::ofstream & out, T const & value)
+	{
+		out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+	}
+
+	template<class T>
+	void readRaw(std::ifstream & in, T & value)
+	{
+		in.read(reinterpret_cast<char*>(&value), sizeof(value));
+	}
+}
+
+Pos SphereGrid::direction(size_t i) const
+{
+	double theta, phi;
+	if (sampling == SphereSampling::THETA_PHI)
+	{
+		theta = M_PI * double(i / nPhi) / (nTheta - 1);
+		phi = 2 * M_PI * double(i % nPhi) / nPhi;
+	}
+	else
+	{
+		theta = std::acos(1 - (2 * double(i) + 1) / count);
+		phi = double(i) * M_PI * (3 - std::sqrt(5.0));
+	}
+	return Pos(std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta));
+}
+
+SphereGrid thetaPhiSphere(int nTheta, int nPhi)
+{
+	SphereGrid grid;
+	grid.sampling = SphereSampling::THETA_PHI;
+	grid.nTheta = nTheta;
+	grid.nPhi = nPhi;
+	grid.count = nTheta * nPhi;
+	return grid;
+}
+
+SphereGrid fibonacciSphere(int count)
+{
+	SphereGrid grid;
+	grid.sampling = SphereSampling::FIBONACCI;
+	grid.nTheta = 0;
+	grid.nPhi = 0;
+	grid.count = count;
+	return grid;
+}
+
+bool parseSphereGrid(std::string const & spec, SphereGrid & grid)
+{
+	const std::string gridPrefix = "grid:";
+	const std::string fibonacciPrefix = "fibonacci:";
+
+	if (spec.compare(0, gridPrefix.size(), gridPrefix) == 0)
+	{
+		// Exactly two fields, so that e.g. "grid:3:4:" is rejected
+		const std::string rest = spec.substr(gridPrefix.size());
+		const size_t colon = rest.find(':');
+		int nTheta, nPhi;
+		if (colon == std::string::npos ||
+			!parseInt(rest.substr(0, colon), nTheta) || !parseInt(rest.substr(colon + 1), nPhi) ||
+			nTheta < 2 || nPhi < 1 || nTheta > maxSphereDirections / nPhi)
+		{
+			return false;
+		}
+		grid = thetaPhiSphere(nTheta, nPhi);
+		return true;
+	}
+	if (spec.compare(0, fibonacciPrefix.size(), fibonacciPrefix) == 0)
+	{
+		int count;
+		if (!parseInt(spec.substr(fibonacciPrefix.size()), count) || count < 1 || count > maxSphereDirections)
+		{
+			return false;
+		}
+		grid = fibonacciSphere(count);
+		return true;
+	}
+	return false;
+}
+
+void computeDirectivitySphere(
+		SphereGrid const & grid,
+		double radius,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		DirectivitySphere & sphere,
+		WorkerPool & pool)
+{
+	TransducerBlock block(transducers);
+	sphere.grid = grid;
+	sphere.audioFrequency = audioFrequency;
+	sphere.radius = radius;
+	sphere.speedOfSound = speedOfSound;
+	sphere.rms.resize(grid.count);
+
+	const size_t count = grid.count;
+	const size_t numJobs = (count + directionsPerJob - 1) / directionsPerJob;
+	pool.parallelFor(numJobs, [&](size_t job)
+	{
+		size_t end = std::min(count, (job + 1) * directionsPerJob);
+		for (size_t i = job * directionsPerJob; i < end; i++)
+		{
+			Pos listenerPos = grid.direction(i) * radius;
+			sphere.rms[i] = float(phasorToRms(accumulateField(block, listenerPos, audioFrequency, speedOfSound)));
+		}
+	});
+}
+
+bool writeDirectivitySphere(std::string const & filename, DirectivitySphere const & sphere)
+{
+	std::ofstream out(filename, std::ios::binary);
+	out.write(sphereMagic, sizeof(sphereMagic));
+	writeRaw(out, uint32_t(sphere.grid.sampling));
+	writeRaw(out, uint32_t(sphere.grid.nTheta));
+	writeRaw(out, uint32_t(sphere.grid.nPhi));
+	writeRaw(out, uint32_t(sphere.grid.count));
+	writeRaw(out, sphere.audioFrequency);
+	writeRaw(out, sphere.radius);
+	writeRaw(out, sphere.speedOfSound);
+	out.write(reinterpret_cast<const char*>(sphere.rms.data()), sphere.rms.size() * sizeof(float));
+	return bool(out);
+}
+
+bool readDirectivitySphere(std::string const & filename, DirectivitySphere & sphere)
+{
+	std::ifstream in(filename, std::ios::binary);
+	char magic[sizeof(sphereMagic)];
+	in.read(magic, sizeof(magic));
+	if (!in || memcmp(magic, sphereMagic, sizeof(magic)) != 0)
+	{
+		return false;
+	}
+
+	uint32_t sampling, nTheta, nPhi, count;
+	readRaw(in, sampling);
+	readRaw(in, nTheta);
+	readRaw(in, nPhi);
+	readRaw(in, count);
+	readRaw(in, sphere.audioFrequency);
+	readRaw(in, sphere.radius);
+	readRaw(in, sphere.speedOfSound);
+	if (!in || sampling > uint32_t(SphereSampling::FIBONACCI) || count < 1 || count > uint32_t(maxSphereDirections))
+	{
+		return false;
+	}
+	// Same grids as parseSphereGrid() accepts, so that direction() is defined for every rms value
+	if (sampling == uint32_t(SphereSampling::THETA_PHI)
+		? nTheta < 2 || nPhi < 1 || uint64_t(nTheta) * nPhi != count
+		: nTheta != 0 || nPhi != 0)
+	{
+		return false;
+	}
+
+	sphere.grid.sampling = SphereSampling(sampling);
+	sphere.grid.nTheta = nTheta;
+	sphere.grid.nPhi = nPhi;
+	sphere.grid.count = count;
+	sphere.rms.resize(count);
+	in.read(reinterpret_cast<char*>(sphere.rms.data()), count * sizeof(float));
+	return bool(in);
+}
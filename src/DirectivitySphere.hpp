@@ -0,0 +1,91 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include "Pos.hpp"
+#include "Transducer.hpp"
+#include "WorkerPool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+/** How the directions of a directivity sphere are sampled. */
+enum class SphereSampling : uint32_t {
+	THETA_PHI = 0,   //!< regular grid in polar angle theta and azimuth phi
+	FIBONACCI = 1,   //!< Fibonacci spiral, (almost) equal area per direction
+};
+
+/**
+ * Set of directions on the unit sphere, described by a few numbers so that
+ * the directions never have to be stored.
+ *
+ * THETA_PHI: direction t * nPhi + p has theta = pi * t / (nTheta - 1) (from +z,
+ * the direction towards the wall, both poles included) and phi = 2*pi * p / nPhi
+ * (from +x towards +y).
+ *
+ * FIBONACCI: direction i has z = 1 - (2i + 1) / count and phi = i * pi * (3 - sqrt(5)).
+ */
+struct SphereGrid {
+	SphereSampling sampling;
+	int nTheta;
+	int nPhi;
+	int count;   //!< number of directions
+
+	/** Unit vector of direction i (0 <= i < count). */
+	Pos direction(size_t i) const;
+};
+
+/** Largest number of directions in a sphere (1 GiB of rms values). */
+const int maxSphereDirections = 1 << 28;
+
+/** nTheta >= 2, nPhi >= 1 and nTheta * nPhi <= maxSphereDirections, as checked by parseSphereGrid() */
+SphereGrid thetaPhiSphere(int nTheta, int nPhi);
+SphereGrid fibonacciSphere(int count);
+
+/**
+ * Parse "grid:NTHETA:NPHI" or "fibonacci:N".
+ * @returns false on malformed input, or more than maxSphereDirections directions */
+bool parseSphereGrid(std::string const & spec, SphereGrid & grid);
+
+/** Array response over a sphere of directions, at one frequency. */
+struct DirectivitySphere {
+	SphereGrid grid;
+	double audioFrequency;
+	double radius;          //!< distance from the origin at which the field was evaluated
+	double speedOfSound;
+	std::vector<float> rms; //!< rms value in every direction of grid
+};
+
+/**
+ * Evaluate the field at radius * grid.direction(i) for every direction, with
+ * the directions split over the threads in pool. sphere.rms is reused if it
+ * already has the right size. */
+void computeDirectivitySphere(
+		SphereGrid const & grid,
+		double radius,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		DirectivitySphere & sphere,
+		WorkerPool & pool);
+
+/**
+ * Write a sphere as a compact binary file (native byte order):
+ *
+ *   char[8] "ACSPHR1"   (zero terminated)
+ *   uint32  sampling, nTheta, nPhi, count
+ *   float64 audioFrequency, radius, speedOfSound
+ *   float32 rms[count]
+ *
+ * @returns false if the file could not be written */
+bool writeDirectivitySphere(std::string const & filename, DirectivitySphere const & sphere);
+
+/**
+ * @returns false if the file could not be read, is not a sphere file, or
+ *          its grid is not one parseSphereGrid() would accept */
+bool readDirectivitySphere(std::string const & filename, DirectivitySphere & sphere);
@@ -0,0 +1,262 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "DistanceTable.hpp"
+#include "Fnv1a.hpp"
+#include "Pos.hpp"
+#include "SinCos.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+
+namespace {
+	const char tableMagic[8] = "ACDIST1";
+
+	/** File header, padded so that the float arrays after it stay cache line aligned. */
+	struct TableHeader {
+		char magic[8];
+		uint64_t key;
+		uint64_t width;
+		uint64_t height;
+		uint64_t mics;
+		uint64_t stride;
+		uint64_t reserved[2];
+	};
+	static_assert(sizeof(TableHeader) == 64, "header must keep the arrays aligned");
+}
+
+DistanceTable::DistanceTable()
+: width_(0),
+	height_(0),
+	mics_(0),
+	stride_(0),
+	key_(0),
+	mapping_(nullptr),
+	mappingSize_(0),
+	distance_(nullptr),
+	amplitude_(nullptr)
+{
+	// no code
+}
+
+DistanceTable::~DistanceTable()
+{
+	unmap();
+}
+
+void DistanceTable::unmap()
+{
+	if (mapping_)
+	{
+		munmap(mapping_, mappingSize_);
+		mapping_ = nullptr;
+		mappingSize_ = 0;
+	}
+}
+
+void DistanceTable::build(
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		const std::vector<Transducer>& transducers,
+		WorkerPool & pool)
+{
+	unmap();
+	width_ = xvals.size();
+	height_ = yvals.size();
+	mics_ = transducers.size();
+	stride_ = (mics_ + micAlignment - 1) / micAlignment * micAlignment;
+	key_ = distanceTableKey(xvals, yvals, z, transducers);
+
+	const size_t plane = width_ * height_ * stride_;
+	storage_.assign(2 * plane, 0.0f);
+	float* distance = storage_.data();
+	float* amplitude = storage_.data() + plane;
+	distance_ = distance;
+	amplitude_ = amplitude;
+
+	pool.parallelFor(height_, [&](size_t yind)
+	{
+		for (size_t xind = 0; xind < width_; xind++)
+		{
+			Pos listenerPos(xvals[xind], yvals[yind], z);
+			const double reference = listenerPos.dist(transducers[0].pos);
+			const size_t offset = (yind * width_ + xind) * stride_;
+			for (size_t j = 0; j < mics_; j++)
+			{
+				double d = listenerPos.dist(transducers[j].pos);
+				distance[offset + j] = float(d - reference);
+				amplitude[offset + j] = float(1.0 / sqr(d));
+			}
+		}
+	});
+}
+
+bool DistanceTable::save(std::string const & filename) const
+{
+	TableHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, tableMagic, sizeof(header.magic));
+	header.key = key_;
+	header.width = width_;
+	header.height = height_;
+	header.mics = mics_;
+	header.stride = stride_;
+
+	// Write to a temporary name first, so that a concurrent map() never sees a partial file.
+	// The name is unique per process and call, so concurrent saves never write the same file.
+	static std::atomic<unsigned> counter(0);
+	const std::string temporary = filename + "." + std::to_string(getpid()) + "." + std::to_string(counter++) + ".tmp";
+	{
+		const size_t plane = width_ * height_ * stride_;
+		std::ofstream out(temporary, std::ios::binary);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(reinterpret_cast<const char*>(distance_), plane * sizeof(float));
+		out.write(reinterpret_cast<const char*>(amplitude_), plane * sizeof(float));
+		if (!out)
+		{
+			remove(temporary.c_str());
+			return false;
+		}
+	}
+	return rename(temporary.c_str(), filename.c_str()) == 0;
+}
+
+bool DistanceTable::map(std::string const & filename, uint64_t expectedKey)
+{
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	struct stat st;
+	void* mapping = MAP_FAILED;
+	if (fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(TableHeader))
+	{
+		mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	}
+	close(fd);
+	if (mapping == MAP_FAILED)
+	{
+		return false;
+	}
+
+	TableHeader const * header = static_cast<TableHeader const *>(mapping);
+	const size_t plane = header->width * header->height * header->stride;
+	if (memcmp(header->magic, tableMagic, sizeof(tableMagic)) != 0 ||
+		header->key != expectedKey ||
+		size_t(st.st_size) != sizeof(TableHeader) + 2 * plane * sizeof(float))
+	{
+		munmap(mapping, st.st_size);
+		return false;
+	}
+
+	unmap();
+	storage_.clear();
+	storage_.shrink_to_fit();
+	mapping_ = mapping;
+	mappingSize_ = st.st_size;
+	key_ = header->key;
+	width_ = header->width;
+	height_ = header->height;
+	mics_ = header->mics;
+	stride_ = header->stride;
+	distance_ = reinterpret_cast<float const *>(header + 1);
+	amplitude_ = distance_ + plane;
+	return true;
+}
+
+uint64_t distanceTableKey(
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		const std::vector<Transducer>& transducers)
+{
+	Fnv1a hash;
+	uint64_t sizes[3] = { xvals.size(), yvals.size(), transducers.size() };
+	hash.add(sizes, sizeof(sizes));
+	hash.add(xvals.data(), xvals.size() * sizeof(double));
+	hash.add(yvals.data(), yvals.size() * sizeof(double));
+	hash.add(z);
+	for (Transducer const & t : transducers)
+	{
+		double pos[3] = { t.pos.x, t.pos.y, t.pos.z };
+		hash.add(pos, sizeof(pos));
+	}
+	return hash.value();
+}
+
+void loadOrBuildDistanceTable(
+		std::string const & directory,
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		const std::vector<Transducer>& transducers,
+		DistanceTable & table,
+		WorkerPool & pool)
+{
+	const uint64_t key = distanceTableKey(xvals, yvals, z, transducers);
+	char name[32];
+	snprintf(name, sizeof(name), "dist_%016llx.bin", (unsigned long long)key);
+	const std::string filename = directory + "/" + name;
+
+	if (!table.map(filename, key))
+	{
+		table.build(xvals, yvals, z, transducers, pool);
+		table.save(filename);
+	}
+}
+
+void renderSoundOnWall(
+		DistanceTable const & table,
+		double audioFrequency,
+		const double speedOfSound,
+		FieldBuffer & img,
+		WorkerPool & pool)
+{
+	const double k = 2 * M_PI * audioFrequency / speedOfSound;
+	const size_t stride = table.stride();
+	img.resize(table.width(), table.height());
+
+	pool.parallelFor(table.height(), [&](size_t yind)
+	{
+		AlignedVector<double> re(stride);
+		AlignedVector<double> im(stride);
+		double* __restrict pRe = re.data();
+		double* __restrict pIm = im.data();
+		double* dst = img.row(yind);
+
+		for (size_t xind = 0; xind < table.width(); xind++)
+		{
+			float const * __restrict distance = table.distance(xind, yind);
+			float const * __restrict amplitude = table.amplitude(xind, yind);
+			for (size_t j = 0; j < stride; j++)
+			{
+				double s, c;
+				sinCos(k * distance[j], s, c);
+				pRe[j] = amplitude[j] * c;
+				pIm[j] = amplitude[j] * s;
+			}
+
+			double sumRe = 0;
+			double sumIm = 0;
+			for (size_t j = 0; j < stride; j++)
+			{
+				sumRe += pRe[j];
+				sumIm += pIm[j];
+			}
+			dst[xind] = 1.0 / sqrt(2.0) * std::sqrt(sqr(sumRe) + sqr(sumIm));
+		}
+	});
+}
@@ -0,0 +1,124 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include "AlignedAllocator.hpp"
+#include "FieldBuffer.hpp"
+#include "Transducer.hpp"
+#include "WorkerPool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+/**
+ * Frequency independent part of renderSoundOnWall() for one (array, wall grid)
+ * pair: for every pixel and transducer, the amplitude 1/d^2 and the distance d.
+ *
+ * Stored as two float32 arrays (structure of arrays), pixel major, with the
+ * transducers padded to a multiple of 16 (one cache line) with amplitude 0.
+ * Distances are stored relative to the distance from the pixel to the first
+ * transducer. That only rotates the summed phasor (the rms value is unchanged),
+ * and keeps the float32 rounding of the phase below k * 3e-8 radians.
+ *
+ * The table is either built in memory, or memory mapped from a file written
+ * by save(), so repeated sweeps over the same geometry skip the distance
+ * computation entirely.
+ */
+class DistanceTable {
+	size_t width_;
+	size_t height_;
+	size_t mics_;
+	size_t stride_;
+	uint64_t key_;
+
+	AlignedVector<float> storage_;   // built tables: distances, then amplitudes
+	void* mapping_;                  // mapped tables: the whole file
+	size_t mappingSize_;
+
+	float const * distance_;
+	float const * amplitude_;
+
+	void unmap();
+public:
+	/** Transducers per pixel are padded to a multiple of this. */
+	static const size_t micAlignment = 16;
+
+	DistanceTable();
+	~DistanceTable();
+
+	DistanceTable(DistanceTable const &) = delete;
+	DistanceTable& operator=(DistanceTable const &) = delete;
+
+	/** Compute the table in memory (rows split over pool). */
+	void build(
+			const std::vector<double>& xvals,
+			const std::vector<double>& yvals,
+			double z,
+			const std::vector<Transducer>& transducers,
+			WorkerPool & pool);
+
+	/**
+	 * Write the table to a file, which can later be mapped with map().
+	 * @returns false if the file could not be written */
+	bool save(std::string const & filename) const;
+
+	/**
+	 * Memory map a file written by save(). The file must stay unchanged while mapped.
+	 * @param expectedKey distanceTableKey() of the geometry the caller wants
+	 * @returns false if the file is missing, broken or for another geometry */
+	bool map(std::string const & filename, uint64_t expectedKey);
+
+	bool isMapped() const { return mapping_ != nullptr; }
+
+	size_t width() const { return width_; }
+	size_t height() const { return height_; }
+	size_t numTransducers() const { return mics_; }
+
+	/** Number of floats per pixel (numTransducers() rounded up to micAlignment). */
+	size_t stride() const { return stride_; }
+
+	/** distanceTableKey() of the geometry the table was built for. */
+	uint64_t key() const { return key_; }
+
+	/** stride() relative distances for pixel (x, y) */
+	float const * distance(size_t x, size_t y) const { return distance_ + (y * width_ + x) * stride_; }
+
+	/** stride() amplitudes 1/d^2 for pixel (x, y), 0 for padding */
+	float const * amplitude(size_t x, size_t y) const { return amplitude_ + (y * width_ + x) * stride_; }
+};
+
+/** Hash (64 bit FNV-1a) identifying an (array, wall grid) pair. */
+uint64_t distanceTableKey(
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		const std::vector<Transducer>& transducers);
+
+/**
+ * Map the table for this geometry from directory, or build it and save it there
+ * (as dist_<key>.bin) for the next run. Saving is best effort: the built table
+ * is usable even if it could not be written. */
+void loadOrBuildDistanceTable(
+		std::string const & directory,
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		const std::vector<Transducer>& transducers,
+		DistanceTable & table,
+		WorkerPool & pool);
+
+/**
+ * renderSoundOnWall() using a precomputed table, so only the phases
+ * (one vectorized sin/cos per pixel and transducer) are computed.
+ * The result is within ~1e-6 (relative) of renderSoundOnWall(). */
+void renderSoundOnWall(
+		DistanceTable const & table,
+		double audioFrequency,
+		const double speedOfSound,
+		FieldBuffer & img,
+		WorkerPool & pool);
@@ -3,6 +3,35 @@
 //
 
 #include "FakePointSoundSource.hpp"
+#include "SinCos.hpp"
+
+#include <algorithm>
+
+namespace {
+    /** Samples per block sharing one starting phasor. */
+    const size_t blockSize = 64;
+
+    /** exp(i * 2 pi * cycles), with cycles first reduced to [0, 1) for accuracy. */
+    void phasorOfCycles(double cycles, double & s, double & c)
+    {
+        cycles -= std::floor(cycles);
+        sinCos(2 * M_PI * cycles, s, c);
+    }
+
+    /**
+     * Fractional part of freq * n / samplerate. Exact also for n far into the
+     * signal: n is split into whole seconds q and a remainder r, and the
+     * rounding error of freq * q is recovered with an fma. */
+    double cyclesAtSample(double freq, int samplerate, int64_t n)
+    {
+        int64_t q = n / samplerate;
+        int64_t r = n % samplerate;
+        double p = freq * double(q);
+        double e = std::fma(freq, double(q), -p);
+        double cycles = (p - std::floor(p)) + e + freq * double(r) / samplerate;
+        return cycles - std::floor(cycles);
+    }
+}
 
 FakePointSoundSource::FakePointSoundSource(Pos const & pos, double amplitude, double freq, double phase, double speedOfSound)
 : pos_(pos),
@@ -16,28 +45,112 @@ FakePointSoundSource::FakePointSoundSource(Pos const & pos, double amplitude, do
 
 std::vector<double> FakePointSoundSource::getSamples(Pos const & listenerPos, int samplerate, int numSamples) const
 {
-    double distance =  pos_.dist(listenerPos);
+    std::vector<double> retval(numSamples);
+    getSamples(listenerPos, samplerate, 0, retval.data(), retval.size());
 
-    double t_distance = distance / speedOfSound_;
+    // TODO: is it the sound pressure we should use, which is proportional to 1/distance,
+    //       or sound intensity, which is proportional to 1/(distance*distance)
 
-    std::vector<double> retval(numSamples);
+    return retval;
+}
 
-    const double amplitude = getAmplitude(listenerPos);
+void FakePointSoundSource::getSamples(Pos const & listenerPos, int samplerate, int64_t firstSample, double* out, size_t numSamples) const
+{
+    getSamples(std::vector<Pos>(1, listenerPos), samplerate, firstSample, out, numSamples, SampleLayout::PLANAR);
+}
 
-    for (int i = 0; i < numSamples; i++)
+void FakePointSoundSource::getSamples(std::vector<Pos> const & listenerPositions, int samplerate, int64_t firstSample,
+        double* out, size_t numSamples, SampleLayout layout) const
+{
+    const size_t channels = listenerPositions.size();
+    std::fill(out, out + channels * numSamples, 0.0);
+    addSamples(getResponse(listenerPositions), 0, channels, samplerate, firstSample, out, numSamples, layout,
+            layout == SampleLayout::PLANAR ? numSamples : channels);
+}
+
+SourceResponse FakePointSoundSource::getResponse(std::vector<Pos> const & listenerPositions) const
+{
+    const size_t channels = listenerPositions.size();
+    SourceResponse response;
+    response.amplitude.resize(channels);
+    response.cycles.resize(channels);
+    for (size_t ch = 0; ch < channels; ch++)
     {
-        double t_sample = i * 1.0 / samplerate;
-        retval[i] = amplitude * sin(2 * M_PI * freq_ * (t_sample + t_distance) + phase_);
+        double t_distance = pos_.dist(listenerPositions[ch]) / speedOfSound_;
+        response.amplitude[ch] = getAmplitude(listenerPositions[ch]);
+        // Received as emitted t_distance earlier
+        response.cycles[ch] = phase_ / (2 * M_PI) - freq_ * t_distance;
+        response.cycles[ch] -= std::floor(response.cycles[ch]);
+    }
+    return response;
+}
+
+void FakePointSoundSource::addSamples(SourceResponse const & response, size_t ch0, size_t ch1, int samplerate,
+        int64_t firstSample, double* out, size_t numSamples, SampleLayout layout, size_t stride) const
+{
+    const size_t channels = ch1 - ch0;
+    const double cyclesPerSample = freq_ / samplerate;
 
-        // TODO: is it the sound pressure we should use, which is proportional to 1/distance,
-        //       or sound intensity, which is proportional to 1/(distance*distance)
+    // Rotation from the start of a block to each sample in it
+    AlignedVector<double> rotSin(blockSize);
+    AlignedVector<double> rotCos(blockSize);
+    for (size_t k = 0; k < blockSize; k++)
+    {
+        phasorOfCycles(cyclesPerSample * k, rotSin[k], rotCos[k]);
     }
 
-    return retval;
+    // Amplitude scaled starting phasor of each channel, for the current block
+    AlignedVector<double> startSin(channels);
+    AlignedVector<double> startCos(channels);
+
+    for (size_t n0 = 0; n0 < numSamples; n0 += blockSize)
+    {
+        const size_t count = std::min(blockSize, numSamples - n0);
+
+        // Exact phase at the block start
+        double blockCycles = cyclesAtSample(freq_, samplerate, firstSample + int64_t(n0));
+        for (size_t ch = 0; ch < channels; ch++)
+        {
+            double s, c;
+            phasorOfCycles(blockCycles + response.cycles[ch0 + ch], s, c);
+            startSin[ch] = response.amplitude[ch0 + ch] * s;
+            startCos[ch] = response.amplitude[ch0 + ch] * c;
+        }
+
+        // sin(a + b) = sin(a) cos(b) + cos(a) sin(b)
+        if (layout == SampleLayout::PLANAR)
+        {
+            for (size_t ch = 0; ch < channels; ch++)
+            {
+                double* __restrict dst = out + ch * stride + n0;
+                const double s = startSin[ch];
+                const double c = startCos[ch];
+                for (size_t k = 0; k < count; k++)
+                {
+                    dst[k] += s * rotCos[k] + c * rotSin[k];
+                }
+            }
+        }
+        else
+        {
+            double const * __restrict s = startSin.data();
+            double const * __restrict c = startCos.data();
+            for (size_t k = 0; k < count; k++)
+            {
+                double* __restrict dst = out + (n0 + k) * stride;
+                const double rc = rotCos[k];
+                const double rs = rotSin[k];
+                for (size_t ch = 0; ch < channels; ch++)
+                {
+                    dst[ch] += s[ch] * rc + c[ch] * rs;
+                }
+            }
+        }
+    }
 }
 
 double FakePointSoundSource::getAmplitude(Pos const & listenerPos) const
 {
     double distance = pos_.dist(listenerPos);
     return amplitude_ / (distance * distance);
-}
\ No newline at end of file
+}
@@ -4,12 +4,27 @@
 
 #pragma once
 
+#include "AlignedAllocator.hpp"
 #include "Pos.hpp"
 
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 
+/** Memory layout of multi channel sample buffers. */
+enum class SampleLayout {
+    PLANAR,      //!< all samples of channel 0, then all of channel 1, ...
+    INTERLEAVED  //!< channel 0..C-1 of sample 0, then of sample 1, ...
+};
+
+/** Gain, and phase at sample 0 (in cycles), of a source at a set of listener positions. */
+struct SourceResponse {
+    AlignedVector<double> amplitude;
+    AlignedVector<double> cycles;
+};
+
 class FakePointSoundSource {
 	Pos pos_;
 	double amplitude_;
@@ -17,9 +32,41 @@ class FakePointSoundSource {
 	double phase_;
     double speedOfSound_;
 public:
-    /** @param phase a phase shift (in radians) */
+    /**
+     * A source emitting amplitude * sin(2 pi freq t + phase), heard at distance d as
+     * amplitude / d^2 * sin(2 pi freq (t - d / speedOfSound) + phase).
+     * @param phase a phase shift (in radians) */
 	FakePointSoundSource(Pos const & pos, double amplitude, double freq, double phase, double speedOfSound);
 	std::vector<double> getSamples(Pos const & listenerPos, int samplerate, int numSamples) const;
 
+    /**
+     * Same samples as getSamples(), written to out[0, numSamples), starting at
+     * sample number firstSample, so that long signals can be synthesized block
+     * by block into a reused buffer. */
+    void getSamples(Pos const & listenerPos, int samplerate, int64_t firstSample, double* out, size_t numSamples) const;
+
+    /**
+     * getSamples() for every listener position (channel) in one pass.
+     * out holds numSamples * listenerPositions.size() samples, in layout.
+     *
+     * Without a sin() per sample: a table of the exact rotations within a
+     * block of samples is computed once, and each block of each channel only
+     * needs one exact (sin, cos) of its starting phase. Every sample is then
+     * the starting phasor rotated by a table entry, so the error does not grow
+     * with the signal length (~1e-16 relative). */
+    void getSamples(std::vector<Pos> const & listenerPositions, int samplerate, int64_t firstSample,
+            double* out, size_t numSamples, SampleLayout layout) const;
+
+    /** Precomputed propagation gain and delay to each listener position, for addSamples(). */
+    SourceResponse getResponse(std::vector<Pos> const & listenerPositions) const;
+
+    /**
+     * Add samples [firstSample, firstSample + numSamples) of channels [ch0, ch1)
+     * of response to out. Sample n of channel ch goes to out[(ch - ch0) * stride + n]
+     * (PLANAR) or out[n * stride + ch - ch0] (INTERLEAVED), so out can be a
+     * window into a larger recording. */
+    void addSamples(SourceResponse const & response, size_t ch0, size_t ch1, int samplerate, int64_t firstSample,
+            double* out, size_t numSamples, SampleLayout layout, size_t stride) const;
+
     double getAmplitude(Pos const & listenerPos) const;
 };
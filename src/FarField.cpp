@@ -0,0 +1,187 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "FarField.hpp"
+#include "AlignedAllocator.hpp"
+#include "Pos.hpp"
+
+#include <cmath>
+
+
+namespace {
+	/** |sum_{m=0}^{n-1} exp(-i*m*theta)| = |sin(n*theta/2) / sin(theta/2)| */
+	inline double axisMagnitude(int n, double theta)
+	{
+		double denominator = std::sin(0.5 * theta);
+		if (std::fabs(denominator) < 1e-9)
+		{
+			return n;
+		}
+		return std::fabs(std::sin(0.5 * n * theta) / denominator);
+	}
+}
+
+FarFieldArrayFactor::FarFieldArrayFactor(std::vector<Transducer> const & transducers, double audioFrequency, double speedOfSound)
+: transducers_(transducers),
+	k_(2 * M_PI * audioFrequency / speedOfSound),
+	separable_(false)
+{
+	separable_ = detectApertureGrid(transducers, grid_) && grid_.isFull();
+}
+
+std::complex<double> FarFieldArrayFactor::evaluate(double u, double v, double w) const
+{
+	double re = 0;
+	double im = 0;
+	for (Transducer const & t : transducers_)
+	{
+		double phase = -k_ * (u * t.pos.x + v * t.pos.y + w * t.pos.z);
+		re += cos(phase);
+		im += sin(phase);
+	}
+	return std::complex<double>(re, im);
+}
+
+double FarFieldArrayFactor::xMagnitude(double u) const
+{
+	return axisMagnitude(grid_.nx, k_ * grid_.dx * u);
+}
+
+double FarFieldArrayFactor::yMagnitude(double v) const
+{
+	return axisMagnitude(grid_.ny, k_ * grid_.dy * v);
+}
+
+double FarFieldArrayFactor::magnitude(double u, double v, double w) const
+{
+	if (separable_)
+	{
+		return xMagnitude(u) * yMagnitude(v);
+	}
+	return std::abs(evaluate(u, v, w));
+}
+
+void renderFarFieldOnWall(
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		FieldBuffer & img,
+		WorkerPool & pool)
+{
+	FarFieldArrayFactor af(transducers, audioFrequency, speedOfSound);
+	img.resize(xvals.size(), yvals.size());
+
+	pool.parallelFor(yvals.size(), [&](size_t yind)
+	{
+		double y = yvals[yind];
+		double* dst = img.row(yind);
+		for (size_t xind = 0; xind < xvals.size(); xind++)
+		{
+			double x = xvals[xind];
+			double R2 = sqr(x) + sqr(y) + sqr(z);
+			double R = std::sqrt(R2);
+			dst[xind] = 1.0 / sqrt(2.0) * af.magnitude(x / R, y / R, z / R) / R2;
+		}
+	});
+}
+
+void renderFarFieldDirections(
+		const std::vector<double>& uvals,
+		const std::vector<double>& vvals,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		FieldBuffer & img,
+		WorkerPool & pool)
+{
+	const size_t W = uvals.size();
+	const size_t H = vvals.size();
+	const size_t M = transducers.size();
+	const double k = 2 * M_PI * audioFrequency / speedOfSound;
+	img.resize(W, H);
+
+	auto visible = [&](size_t a, size_t b) { return sqr(uvals[a]) + sqr(vvals[b]) <= 1.0; };
+
+	FarFieldArrayFactor af(transducers, audioFrequency, speedOfSound);
+
+	if (af.isSeparable())
+	{
+		// A single outer product of the two per-axis factors
+		std::vector<double> ax(W);
+		std::vector<double> ay(H);
+		for (size_t a = 0; a < W; a++) { ax[a] = af.xMagnitude(uvals[a]); }
+		for (size_t b = 0; b < H; b++) { ay[b] = af.yMagnitude(vvals[b]); }
+
+		pool.parallelFor(H, [&](size_t b)
+		{
+			double* dst = img.row(b);
+			for (size_t a = 0; a < W; a++)
+			{
+				dst[a] = visible(a, b) ? 1.0 / sqrt(2.0) * ax[a] * ay[b] : 0.0;
+			}
+		});
+		return;
+	}
+
+	if (!isPlanar(transducers))
+	{
+		pool.parallelFor(H, [&](size_t b)
+		{
+			double* dst = img.row(b);
+			for (size_t a = 0; a < W; a++)
+			{
+				double w2 = 1.0 - sqr(uvals[a]) - sqr(vvals[b]);
+				dst[a] = w2 >= 0 ? 1.0 / sqrt(2.0) * af.magnitude(uvals[a], vvals[b], std::sqrt(w2)) : 0.0;
+			}
+		});
+		return;
+	}
+
+	// Per-axis phase tables: xTable[i][a] = exp(-i*k*x_i*u_a), yTable[i][b] = exp(-i*k*y_i*v_b)
+	AlignedVector<double> xRe(M * W), xIm(M * W);
+	AlignedVector<double> yRe(M * H), yIm(M * H);
+	for (size_t i = 0; i < M; i++)
+	{
+		for (size_t a = 0; a < W; a++)
+		{
+			xRe[i * W + a] = cos(-k * transducers[i].pos.x * uvals[a]);
+			xIm[i * W + a] = sin(-k * transducers[i].pos.x * uvals[a]);
+		}
+		for (size_t b = 0; b < H; b++)
+		{
+			yRe[i * H + b] = cos(-k * transducers[i].pos.y * vvals[b]);
+			yIm[i * H + b] = sin(-k * transducers[i].pos.y * vvals[b]);
+		}
+	}
+
+	pool.parallelFor(H, [&](size_t b)
+	{
+		AlignedVector<double> accRe(W, 0.0);
+		AlignedVector<double> accIm(W, 0.0);
+		double* __restrict re = accRe.data();
+		double* __restrict im = accIm.data();
+
+		for (size_t i = 0; i < M; i++)
+		{
+			const double cr = yRe[i * H + b];
+			const double ci = yIm[i * H + b];
+			double const * __restrict tr = &xRe[i * W];
+			double const * __restrict ti = &xIm[i * W];
+			for (size_t a = 0; a < W; a++)
+			{
+				re[a] += tr[a] * cr - ti[a] * ci;
+				im[a] += tr[a] * ci + ti[a] * cr;
+			}
+		}
+
+		double* dst = img.row(b);
+		for (size_t a = 0; a < W; a++)
+		{
+			dst[a] = visible(a, b) ? 1.0 / sqrt(2.0) * std::sqrt(sqr(re[a]) + sqr(im[a])) : 0.0;
+		}
+	});
+}
@@ -0,0 +1,78 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include "ApertureGrid.hpp"
+#include "FieldBuffer.hpp"
+#include "Transducer.hpp"
+#include "WorkerPool.hpp"
+
+#include <complex>
+#include <vector>
+
+
+/**
+ * Far-field (plane wave) array factor
+ *
+ *   AF(u, v, w) = sum_i exp(-i*k*(u*x_i + v*y_i + w*z_i))
+ *
+ * for a direction with direction cosines (u, v, w). For a listener at distance
+ * R in that direction, the near-field phasor sum is ~ exp(i*k*R) / R^2 * AF.
+ *
+ * Arrays filling a rectangular lattice (like RectangularTransducerArray) are
+ * separable, AF = AFx(u) * AFy(v) * exp(-i*k*w*z0), and evaluated from
+ * closed form per-axis sums in O(1) instead of O(transducers).
+ */
+class FarFieldArrayFactor {
+	std::vector<Transducer> transducers_;
+	double k_;
+	bool separable_;
+	ApertureGrid grid_;
+public:
+	FarFieldArrayFactor(std::vector<Transducer> const & transducers, double audioFrequency, double speedOfSound);
+
+	bool isSeparable() const { return separable_; }
+
+	/** |AF(u, v, w)| */
+	double magnitude(double u, double v, double w) const;
+
+	/** Per-axis factors |AFx(u)| and |AFy(v)|, only meaningful for separable arrays. */
+	double xMagnitude(double u) const;
+	double yMagnitude(double v) const;
+
+	/** AF(u, v, w), always by direct summation. */
+	std::complex<double> evaluate(double u, double v, double w) const;
+};
+
+/**
+ * Far-field approximation of renderSoundOnWall(): every wall pixel is treated
+ * as a direction (u, v, w) = (x, y, z) / R, with the rms value |AF| / (sqrt(2) * R^2). */
+void renderFarFieldOnWall(
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		FieldBuffer & img,
+		WorkerPool & pool);
+
+/**
+ * Beam pattern |AF| / sqrt(2) over a grid of direction cosines (uvals x vvals),
+ * with w = sqrt(1 - u^2 - v^2). Directions outside the unit circle (u^2 + v^2 > 1)
+ * are not visible and get 0.
+ *
+ * Per-axis phase tables exp(-i*k*x_i*u) and exp(-i*k*y_i*v) are precomputed,
+ * so the image is a sum of outer products without any trigonometry per pixel,
+ * and a single outer product for separable arrays. Arrays which are not planar
+ * fall back to direct summation. */
+void renderFarFieldDirections(
+		const std::vector<double>& uvals,
+		const std::vector<double>& vvals,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		FieldBuffer & img,
+		WorkerPool & pool);
@@ -0,0 +1,189 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "FarFieldFft.hpp"
+#include "AlignedAllocator.hpp"
+#include "FarField.hpp"
+#include "Fft.hpp"
+#include "Pos.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <memory>
+
+
+namespace {
+	typedef std::complex<double> Complex;
+
+	/**
+	 * Lattices with at most this many points along an axis are transformed with
+	 * a precomputed DFT table (a vectorized multiply-add per point) instead of
+	 * a chirp-z transform, which costs ~2*log2(2*outputs) butterflies per output. */
+	const size_t maxDirectDftSize = 64;
+
+	/**
+	 * X[m] = sum_{n<N} x[n] * exp(-i*(theta0 + m*dTheta)*n), m < M, for many x.
+	 * Output as separate real and imaginary arrays. */
+	class AxisDft {
+		size_t N_, M_;
+		std::unique_ptr<ChirpZ> chirpZ_;
+		AlignedVector<double> tableRe_, tableIm_;   // N x M
+	public:
+		AxisDft(size_t N, size_t M, double theta0, double dTheta)
+		: N_(N),
+			M_(M)
+		{
+			if (N > maxDirectDftSize)
+			{
+				chirpZ_.reset(new ChirpZ(N, M, theta0, dTheta));
+				return;
+			}
+
+			tableRe_.resize(N * M);
+			tableIm_.resize(N * M);
+			for (size_t n = 0; n < N; n++)
+			{
+				for (size_t m = 0; m < M; m++)
+				{
+					double phase = -(theta0 + double(m) * dTheta) * double(n);
+					tableRe_[n * M + m] = cos(phase);
+					tableIm_[n * M + m] = sin(phase);
+				}
+			}
+		}
+
+		size_t scratchSize() const { return chirpZ_ ? chirpZ_->scratchSize() + M_ : 0; }
+
+		void transform(Complex const * in, double* __restrict outRe, double* __restrict outIm, Complex* scratch) const
+		{
+			if (chirpZ_)
+			{
+				Complex* out = scratch + chirpZ_->scratchSize();
+				chirpZ_->transform(in, out, scratch);
+				for (size_t m = 0; m < M_; m++)
+				{
+					outRe[m] = out[m].real();
+					outIm[m] = out[m].imag();
+				}
+				return;
+			}
+
+			std::fill(outRe, outRe + M_, 0.0);
+			std::fill(outIm, outIm + M_, 0.0);
+			for (size_t n = 0; n < N_; n++)
+			{
+				const double cr = in[n].real();
+				const double ci = in[n].imag();
+				if (cr == 0 && ci == 0)
+				{
+					continue;
+				}
+				double const * __restrict tr = &tableRe_[n * M_];
+				double const * __restrict ti = &tableIm_[n * M_];
+				for (size_t m = 0; m < M_; m++)
+				{
+					outRe[m] += tr[m] * cr - ti[m] * ci;
+					outIm[m] += tr[m] * ci + ti[m] * cr;
+				}
+			}
+		}
+	};
+}
+
+bool isEvenlySpaced(std::vector<double> const & vals, double tolerance)
+{
+	if (vals.size() < 2)
+	{
+		return false;
+	}
+	const double step = (vals.back() - vals.front()) / double(vals.size() - 1);
+	for (size_t i = 0; i < vals.size(); i++)
+	{
+		if (std::fabs(vals[i] - (vals.front() + double(i) * step)) > tolerance * std::max(1.0, std::fabs(vals[i])))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void renderFarFieldFft(
+		const std::vector<double>& uvals,
+		const std::vector<double>& vvals,
+		double audioFrequency,
+		ApertureGrid const & grid,
+		const double speedOfSound,
+		FieldBuffer & img,
+		WorkerPool & pool)
+{
+	const size_t W = uvals.size();
+	const size_t H = vvals.size();
+	const size_t nx = grid.nx;
+	const size_t ny = grid.ny;
+	const double k = 2 * M_PI * audioFrequency / speedOfSound;
+	const double du = (uvals.back() - uvals.front()) / double(W - 1);
+	const double dv = (vvals.back() - vvals.front()) / double(H - 1);
+	img.resize(W, H);
+
+	// Along y, for every lattice column i:
+	// columns[i][b] = sum_j weights[j][i] * exp(-i*k*dy*(v0 + b*dv)*j)
+	AxisDft dftY(ny, H, k * grid.dy * vvals.front(), k * grid.dy * dv);
+	AlignedVector<double> columnsRe(nx * H);
+	AlignedVector<double> columnsIm(nx * H);
+	pool.parallelFor(nx, [&](size_t i)
+	{
+		std::vector<Complex> in(ny);
+		std::vector<Complex> scratch(dftY.scratchSize());
+		for (size_t j = 0; j < ny; j++)
+		{
+			in[j] = grid.weights[j * nx + i];
+		}
+		dftY.transform(in.data(), &columnsRe[i * H], &columnsIm[i * H], scratch.data());
+	});
+
+	// Along x, one output row at a time:
+	// AF[b][a] = sum_i columns[i][b] * exp(-i*k*dx*(u0 + a*du)*i)
+	AxisDft dftX(nx, W, k * grid.dx * uvals.front(), k * grid.dx * du);
+	pool.parallelFor(H, [&](size_t b)
+	{
+		std::vector<Complex> in(nx);
+		std::vector<Complex> scratch(dftX.scratchSize());
+		AlignedVector<double> re(W);
+		AlignedVector<double> im(W);
+		for (size_t i = 0; i < nx; i++)
+		{
+			in[i] = Complex(columnsRe[i * H + b], columnsIm[i * H + b]);
+		}
+		dftX.transform(in.data(), re.data(), im.data(), scratch.data());
+
+		double* dst = img.row(b);
+		const double v2 = sqr(vvals[b]);
+		for (size_t a = 0; a < W; a++)
+		{
+			dst[a] = sqr(uvals[a]) + v2 <= 1.0 ? 1.0 / sqrt(2.0) * std::sqrt(sqr(re[a]) + sqr(im[a])) : 0.0;
+		}
+	});
+}
+
+void renderFarFieldFft(
+		const std::vector<double>& uvals,
+		const std::vector<double>& vvals,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		FieldBuffer & img,
+		WorkerPool & pool)
+{
+	// Full lattices are separable, and an outer product beats the transform
+	ApertureGrid grid;
+	if (isEvenlySpaced(uvals) && isEvenlySpaced(vvals) && detectApertureGrid(transducers, grid) && !grid.isFull())
+	{
+		renderFarFieldFft(uvals, vvals, audioFrequency, grid, speedOfSound, img, pool);
+	}
+	else
+	{
+		renderFarFieldDirections(uvals, vvals, audioFrequency, transducers, speedOfSound, img, pool);
+	}
+}
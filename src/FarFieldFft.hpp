@@ -0,0 +1,54 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include "ApertureGrid.hpp"
+#include "FieldBuffer.hpp"
+#include "Transducer.hpp"
+#include "WorkerPool.hpp"
+
+#include <vector>
+
+
+/** @returns true if vals has at least two elements and a constant step (within tolerance). */
+bool isEvenlySpaced(std::vector<double> const & vals, double tolerance = 1e-9);
+
+/**
+ * Same beam pattern as renderFarFieldDirections(), but for an aperture on a
+ * regular lattice, where the array factor over an evenly spaced (u, v) grid
+ * is a 2D DFT of the lattice weights:
+ *
+ *   AF(u_a, v_b) ~ sum_j sum_i weights[j][i] * exp(-i*k*(i*dx*u_a + j*dy*v_b))
+ *
+ * (up to a unit phase factor). It is evaluated one axis at a time, first
+ * along y for each lattice column and then along x for each image row.
+ * Long axes use a chirp-z transform (a zero-padded FFT with arbitrary output
+ * spacing, O(W log W) per row), short ones a precomputed DFT table. Either
+ * way the cost is independent of the number of transducers.
+ *
+ * uvals and vvals must be evenly spaced.
+ */
+void renderFarFieldFft(
+		const std::vector<double>& uvals,
+		const std::vector<double>& vvals,
+		double audioFrequency,
+		ApertureGrid const & grid,
+		const double speedOfSound,
+		FieldBuffer & img,
+		WorkerPool & pool);
+
+/**
+ * renderFarFieldFft() for partially filled lattices (see detectApertureGrid()),
+ * and renderFarFieldDirections() for everything else: full lattices (separable,
+ * a single outer product), non-gridded arrays, or a (u, v) grid which is not
+ * evenly spaced. */
+void renderFarFieldFft(
+		const std::vector<double>& uvals,
+		const std::vector<double>& vvals,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		FieldBuffer & img,
+		WorkerPool & pool);
@@ -0,0 +1,153 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "FarFieldNufft.hpp"
+#include "ApertureGrid.hpp"
+#include "FarField.hpp"
+#include "FarFieldFft.hpp"
+#include "Pos.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace {
+	/**
+	 * Gaussian exp(-g^2 / (2*alpha^2)) in lattice units, truncated to
+	 * 2*halfWidth lattice points.
+	 *
+	 * With the lattice spacing h = 2*pi / (nufftOversampling * kappaMax), the first
+	 * alias of the spectrum is at (nufftOversampling - 1) * kappaMax, where the
+	 * Gaussian has decayed by exp(-2*pi^2*alpha^2*(1 - 2/nufftOversampling)).
+	 * The truncation error is exp(-halfWidth^2 / (2*alpha^2)). alpha balances the two.
+	 */
+	struct SpreadingKernel {
+		int halfWidth;
+		double alpha;
+
+		explicit SpreadingKernel(double tolerance)
+		{
+			const double aliasDecay = 2 * M_PI * M_PI * (1 - 2.0 / nufftOversampling);
+			// Margin for the deconvolution, which amplifies errors up to ~10x at |u| = 1
+			const double logError = std::log(10.0 / std::min(std::max(tolerance, 1e-15), 0.1));
+			const double rate = std::sqrt(2 * aliasDecay) / 2;   // error ~ exp(-rate * halfWidth)
+			halfWidth = std::max(2, int(std::ceil(logError / rate)));
+			alpha = std::sqrt(halfWidth / std::sqrt(2 * aliasDecay));
+		}
+
+		double operator()(double g) const
+		{
+			return std::exp(-g * g / (2 * alpha * alpha));
+		}
+
+		/** Fourier transform of the lattice sampled kernel, at kappa * h radians per lattice point */
+		double transform(double kappaH) const
+		{
+			return std::sqrt(2 * M_PI) * alpha * std::exp(-0.5 * sqr(kappaH * alpha));
+		}
+	};
+
+	/** Lattice along one axis covering [lo, hi] plus the kernel support. */
+	void latticeAxis(double lo, double hi, double h, int halfWidth, double & origin, int & count)
+	{
+		origin = lo - halfWidth * h;
+		count = int(std::ceil((hi - lo) / h)) + 2 * halfWidth + 1;
+	}
+
+	double maxAbs(std::vector<double> const & vals)
+	{
+		double m = 0;
+		for (double v : vals)
+		{
+			m = std::max(m, std::fabs(v));
+		}
+		return m;
+	}
+}
+
+void renderFarFieldNufft(
+		const std::vector<double>& uvals,
+		const std::vector<double>& vvals,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		double tolerance,
+		FieldBuffer & img,
+		WorkerPool & pool)
+{
+	const double k = 2 * M_PI * audioFrequency / speedOfSound;
+	// k = 0 has no lattice spacing (every direction sees the same constant field)
+	if (transducers.empty() || !(k > 0) || !isPlanar(transducers) || !isEvenlySpaced(uvals) || !isEvenlySpaced(vvals))
+	{
+		renderFarFieldDirections(uvals, vvals, audioFrequency, transducers, speedOfSound, img, pool);
+		return;
+	}
+
+	const SpreadingKernel kernel(tolerance);
+	const int S = kernel.halfWidth;
+
+	// Lattice spacing from the largest spatial frequency needed along each axis
+	const double hx = 2 * M_PI / (nufftOversampling * k * std::max(maxAbs(uvals), 1e-3));
+	const double hy = 2 * M_PI / (nufftOversampling * k * std::max(maxAbs(vvals), 1e-3));
+
+	double xmin = transducers[0].pos.x, xmax = xmin;
+	double ymin = transducers[0].pos.y, ymax = ymin;
+	for (Transducer const & t : transducers)
+	{
+		xmin = std::min(xmin, t.pos.x);
+		xmax = std::max(xmax, t.pos.x);
+		ymin = std::min(ymin, t.pos.y);
+		ymax = std::max(ymax, t.pos.y);
+	}
+
+	ApertureGrid grid;
+	grid.z0 = transducers[0].pos.z;
+	grid.dx = hx;
+	grid.dy = hy;
+	latticeAxis(xmin, xmax, hx, S, grid.x0, grid.nx);
+	latticeAxis(ymin, ymax, hy, S, grid.y0, grid.ny);
+	grid.weights.assign(size_t(grid.nx) * grid.ny, 0.0);
+
+	// Spread every transducer as an outer product of two 1D kernels
+	std::vector<double> wx(2 * S);
+	std::vector<double> wy(2 * S);
+	for (Transducer const & t : transducers)
+	{
+		const double gx = (t.pos.x - grid.x0) / hx;
+		const double gy = (t.pos.y - grid.y0) / hy;
+		const int ix = int(std::floor(gx)) - S + 1;
+		const int iy = int(std::floor(gy)) - S + 1;
+		for (int n = 0; n < 2 * S; n++)
+		{
+			wx[n] = kernel(ix + n - gx);
+			wy[n] = kernel(iy + n - gy);
+		}
+		for (int m = 0; m < 2 * S; m++)
+		{
+			double* row = &grid.weights[size_t(iy + m) * grid.nx + ix];
+			for (int n = 0; n < 2 * S; n++)
+			{
+				row[n] += wy[m] * wx[n];
+			}
+		}
+	}
+
+	renderFarFieldFft(uvals, vvals, audioFrequency, grid, speedOfSound, img, pool);
+
+	// Divide out the Gaussian
+	std::vector<double> scaleX(uvals.size());
+	for (size_t a = 0; a < uvals.size(); a++)
+	{
+		scaleX[a] = 1.0 / kernel.transform(k * uvals[a] * hx);
+	}
+	pool.parallelFor(vvals.size(), [&](size_t b)
+	{
+		const double scaleY = 1.0 / kernel.transform(k * vvals[b] * hy);
+		double* dst = img.row(b);
+		for (size_t a = 0; a < uvals.size(); a++)
+		{
+			dst[a] *= scaleX[a] * scaleY;
+		}
+	});
+}
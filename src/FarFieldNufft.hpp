@@ -0,0 +1,49 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include "FieldBuffer.hpp"
+#include "Transducer.hpp"
+#include "WorkerPool.hpp"
+
+#include <vector>
+
+
+/** Default accuracy of renderFarFieldNufft(), relative to the number of transducers. */
+const double nufftDefaultTolerance = 1e-6;
+
+/** Oversampling of the spreading lattice: spacing is 1/nufftOversampling of the shortest wavelength in (u, v). */
+const int nufftOversampling = 4;
+
+/**
+ * Same beam pattern as renderFarFieldDirections(), for arbitrary planar arrays,
+ * computed as a non-uniform FFT:
+ *
+ * 1) every transducer is spread onto a regular, oversampled lattice with a
+ *    truncated Gaussian (the lattice spacing only depends on the wavelength,
+ *    not on the geometry),
+ * 2) the lattice is transformed to the (u, v) grid like renderFarFieldFft(),
+ * 3) the Gaussian is divided out again (its Fourier transform is real and
+ *    positive, so this is a per-pixel scale factor).
+ *
+ * The cost is O(transducers * spread^2) plus the lattice transform, which does
+ * not depend on the number of transducers (spread = 2 * ceil(0.45 * ln(1/tolerance))).
+ * Every pixel is within tolerance * transducers of the exact value.
+ *
+ * Non-planar arrays, (u, v) grids which are not evenly spaced and a zero
+ * frequency fall back to renderFarFieldDirections().
+ *
+ * @param tolerance requested accuracy, relative to the number of transducers
+ *        (i.e. to the peak of the beam pattern). 1e-3 is plenty for images.
+ */
+void renderFarFieldNufft(
+		const std::vector<double>& uvals,
+		const std::vector<double>& vvals,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		double tolerance,
+		FieldBuffer & img,
+		WorkerPool & pool);
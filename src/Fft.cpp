@@ -0,0 +1,170 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "Fft.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <utility>
+
+
+size_t nextPowerOfTwo(size_t n)
+{
+	size_t p = 1;
+	while (p < n)
+	{
+		p *= 2;
+	}
+	return p;
+}
+
+Fft::Fft(size_t n)
+: n_(n),
+	bitReverse_(n),
+	twiddles_(n / 2)
+{
+	assert(n > 0 && (n & (n - 1)) == 0);
+
+	int bits = 0;
+	while ((size_t(1) << bits) < n)
+	{
+		bits++;
+	}
+
+	for (size_t i = 0; i < n; i++)
+	{
+		size_t r = 0;
+		for (int b = 0; b < bits; b++)
+		{
+			r |= ((i >> b) & 1) << (bits - 1 - b);
+		}
+		bitReverse_[i] = r;
+	}
+
+	// Each twiddle computed directly (not by repeated multiplication) to keep full precision
+	for (size_t k = 0; k < n / 2; k++)
+	{
+		double phase = -2 * M_PI * double(k) / double(n);
+		twiddles_[k] = std::complex<double>(cos(phase), sin(phase));
+	}
+}
+
+void Fft::forward(std::complex<double>* data) const
+{
+	transform(data, false);
+}
+
+void Fft::inverse(std::complex<double>* data) const
+{
+	transform(data, true);
+	const double scale = 1.0 / double(n_);
+	for (size_t i = 0; i < n_; i++)
+	{
+		data[i] *= scale;
+	}
+}
+
+void Fft::transform(std::complex<double>* data, bool inverse) const
+{
+	for (size_t i = 0; i < n_; i++)
+	{
+		size_t r = bitReverse_[i];
+		if (i < r)
+		{
+			std::swap(data[i], data[r]);
+		}
+	}
+
+	for (size_t len = 2; len <= n_; len *= 2)
+	{
+		const size_t half = len / 2;
+		const size_t stride = n_ / len;
+		for (size_t start = 0; start < n_; start += len)
+		{
+			for (size_t j = 0; j < half; j++)
+			{
+				std::complex<double> w = twiddles_[j * stride];
+				if (inverse)
+				{
+					w = std::conj(w);
+				}
+				// Written out, std::complex multiplication checks for NaN/inf
+				std::complex<double> a = data[start + j];
+				std::complex<double> b = data[start + j + half];
+				double tr = b.real() * w.real() - b.imag() * w.imag();
+				double ti = b.real() * w.imag() + b.imag() * w.real();
+				data[start + j] = std::complex<double>(a.real() + tr, a.imag() + ti);
+				data[start + j + half] = std::complex<double>(a.real() - tr, a.imag() - ti);
+			}
+		}
+	}
+}
+
+namespace {
+	/** exp(-i * dTheta * n^2 / 2) */
+	std::complex<double> chirp(double dTheta, size_t n)
+	{
+		double phase = -0.5 * dTheta * double(n) * double(n);
+		return std::complex<double>(cos(phase), sin(phase));
+	}
+}
+
+ChirpZ::ChirpZ(size_t N, size_t M, double theta0, double dTheta)
+: N_(N),
+	M_(M),
+	fft_(nextPowerOfTwo(N + M - 1)),
+	inChirp_(N),
+	outChirp_(M),
+	kernel_(fft_.size())
+{
+	// n*m = (n^2 + m^2 - (m - n)^2) / 2
+	for (size_t n = 0; n < N; n++)
+	{
+		double phase = -theta0 * double(n);
+		inChirp_[n] = std::complex<double>(cos(phase), sin(phase)) * chirp(dTheta, n);
+	}
+	for (size_t m = 0; m < M; m++)
+	{
+		outChirp_[m] = chirp(dTheta, m);
+	}
+
+	// Circular convolution kernel conj(chirp(j)), j = m - n in (-N, M)
+	const size_t L = fft_.size();
+	for (size_t j = 0; j < M; j++)
+	{
+		kernel_[j] = std::conj(chirp(dTheta, j));
+	}
+	for (size_t j = 1; j < N; j++)
+	{
+		kernel_[L - j] = std::conj(chirp(dTheta, j));
+	}
+	fft_.forward(kernel_.data());
+}
+
+void ChirpZ::transform(std::complex<double> const * in, std::complex<double>* out, std::complex<double>* scratch) const
+{
+	const size_t L = fft_.size();
+	for (size_t n = 0; n < N_; n++)
+	{
+		scratch[n] = in[n] * inChirp_[n];
+	}
+	for (size_t n = N_; n < L; n++)
+	{
+		scratch[n] = 0;
+	}
+
+	fft_.forward(scratch);
+	for (size_t i = 0; i < L; i++)
+	{
+		std::complex<double> a = scratch[i];
+		std::complex<double> b = kernel_[i];
+		scratch[i] = std::complex<double>(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+	}
+	fft_.inverse(scratch);
+
+	for (size_t m = 0; m < M_; m++)
+	{
+		out[m] = scratch[m] * outChirp_[m];
+	}
+}
@@ -0,0 +1,69 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+
+/** Smallest power of two >= n */
+size_t nextPowerOfTwo(size_t n);
+
+/**
+ * In place radix-2 FFT of a fixed (power of two) size.
+ * Twiddle factors and the bit reversal permutation are computed once,
+ * so one instance can be shared between threads transforming different data.
+ */
+class Fft {
+	size_t n_;
+	std::vector<size_t> bitReverse_;
+	std::vector<std::complex<double> > twiddles_;   // exp(-2*pi*i*k/n), k < n/2
+public:
+	/** @param n transform size, must be a power of two */
+	explicit Fft(size_t n);
+
+	size_t size() const { return n_; }
+
+	/** X[k] = sum_n x[n] * exp(-2*pi*i*k*n/N) */
+	void forward(std::complex<double>* data) const;
+
+	/** x[n] = 1/N * sum_k X[k] * exp(2*pi*i*k*n/N) */
+	void inverse(std::complex<double>* data) const;
+
+private:
+	void transform(std::complex<double>* data, bool inverse) const;
+};
+
+/**
+ * Chirp-z transform (Bluestein's algorithm), i.e. a DFT evaluated at arbitrary,
+ * evenly spaced angles:
+ *
+ *   X[m] = sum_{n<N} x[n] * exp(-i*(theta0 + m*dTheta)*n),  m < M
+ *
+ * computed as a convolution with a chirp, using FFTs of size >= N + M - 1.
+ * This is the zero-padded FFT of x generalized to any output range and spacing.
+ */
+class ChirpZ {
+	size_t N_, M_;
+	Fft fft_;
+	std::vector<std::complex<double> > inChirp_;    // exp(-i*(theta0*n + dTheta*n^2/2))
+	std::vector<std::complex<double> > outChirp_;   // exp(-i*dTheta*m^2/2)
+	std::vector<std::complex<double> > kernel_;     // FFT of exp(i*dTheta*j^2/2), j in (-N, M)
+public:
+	ChirpZ(size_t N, size_t M, double theta0, double dTheta);
+
+	size_t inputSize() const { return N_; }
+	size_t outputSize() const { return M_; }
+
+	/** Number of complex values transform() needs as scratch space. */
+	size_t scratchSize() const { return fft_.size(); }
+
+	/**
+	 * @param in N input values
+	 * @param out M output values
+	 * @param scratch at least scratchSize() values, overwritten */
+	void transform(std::complex<double> const * in, std::complex<double>* out, std::complex<double>* scratch) const;
+};
@@ -0,0 +1,50 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include "AlignedAllocator.hpp"
+
+#include <cstddef>
+
+
+/**
+ * Heap allocated, 64 byte aligned width x height field of doubles (row major),
+ * which renderers write their results into.
+ *
+ * Intended to be reused between renders: resize() only reallocates when the
+ * new size does not fit in what has already been allocated.
+ */
+class FieldBuffer {
+	int width_;
+	int height_;
+	AlignedVector<double> data_;
+public:
+	FieldBuffer() : width_(0), height_(0) {}
+
+	FieldBuffer(int width, int height) : width_(0), height_(0)
+	{
+		resize(width, height);
+	}
+
+	void resize(int width, int height)
+	{
+		width_ = width;
+		height_ = height;
+		data_.resize(size_t(width) * height);
+	}
+
+	int width() const { return width_; }
+	int height() const { return height_; }
+	size_t size() const { return data_.size(); }
+
+	double* data() { return data_.data(); }
+	double const * data() const { return data_.data(); }
+
+	double* row(int y) { return data_.data() + size_t(y) * width_; }
+	double const * row(int y) const { return data_.data() + size_t(y) * width_; }
+
+	double& at(int x, int y) { return data_[size_t(y) * width_ + x]; }
+	double at(int x, int y) const { return data_[size_t(y) * width_ + x]; }
+};
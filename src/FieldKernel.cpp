@@ -0,0 +1,111 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "FieldKernel.hpp"
+#include "FieldKernelSimd.hpp"
+
+#include <atomic>
+
+
+namespace {
+
+	std::complex<double> accumulateFieldScalar(TransducerBlock const & block, Pos const & listenerPos, double audioFrequency, double speedOfSound)
+	{
+		// Same expressions, in the same order, as accumulateField(std::vector<Transducer>...)
+		double re = 0;
+		double im = 0;
+		for (size_t i = 0; i < block.size(); i++)
+		{
+			double distance = listenerPos.dist(Pos(block.x()[i], block.y()[i], block.z()[i]));
+			double amplitude = 1.0 / sqr(distance);
+			double phase = 2 * M_PI * distance * audioFrequency / speedOfSound;
+			re += amplitude * cos(phase);
+			im += amplitude * sin(phase);
+		}
+		return std::complex<double>(re, im);
+	}
+
+	// Scalar unless asked for, so default renders stay bit identical to earlier builds
+	std::atomic<int> g_selectedIsa(int(FieldKernelIsa::SCALAR));
+}
+
+bool isFieldKernelIsaSupported(FieldKernelIsa isa)
+{
+	switch (isa)
+	{
+	case FieldKernelIsa::SCALAR:
+		return true;
+#if FIELD_KERNEL_HAVE_X86_SIMD
+	case FieldKernelIsa::AVX2:
+		return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+	case FieldKernelIsa::AVX512:
+		return __builtin_cpu_supports("avx512f");
+#endif
+	default:
+		return false;
+	}
+}
+
+FieldKernelIsa detectFieldKernelIsa()
+{
+	if (isFieldKernelIsaSupported(FieldKernelIsa::AVX512)) { return FieldKernelIsa::AVX512; }
+	if (isFieldKernelIsaSupported(FieldKernelIsa::AVX2)) { return FieldKernelIsa::AVX2; }
+	return FieldKernelIsa::SCALAR;
+}
+
+void setFieldKernelIsa(FieldKernelIsa isa)
+{
+	if (!isFieldKernelIsaSupported(isa))
+	{
+		isa = FieldKernelIsa::SCALAR;
+	}
+	g_selectedIsa = int(isa);
+}
+
+FieldKernelIsa getFieldKernelIsa()
+{
+	return FieldKernelIsa(int(g_selectedIsa));
+}
+
+const char* fieldKernelIsaName(FieldKernelIsa isa)
+{
+	switch (isa)
+	{
+	case FieldKernelIsa::SCALAR: return "scalar";
+	case FieldKernelIsa::AVX2:   return "avx2";
+	case FieldKernelIsa::AVX512: return "avx512";
+	}
+	return "unknown";
+}
+
+bool parseFieldKernelIsa(std::string const & name, FieldKernelIsa & isa)
+{
+	if (name == "auto")   { isa = detectFieldKernelIsa(); return true; }
+	if (name == "scalar") { isa = FieldKernelIsa::SCALAR; return true; }
+	if (name == "avx2")   { isa = FieldKernelIsa::AVX2; return true; }
+	if (name == "avx512") { isa = FieldKernelIsa::AVX512; return true; }
+	return false;
+}
+
+std::complex<double>
+accumulateField(FieldKernelIsa isa, TransducerBlock const & block, Pos const & listenerPos, double audioFrequency, double speedOfSound)
+{
+	switch (isa)
+	{
+#if FIELD_KERNEL_HAVE_X86_SIMD
+	case FieldKernelIsa::AVX2:
+		return fieldkernel::accumulateFieldAvx2(block, listenerPos, 2 * M_PI * audioFrequency / speedOfSound);
+	case FieldKernelIsa::AVX512:
+		return fieldkernel::accumulateFieldAvx512(block, listenerPos, 2 * M_PI * audioFrequency / speedOfSound);
+#endif
+	default:
+		return accumulateFieldScalar(block, listenerPos, audioFrequency, speedOfSound);
+	}
+}
+
+std::complex<double>
+accumulateField(TransducerBlock const & block, Pos const & listenerPos, double audioFrequency, double speedOfSound)
+{
+	return accumulateField(getFieldKernelIsa(), block, listenerPos, audioFrequency, speedOfSound);
+}
@@ -0,0 +1,48 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include "Pos.hpp"
+#include "TransducerBlock.hpp"
+
+#include <complex>
+#include <string>
+
+
+/** Instruction set used by the accumulateField() kernels. */
+enum class FieldKernelIsa {
+	SCALAR = 0,  //!< plain loop using libm sin/cos (bit-identical to the original renderer)
+	AVX2 = 1,    //!< 4 transducers per instruction
+	AVX512 = 2,  //!< 8 transducers per instruction
+};
+
+/** @returns true if this build and the cpu we run on can execute isa. */
+bool isFieldKernelIsaSupported(FieldKernelIsa isa);
+
+/** @returns the fastest supported instruction set. */
+FieldKernelIsa detectFieldKernelIsa();
+
+/** Select the kernel used by accumulateField(TransducerBlock...).
+    Defaults to SCALAR, which renders bit identical images to earlier builds (the
+    SIMD kernels round differently). Unsupported choices fall back to SCALAR. */
+void setFieldKernelIsa(FieldKernelIsa isa);
+FieldKernelIsa getFieldKernelIsa();
+
+const char* fieldKernelIsaName(FieldKernelIsa isa);
+
+/** Parse "auto", "scalar", "avx2" or "avx512". @returns false on unknown names. */
+bool parseFieldKernelIsa(std::string const & name, FieldKernelIsa & isa);
+
+/**
+ * Resulting phasor at listenerPos from all transducers in block, using the
+ * currently selected instruction set. The vectorized versions use their own
+ * sin/cos approximation. They agree with the scalar one to within the rounding
+ * error of the phase itself (~phase * 1e-16, relative to the summed amplitudes). */
+std::complex<double>
+accumulateField(TransducerBlock const & block, Pos const & listenerPos, double audioFrequency, double speedOfSound);
+
+/** Same as above, using a specific instruction set (which must be supported). */
+std::complex<double>
+accumulateField(FieldKernelIsa isa, TransducerBlock const & block, Pos const & listenerPos, double audioFrequency, double speedOfSound);
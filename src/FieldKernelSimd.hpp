@@ -0,0 +1,32 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+// Internal to the FieldKernel*.cpp files.
+
+#include "Pos.hpp"
+#include "SinCosPolynomial.hpp"
+#include "TransducerBlock.hpp"
+
+#include <complex>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FIELD_KERNEL_HAVE_X86_SIMD 1
+#else
+#define FIELD_KERNEL_HAVE_X86_SIMD 0
+#endif
+
+namespace fieldkernel {
+	using namespace sincospolynomial;
+
+	// pi/2 split in three parts, for Cody-Waite argument reduction with FMA
+	const double PIO2_1 = 1.5707963267948966;
+	const double PIO2_2 = 6.123233995736766e-17;
+	const double PIO2_3 = -1.4973849048591698e-33;
+
+	/** @param k wave number (2*pi*f/c) */
+	std::complex<double> accumulateFieldAvx2(TransducerBlock const & block, Pos const & listenerPos, double k);
+	std::complex<double> accumulateFieldAvx512(TransducerBlock const & block, Pos const & listenerPos, double k);
+}
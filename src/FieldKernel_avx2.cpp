@@ -0,0 +1,97 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "FieldKernelSimd.hpp"
+
+#if FIELD_KERNEL_HAVE_X86_SIMD
+
+#include <immintrin.h>
+
+namespace fieldkernel {
+
+namespace {
+
+	/** Vectorized sin and cos of 4 doubles (valid for |x| < ~1e9). */
+	__attribute__((target("avx2,fma")))
+	inline void sincos4(__m256d x, __m256d & sinOut, __m256d & cosOut)
+	{
+		// quadrant = round(x * 2/pi), kept both as double and as integer bits
+		__m256d t = _mm256_fmadd_pd(x, _mm256_set1_pd(TWO_OVER_PI), _mm256_set1_pd(ROUND_MAGIC));
+		__m256i quadrant = _mm256_castpd_si256(t);
+		__m256d q = _mm256_sub_pd(t, _mm256_set1_pd(ROUND_MAGIC));
+
+		__m256d r = _mm256_fnmadd_pd(q, _mm256_set1_pd(PIO2_1), x);
+		r = _mm256_fnmadd_pd(q, _mm256_set1_pd(PIO2_2), r);
+		r = _mm256_fnmadd_pd(q, _mm256_set1_pd(PIO2_3), r);
+
+		__m256d z = _mm256_mul_pd(r, r);
+
+		__m256d ps = _mm256_fmadd_pd(z, _mm256_set1_pd(S6), _mm256_set1_pd(S5));
+		ps = _mm256_fmadd_pd(z, ps, _mm256_set1_pd(S4));
+		ps = _mm256_fmadd_pd(z, ps, _mm256_set1_pd(S3));
+		ps = _mm256_fmadd_pd(z, ps, _mm256_set1_pd(S2));
+		ps = _mm256_fmadd_pd(z, ps, _mm256_set1_pd(S1));
+		__m256d s = _mm256_fmadd_pd(_mm256_mul_pd(r, z), ps, r);
+
+		__m256d pc = _mm256_fmadd_pd(z, _mm256_set1_pd(C6), _mm256_set1_pd(C5));
+		pc = _mm256_fmadd_pd(z, pc, _mm256_set1_pd(C4));
+		pc = _mm256_fmadd_pd(z, pc, _mm256_set1_pd(C3));
+		pc = _mm256_fmadd_pd(z, pc, _mm256_set1_pd(C2));
+		pc = _mm256_fmadd_pd(z, pc, _mm256_set1_pd(C1));
+		__m256d c = _mm256_fmadd_pd(_mm256_mul_pd(z, z), pc, _mm256_fnmadd_pd(_mm256_set1_pd(0.5), z, _mm256_set1_pd(1.0)));
+
+		// Odd quadrants swap sin and cos
+		__m256d swap = _mm256_castsi256_pd(_mm256_slli_epi64(quadrant, 63));
+		__m256d sinv = _mm256_blendv_pd(s, c, swap);
+		__m256d cosv = _mm256_blendv_pd(c, s, swap);
+
+		// sin is negative in quadrants 2, 3 and cos in quadrants 1, 2
+		__m256i signBit = _mm256_set1_epi64x(0x8000000000000000LL);
+		__m256i sinSign = _mm256_and_si256(_mm256_slli_epi64(quadrant, 62), signBit);
+		__m256i cosSign = _mm256_and_si256(_mm256_slli_epi64(_mm256_add_epi64(quadrant, _mm256_set1_epi64x(1)), 62), signBit);
+
+		sinOut = _mm256_xor_pd(sinv, _mm256_castsi256_pd(sinSign));
+		cosOut = _mm256_xor_pd(cosv, _mm256_castsi256_pd(cosSign));
+	}
+}
+
+__attribute__((target("avx2,fma")))
+std::complex<double> accumulateFieldAvx2(TransducerBlock const & block, Pos const & listenerPos, double k)
+{
+	const __m256d lx = _mm256_set1_pd(listenerPos.x);
+	const __m256d ly = _mm256_set1_pd(listenerPos.y);
+	const __m256d lz = _mm256_set1_pd(listenerPos.z);
+	const __m256d kv = _mm256_set1_pd(k);
+
+	__m256d re = _mm256_setzero_pd();
+	__m256d im = _mm256_setzero_pd();
+
+	for (size_t i = 0; i < block.paddedSize(); i += 4)
+	{
+		__m256d dx = _mm256_sub_pd(lx, _mm256_load_pd(block.x() + i));
+		__m256d dy = _mm256_sub_pd(ly, _mm256_load_pd(block.y() + i));
+		__m256d dz = _mm256_sub_pd(lz, _mm256_load_pd(block.z() + i));
+		__m256d d2 = _mm256_fmadd_pd(dz, dz, _mm256_fmadd_pd(dy, dy, _mm256_mul_pd(dx, dx)));
+		__m256d distance = _mm256_sqrt_pd(d2);
+		__m256d amplitude = _mm256_div_pd(_mm256_load_pd(block.weight() + i), d2);
+
+		__m256d s, c;
+		sincos4(_mm256_mul_pd(kv, distance), s, c);
+
+		re = _mm256_fmadd_pd(amplitude, c, re);
+		im = _mm256_fmadd_pd(amplitude, s, im);
+	}
+
+	alignas(32) double reLanes[4];
+	alignas(32) double imLanes[4];
+	_mm256_store_pd(reLanes, re);
+	_mm256_store_pd(imLanes, im);
+	return std::complex<double>(
+		(reLanes[0] + reLanes[1]) + (reLanes[2] + reLanes[3]),
+		(imLanes[0] + imLanes[1]) + (imLanes[2] + imLanes[3]));
+}
+
+}
+
+#endif
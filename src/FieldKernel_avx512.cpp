@@ -0,0 +1,102 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "FieldKernelSimd.hpp"
+
+#if FIELD_KERNEL_HAVE_X86_SIMD
+
+#include <immintrin.h>
+
+namespace fieldkernel {
+
+namespace {
+
+	/** Vectorized sin and cos of 8 doubles (valid for |x| < ~1e9). Same algorithm as sincos4(). */
+	__attribute__((target("avx512f")))
+	inline void sincos8(__m512d x, __m512d & sinOut, __m512d & cosOut)
+	{
+		__m512d t = _mm512_fmadd_pd(x, _mm512_set1_pd(TWO_OVER_PI), _mm512_set1_pd(ROUND_MAGIC));
+		__m512i quadrant = _mm512_castpd_si512(t);
+		__m512d q = _mm512_sub_pd(t, _mm512_set1_pd(ROUND_MAGIC));
+
+		__m512d r = _mm512_fnmadd_pd(q, _mm512_set1_pd(PIO2_1), x);
+		r = _mm512_fnmadd_pd(q, _mm512_set1_pd(PIO2_2), r);
+		r = _mm512_fnmadd_pd(q, _mm512_set1_pd(PIO2_3), r);
+
+		__m512d z = _mm512_mul_pd(r, r);
+
+		__m512d ps = _mm512_fmadd_pd(z, _mm512_set1_pd(S6), _mm512_set1_pd(S5));
+		ps = _mm512_fmadd_pd(z, ps, _mm512_set1_pd(S4));
+		ps = _mm512_fmadd_pd(z, ps, _mm512_set1_pd(S3));
+		ps = _mm512_fmadd_pd(z, ps, _mm512_set1_pd(S2));
+		ps = _mm512_fmadd_pd(z, ps, _mm512_set1_pd(S1));
+		__m512d s = _mm512_fmadd_pd(_mm512_mul_pd(r, z), ps, r);
+
+		__m512d pc = _mm512_fmadd_pd(z, _mm512_set1_pd(C6), _mm512_set1_pd(C5));
+		pc = _mm512_fmadd_pd(z, pc, _mm512_set1_pd(C4));
+		pc = _mm512_fmadd_pd(z, pc, _mm512_set1_pd(C3));
+		pc = _mm512_fmadd_pd(z, pc, _mm512_set1_pd(C2));
+		pc = _mm512_fmadd_pd(z, pc, _mm512_set1_pd(C1));
+		__m512d c = _mm512_fmadd_pd(_mm512_mul_pd(z, z), pc, _mm512_fnmadd_pd(_mm512_set1_pd(0.5), z, _mm512_set1_pd(1.0)));
+
+		__mmask8 swap = _mm512_test_epi64_mask(quadrant, _mm512_set1_epi64(1));
+		__m512d sinv = _mm512_mask_blend_pd(swap, s, c);
+		__m512d cosv = _mm512_mask_blend_pd(swap, c, s);
+
+		// Flip the sign where bit 1 of the (shifted) quadrant is set. Masked xor rather than a
+		// shift, as GCC's _mm512_slli_epi64 passes an uninitialized vector to its builtin.
+		__m512i signBit = _mm512_set1_epi64(0x8000000000000000LL);
+		__m512i two = _mm512_set1_epi64(2);
+		__mmask8 sinNegative = _mm512_test_epi64_mask(quadrant, two);
+		__mmask8 cosNegative = _mm512_test_epi64_mask(_mm512_add_epi64(quadrant, _mm512_set1_epi64(1)), two);
+
+		__m512i sinBits = _mm512_castpd_si512(sinv);
+		__m512i cosBits = _mm512_castpd_si512(cosv);
+		sinOut = _mm512_castsi512_pd(_mm512_mask_xor_epi64(sinBits, sinNegative, sinBits, signBit));
+		cosOut = _mm512_castsi512_pd(_mm512_mask_xor_epi64(cosBits, cosNegative, cosBits, signBit));
+	}
+
+	/** Sum of all 8 lanes, without _mm512_reduce_add_pd() (which warns with GCC 12, see sincos8()). */
+	__attribute__((target("avx512f")))
+	inline double horizontalSum(__m512d v)
+	{
+		__m256d sum4 = _mm256_add_pd(_mm512_maskz_extractf64x4_pd(0xF, v, 0), _mm512_maskz_extractf64x4_pd(0xF, v, 1));
+		__m128d sum2 = _mm_add_pd(_mm256_castpd256_pd128(sum4), _mm256_extractf128_pd(sum4, 1));
+		return _mm_cvtsd_f64(_mm_add_sd(sum2, _mm_unpackhi_pd(sum2, sum2)));
+	}
+}
+
+__attribute__((target("avx512f")))
+std::complex<double> accumulateFieldAvx512(TransducerBlock const & block, Pos const & listenerPos, double k)
+{
+	const __m512d lx = _mm512_set1_pd(listenerPos.x);
+	const __m512d ly = _mm512_set1_pd(listenerPos.y);
+	const __m512d lz = _mm512_set1_pd(listenerPos.z);
+	const __m512d kv = _mm512_set1_pd(k);
+
+	__m512d re = _mm512_setzero_pd();
+	__m512d im = _mm512_setzero_pd();
+
+	for (size_t i = 0; i < block.paddedSize(); i += 8)
+	{
+		__m512d dx = _mm512_sub_pd(lx, _mm512_load_pd(block.x() + i));
+		__m512d dy = _mm512_sub_pd(ly, _mm512_load_pd(block.y() + i));
+		__m512d dz = _mm512_sub_pd(lz, _mm512_load_pd(block.z() + i));
+		__m512d d2 = _mm512_fmadd_pd(dz, dz, _mm512_fmadd_pd(dy, dy, _mm512_mul_pd(dx, dx)));
+		__m512d distance = _mm512_maskz_sqrt_pd(0xFF, d2); // all lanes, see sincos8() on the unmasked form
+		__m512d amplitude = _mm512_div_pd(_mm512_load_pd(block.weight() + i), d2);
+
+		__m512d s, c;
+		sincos8(_mm512_mul_pd(kv, distance), s, c);
+
+		re = _mm512_fmadd_pd(amplitude, c, re);
+		im = _mm512_fmadd_pd(amplitude, s, im);
+	}
+
+	return std::complex<double>(horizontalSum(re), horizontalSum(im));
+}
+
+}
+
+#endif
@@ -0,0 +1,300 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "FieldPrecision.hpp"
+#include "AlignedAllocator.hpp"
+#include "FieldKernel.hpp"
+#include "FieldKernelSimd.hpp"
+#include "SinCos.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+
+namespace {
+	/** Pixels per row segment, small enough for the accumulators to stay in L1. */
+	const size_t segmentSize = 256;
+
+	/** Transducer coordinates converted to Real once per render. */
+	template <typename Real>
+	struct RealTransducers {
+		AlignedVector<Real> x, y, z;
+
+		explicit RealTransducers(std::vector<Transducer> const & transducers)
+		{
+			for (Transducer const & t : transducers)
+			{
+				x.push_back(Real(t.pos.x));
+				y.push_back(Real(t.pos.y));
+				z.push_back(Real(t.pos.z));
+			}
+		}
+	};
+
+	/** Transducer coordinates as fixed size arrays, for the common array sizes. */
+	template <typename Real, size_t N>
+	struct FixedTransducers {
+		std::array<Real, N> x, y, z;
+
+		explicit FixedTransducers(std::vector<Transducer> const & transducers)
+		{
+			for (size_t j = 0; j < N; j++)
+			{
+				x[j] = Real(transducers[j].pos.x);
+				y[j] = Real(transducers[j].pos.y);
+				z[j] = Real(transducers[j].pos.z);
+			}
+		}
+	};
+
+	/**
+	 * Render count pixels of one row. The inner loop runs over pixels,
+	 * element wise (no reduction), so the compiler vectorizes it for Real
+	 * and Accum without needing to reorder any sums. */
+	template <typename Real, typename Accum>
+	inline __attribute__((always_inline))
+	void renderSegment(
+			RealTransducers<Real> const & t,
+			Real const * __restrict xs, size_t count,
+			Real y, Real z, Real k,
+			Accum* __restrict re, Accum* __restrict im,
+			double* __restrict dst)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			re[i] = 0;
+			im[i] = 0;
+		}
+
+		for (size_t j = 0; j < t.x.size(); j++)
+		{
+			const Real tx = t.x[j];
+			const Real dyz2 = (y - t.y[j]) * (y - t.y[j]) + (z - t.z[j]) * (z - t.z[j]);
+			for (size_t i = 0; i < count; i++)
+			{
+				Real dx = xs[i] - tx;
+				Real d2 = dx * dx + dyz2;
+				Real amplitude = Real(1) / d2;
+				Real s, c;
+				sinCos(k * std::sqrt(d2), s, c);
+				re[i] += Accum(amplitude * c);
+				im[i] += Accum(amplitude * s);
+			}
+		}
+
+		for (size_t i = 0; i < count; i++)
+		{
+			dst[i] = 1.0 / sqrt(2.0) * std::sqrt(double(re[i]) * double(re[i]) + double(im[i]) * double(im[i]));
+		}
+	}
+
+	/**
+	 * Same for N transducers known at compile time: the transducer loop is
+	 * unrolled completely inside the (vectorized) pixel loop, so the sums stay
+	 * in registers and there is no per-transducer loop overhead. */
+	template <typename Real, typename Accum, size_t N>
+	inline __attribute__((always_inline))
+	void renderSegment(
+			FixedTransducers<Real, N> const & t,
+			Real const * __restrict xs, size_t count,
+			Real y, Real z, Real k,
+			Accum*, Accum*,
+			double* __restrict dst)
+	{
+		Real dyz2[N];
+		for (size_t j = 0; j < N; j++)
+		{
+			dyz2[j] = (y - t.y[j]) * (y - t.y[j]) + (z - t.z[j]) * (z - t.z[j]);
+		}
+
+		for (size_t i = 0; i < count; i++)
+		{
+			Accum re = 0;
+			Accum im = 0;
+#pragma GCC unroll 8
+			for (size_t j = 0; j < N; j++)
+			{
+				Real dx = xs[i] - t.x[j];
+				Real d2 = dx * dx + dyz2[j];
+				Real amplitude = Real(1) / d2;
+				Real s, c;
+				sinCos(k * std::sqrt(d2), s, c);
+				re += Accum(amplitude * c);
+				im += Accum(amplitude * s);
+			}
+			dst[i] = 1.0 / sqrt(2.0) * std::sqrt(double(re) * double(re) + double(im) * double(im));
+		}
+	}
+
+	template <typename Real, typename Accum, typename Transducers>
+	struct SegmentKernel {
+		typedef void (*Function)(Transducers const &, Real const *, size_t, Real, Real, Real,
+				Accum*, Accum*, double*);
+
+		static void generic(Transducers const & t, Real const * xs, size_t count, Real y, Real z, Real k,
+				Accum* re, Accum* im, double* dst)
+		{
+			renderSegment<Real, Accum>(t, xs, count, y, z, k, re, im, dst);
+		}
+
+#if FIELD_KERNEL_HAVE_X86_SIMD
+		__attribute__((target("avx2,fma")))
+		static void avx2(Transducers const & t, Real const * xs, size_t count, Real y, Real z, Real k,
+				Accum* re, Accum* im, double* dst)
+		{
+			renderSegment<Real, Accum>(t, xs, count, y, z, k, re, im, dst);
+		}
+
+		__attribute__((target("avx512f")))
+		static void avx512(Transducers const & t, Real const * xs, size_t count, Real y, Real z, Real k,
+				Accum* re, Accum* im, double* dst)
+		{
+			renderSegment<Real, Accum>(t, xs, count, y, z, k, re, im, dst);
+		}
+#endif
+
+		static Function select(FieldKernelIsa isa)
+		{
+			switch (isa)
+			{
+#if FIELD_KERNEL_HAVE_X86_SIMD
+			case FieldKernelIsa::AVX2: return &avx2;
+			case FieldKernelIsa::AVX512: return &avx512;
+#endif
+			default: return &generic;
+			}
+		}
+	};
+
+	template <typename Real, typename Accum, typename Transducers>
+	void renderWall(
+			const std::vector<double>& xvals,
+			const std::vector<double>& yvals,
+			double z,
+			double audioFrequency,
+			const std::vector<Transducer>& transducers,
+			const double speedOfSound,
+			FieldBuffer & img,
+			WorkerPool & pool)
+	{
+		typedef SegmentKernel<Real, Accum, Transducers> Kernel;
+		typename Kernel::Function kernel = Kernel::select(getFieldKernelIsa());
+		Transducers t(transducers);
+		AlignedVector<Real> xs(xvals.begin(), xvals.end());
+		const Real k = Real(2 * M_PI * audioFrequency / speedOfSound);
+
+		img.resize(xvals.size(), yvals.size());
+		const size_t segments = (xvals.size() + segmentSize - 1) / segmentSize;
+
+		pool.parallelFor(yvals.size() * segments, [&](size_t job)
+		{
+			const size_t yind = job / segments;
+			const size_t x0 = (job % segments) * segmentSize;
+			const size_t count = std::min(segmentSize, xvals.size() - x0);
+
+			alignas(64) Accum re[segmentSize];
+			alignas(64) Accum im[segmentSize];
+			kernel(t, xs.data() + x0, count, Real(yvals[yind]), Real(z), k, re, im, img.row(yind) + x0);
+		});
+	}
+
+	/** renderWall() with the fixed size kernel if there is one for this many transducers. */
+	template <typename Real, typename Accum>
+	void renderWallAnySize(
+			const std::vector<double>& xvals,
+			const std::vector<double>& yvals,
+			double z,
+			double audioFrequency,
+			const std::vector<Transducer>& transducers,
+			const double speedOfSound,
+			bool allowFixedSize,
+			FieldBuffer & img,
+			WorkerPool & pool)
+	{
+		switch (allowFixedSize ? transducers.size() : 0)
+		{
+		case 4:
+			renderWall<Real, Accum, FixedTransducers<Real, 4> >(xvals, yvals, z, audioFrequency, transducers, speedOfSound, img, pool);
+			break;
+		case 7:
+			renderWall<Real, Accum, FixedTransducers<Real, 7> >(xvals, yvals, z, audioFrequency, transducers, speedOfSound, img, pool);
+			break;
+		default:
+			renderWall<Real, Accum, RealTransducers<Real> >(xvals, yvals, z, audioFrequency, transducers, speedOfSound, img, pool);
+			break;
+		}
+	}
+}
+
+bool hasFixedSizeFieldKernel(size_t numTransducers)
+{
+	return numTransducers == 4 || numTransducers == 7;
+}
+
+bool parseFieldPrecision(std::string const & name, FieldPrecision & precision)
+{
+	if (name == "double") { precision = FieldPrecision::DOUBLE; return true; }
+	if (name == "float")  { precision = FieldPrecision::FLOAT; return true; }
+	if (name == "mixed")  { precision = FieldPrecision::MIXED; return true; }
+	return false;
+}
+
+const char* fieldPrecisionName(FieldPrecision precision)
+{
+	switch (precision)
+	{
+	case FieldPrecision::DOUBLE: return "double";
+	case FieldPrecision::FLOAT:  return "float";
+	case FieldPrecision::MIXED:  return "mixed";
+	}
+	return "unknown";
+}
+
+void renderSoundOnWallPrecision(
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		FieldPrecision precision,
+		FieldBuffer & img,
+		WorkerPool & pool,
+		bool allowFixedSize)
+{
+	switch (precision)
+	{
+	case FieldPrecision::FLOAT:
+		renderWallAnySize<float, float>(xvals, yvals, z, audioFrequency, transducers, speedOfSound, allowFixedSize, img, pool);
+		break;
+	case FieldPrecision::MIXED:
+		renderWallAnySize<float, double>(xvals, yvals, z, audioFrequency, transducers, speedOfSound, allowFixedSize, img, pool);
+		break;
+	default:
+		renderWallAnySize<double, double>(xvals, yvals, z, audioFrequency, transducers, speedOfSound, allowFixedSize, img, pool);
+		break;
+	}
+}
+
+FieldError compareFields(FieldBuffer const & reference, FieldBuffer const & field)
+{
+	double peak = 0;
+	double maxAbsolute = 0;
+	double sumSquares = 0;
+	const size_t n = std::min(reference.size(), field.size());
+	for (size_t i = 0; i < n; i++)
+	{
+		double diff = std::fabs(reference.data()[i] - field.data()[i]);
+		peak = std::max(peak, reference.data()[i]);
+		maxAbsolute = std::max(maxAbsolute, diff);
+		sumSquares += diff * diff;
+	}
+
+	FieldError error;
+	error.maxAbsolute = maxAbsolute;
+	error.maxRelative = peak > 0 ? maxAbsolute / peak : 0;
+	error.rmsRelative = peak > 0 && n ? std::sqrt(sumSquares / n) / peak : 0;
+	return error;
+}
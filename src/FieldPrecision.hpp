@@ -0,0 +1,66 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include "FieldBuffer.hpp"
+#include "Transducer.hpp"
+#include "WorkerPool.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+/** Floating point types used by renderSoundOnWallPrecision(). */
+enum class FieldPrecision {
+	DOUBLE,  //!< double throughout
+	FLOAT,   //!< float throughout (twice the SIMD width)
+	MIXED    //!< float distances and phases, summed in double
+};
+
+/** Parse "double", "float" or "mixed". */
+bool parseFieldPrecision(std::string const & name, FieldPrecision & precision);
+
+const char* fieldPrecisionName(FieldPrecision precision);
+
+/**
+ * renderSoundOnWall() with the field kernel instantiated for a given
+ * precision, and for the instruction set selected with setFieldKernelIsa().
+ *
+ * Each row is vectorized across its pixels (one transducer at a time), so the
+ * float variants run twice as many lanes per instruction as double. In float,
+ * the phase k * d carries an error of about k * d * 6e-8 radians, which is
+ * ~2e-4 relative at 10 kHz and a 10 m wall: below one step of an 8 bit image.
+ *
+ * The tiny built-in arrays (see hasFixedSizeFieldKernel()) use a kernel
+ * instantiated for their transducer count, with the transducer loop fully
+ * unrolled and the sums kept in registers. Larger arrays use the generic
+ * kernel, whose per transducer overhead is already spread over a row segment
+ * (unrolled 48-52 transducer kernels measured no faster, at 15x the compile time).
+ * @param allowFixedSize false forces the generic kernel (for comparisons)
+ */
+void renderSoundOnWallPrecision(
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		FieldPrecision precision,
+		FieldBuffer & img,
+		WorkerPool & pool,
+		bool allowFixedSize = true);
+
+/** @returns true if renderSoundOnWallPrecision() has a fixed size kernel for this many transducers (4 and 7). */
+bool hasFixedSizeFieldKernel(size_t numTransducers);
+
+/** Difference between a field and a (double precision) reference of the same size. */
+struct FieldError {
+	double maxAbsolute;
+	double maxRelative;  //!< maxAbsolute relative to the peak of the reference
+	double rmsRelative;  //!< rms difference relative to the peak of the reference
+};
+
+FieldError compareFields(FieldBuffer const & reference, FieldBuffer const & field);
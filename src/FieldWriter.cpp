@@ -0,0 +1,306 @@
+//
+// Copyright(C) 2014,2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "FieldWriter.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+namespace {
+	double maxValue(double const * img, size_t size)
+	{
+		double max_val = 0;
+		for (size_t i = 0; i < size; i++)
+		{
+			if (img[i] > max_val) {
+				max_val = img[i];
+			}
+		}
+		return max_val;
+	}
+
+	/** NPY version 1.0 header (little endian floats, like the hosts we run on), padded with spaces so that the data starts 64 byte aligned. */
+	std::string npyHeader(size_t w, size_t h)
+	{
+		std::ostringstream dict;
+		dict << "{'descr': '<f4', 'fortran_order': False, 'shape': (" << h << ", " << w << "), }";
+		std::string d = dict.str();
+
+		const size_t prefix = 10;  // magic, version and header length
+		size_t total = (prefix + d.size() + 1 + 63) / 64 * 64;
+		d.append(total - prefix - d.size() - 1, ' ');
+		d += '\n';
+
+		std::string header("\x93NUMPY\x01\x00", 8);
+		header += char(d.size() & 0xff);
+		header += char(d.size() >> 8);
+		return header + d;
+	}
+
+	/**
+	 * PFM header, a negative scale means little endian floats. The scale is
+	 * padded with zeros so that the floats after the header are 4 byte aligned. */
+	std::string pfmHeader(size_t w, size_t h)
+	{
+		std::ostringstream oss;
+		oss << "Pf\n" << w << " " << h << "\n-1.0";
+		std::string header = oss.str();
+		header.append(3 - header.size() % 4, '0');
+		return header + "\n";
+	}
+
+	std::string floatFieldHeader(FieldFormat format, size_t w, size_t h)
+	{
+		return format == FieldFormat::NPY ? npyHeader(w, h) : pfmHeader(w, h);
+	}
+
+	bool writeAll(int fd, void const * data, size_t size, off_t offset)
+	{
+		char const * p = static_cast<char const *>(data);
+		while (size)
+		{
+			ssize_t written = pwrite(fd, p, size, offset);
+			if (written <= 0)
+			{
+				return false;
+			}
+			p += written;
+			size -= written;
+			offset += written;
+		}
+		return true;
+	}
+}
+
+bool parseFieldFormat(std::string const & name, FieldFormat & format)
+{
+	if (name == "pgm") { format = FieldFormat::PGM; }
+	else if (name == "pgm16db") { format = FieldFormat::PGM16_DB; }
+	else if (name == "npy") { format = FieldFormat::NPY; }
+	else if (name == "pfm") { format = FieldFormat::PFM; }
+	else { return false; }
+	return true;
+}
+
+char const * fieldFormatExtension(FieldFormat format)
+{
+	switch (format)
+	{
+	case FieldFormat::NPY: return "npy";
+	case FieldFormat::PFM: return "pfm";
+	default: return "pgm";
+	}
+}
+
+bool writeFieldAsPgm(std::string const & filename, double const * img, int w, int h)
+{
+	double max_val = maxValue(img, size_t(w) * h);
+
+	std::vector<unsigned char> pixels(size_t(w) * h);
+	for (int i = 0; i < w*h; i++)
+	{
+		pixels[i] = (unsigned char)(img[i] * 255 / max_val);
+	}
+
+	std::ofstream imgFile(filename, std::ios::binary);
+	imgFile << "P5\n" << w << " " << h << "\n" << 255 << "\n";
+	imgFile.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+	return bool(imgFile);
+}
+
+bool writeFieldAsPgm(std::string const & filename, FieldBuffer const & img)
+{
+	return writeFieldAsPgm(filename, img.data(), img.width(), img.height());
+}
+
+bool writeFieldAsPgm16dB(std::string const & filename, FieldBuffer const & img, double dynamicRangedB)
+{
+	const double max_val = maxValue(img.data(), img.size());
+
+	// 16 bit PGM samples are big endian
+	std::vector<unsigned char> pixels(2 * img.size());
+	for (size_t i = 0; i < img.size(); i++)
+	{
+		double dB = 20 * std::log10(img.data()[i] / max_val);
+		double level = std::min(1.0, std::max(0.0, (dB + dynamicRangedB) / dynamicRangedB));
+		unsigned value = unsigned(level * 65535 + 0.5);
+		pixels[2 * i] = (unsigned char)(value >> 8);
+		pixels[2 * i + 1] = (unsigned char)(value & 0xff);
+	}
+
+	std::ofstream imgFile(filename, std::ios::binary);
+	imgFile << "P5\n" << img.width() << " " << img.height() << "\n" << 65535 << "\n";
+	imgFile.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+	return bool(imgFile);
+}
+
+bool writeField(std::string const & filename, FieldFormat format, FieldBuffer const & img, double dynamicRangedB)
+{
+	switch (format)
+	{
+	case FieldFormat::PGM:
+		return writeFieldAsPgm(filename, img);
+	case FieldFormat::PGM16_DB:
+		return writeFieldAsPgm16dB(filename, img, dynamicRangedB);
+	default:
+		{
+			FieldStreamWriter writer(filename, format, img.width(), img.height());
+			writer.writeRows(0, img.height(), img.data());
+			return writer.close();
+		}
+	}
+}
+
+FieldStreamWriter::FieldStreamWriter(std::string const & filename, FieldFormat format, int width, int height)
+: fd_(-1),
+	format_(format),
+	width_(width),
+	height_(height),
+	headerSize_(0),
+	ok_(format == FieldFormat::NPY || format == FieldFormat::PFM)
+{
+	if (!ok_)
+	{
+		return;
+	}
+
+	std::string header = floatFieldHeader(format, width, height);
+	headerSize_ = header.size();
+
+	fd_ = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	ok_ = fd_ >= 0 &&
+		ftruncate(fd_, headerSize_ + size_t(width) * height * sizeof(float)) == 0 &&
+		writeAll(fd_, header.data(), header.size(), 0);
+}
+
+FieldStreamWriter::~FieldStreamWriter()
+{
+	close();
+}
+
+void FieldStreamWriter::writeRows(int y0, int y1, double const * rows)
+{
+	if (fd_ < 0 || y1 <= y0)
+	{
+		return;
+	}
+
+	// PFM stores the bottom row first, so a band is written in reverse row order
+	const bool flip = format_ == FieldFormat::PFM;
+	const size_t numRows = y1 - y0;
+	std::vector<float> band(numRows * width_);
+	for (size_t r = 0; r < numRows; r++)
+	{
+		double const * src = rows + r * width_;
+		float* dst = band.data() + (flip ? numRows - 1 - r : r) * width_;
+		for (int x = 0; x < width_; x++)
+		{
+			dst[x] = float(src[x]);
+		}
+	}
+
+	const size_t firstRow = flip ? height_ - y1 : y0;
+	const off_t offset = headerSize_ + firstRow * width_ * sizeof(float);
+	if (!writeAll(fd_, band.data(), band.size() * sizeof(float), offset))
+	{
+		ok_ = false;
+	}
+}
+
+bool FieldStreamWriter::close()
+{
+	if (fd_ >= 0)
+	{
+		if (::close(fd_) != 0)
+		{
+			ok_ = false;
+		}
+		fd_ = -1;
+	}
+	return ok_;
+}
+
+MappedFieldFile::MappedFieldFile(std::string const & filename, FieldFormat format, size_t width, size_t height)
+: mapping_(nullptr),
+	mappingSize_(0),
+	pixels_(nullptr),
+	format_(format),
+	width_(width),
+	height_(height),
+	ok_(false)
+{
+	if (format != FieldFormat::NPY && format != FieldFormat::PFM)
+	{
+		return;
+	}
+
+	std::string header = floatFieldHeader(format, width, height);
+	int fd = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+	{
+		return;
+	}
+
+	const size_t size = header.size() + width * height * sizeof(float);
+	if (ftruncate(fd, size) == 0 && writeAll(fd, header.data(), header.size(), 0))
+	{
+		void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (mapping != MAP_FAILED)
+		{
+			mapping_ = mapping;
+			mappingSize_ = size;
+			pixels_ = reinterpret_cast<float*>(static_cast<char*>(mapping) + header.size());
+			ok_ = true;
+		}
+	}
+	::close(fd);
+}
+
+MappedFieldFile::~MappedFieldFile()
+{
+	close();
+}
+
+void MappedFieldFile::flushRows(size_t y0, size_t y1)
+{
+	if (!mapping_ || y1 <= y0)
+	{
+		return;
+	}
+
+	// In file order, PFM rows are stored bottom up
+	char* first = reinterpret_cast<char*>(row(format_ == FieldFormat::PFM ? y1 - 1 : y0));
+	char* last = first + (y1 - y0) * width_ * sizeof(float);
+
+	// msync() and madvise() want page aligned addresses. Pages shared with
+	// neighbouring rows are harmless: they are written back and mapped in again.
+	const size_t pageSize = sysconf(_SC_PAGESIZE);
+	char* base = static_cast<char*>(mapping_);
+	char* begin = base + (first - base) / pageSize * pageSize;
+	msync(begin, last - begin, MS_ASYNC);
+	madvise(begin, last - begin, MADV_DONTNEED);
+}
+
+bool MappedFieldFile::close()
+{
+	if (mapping_)
+	{
+		if (msync(mapping_, mappingSize_, MS_SYNC) != 0)
+		{
+			ok_ = false;
+		}
+		munmap(mapping_, mappingSize_);
+		mapping_ = nullptr;
+		pixels_ = nullptr;
+	}
+	return ok_;
+}
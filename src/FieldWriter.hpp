@@ -0,0 +1,113 @@
+//
+// Copyright(C) 2014,2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include "FieldBuffer.hpp"
+
+#include <atomic>
+#include <string>
+
+
+/** File formats a rendered field can be written in. */
+enum class FieldFormat {
+	PGM,       //!< 8 bit binary PGM, linear, scaled to the largest value
+	PGM16_DB,  //!< 16 bit binary PGM, in dB relative to the largest value (see writeFieldAsPgm16dB())
+	NPY,       //!< float32 numpy array of shape (height, width)
+	PFM        //!< float32 grayscale portable float map (rows stored bottom to top)
+};
+
+/** Parse "pgm", "pgm16db", "npy" or "pfm". */
+bool parseFieldFormat(std::string const & name, FieldFormat & format);
+
+/** File name extension (without dot) used for format. */
+char const * fieldFormatExtension(FieldFormat format);
+
+/**
+ * Write a rendered w x h field as an 8 bit PGM image, scaled so that the
+ * largest value becomes 255.
+ * @returns false if the file could not be written */
+bool writeFieldAsPgm(std::string const & filename, double const * img, int w, int h);
+
+bool writeFieldAsPgm(std::string const & filename, FieldBuffer const & img);
+
+/**
+ * Write a field as a 16 bit PGM image in dB: the largest value becomes 65535,
+ * and dynamicRangedB below it (and anything weaker) becomes 0.
+ * @returns false if the file could not be written */
+bool writeFieldAsPgm16dB(std::string const & filename, FieldBuffer const & img, double dynamicRangedB = 60);
+
+/** Write img in format (dynamicRangedB only applies to PGM16_DB). */
+bool writeField(std::string const & filename, FieldFormat format, FieldBuffer const & img, double dynamicRangedB = 60);
+
+/**
+ * Writer for the float formats (NPY and PFM) which takes the field a band of
+ * rows at a time, in any order, while the rest is still being rendered.
+ * Each band is converted to float32 and written with a single pwrite() at its
+ * place in the file, so writeRows() may be called from several threads at once.
+ */
+class FieldStreamWriter {
+	int fd_;
+	FieldFormat format_;
+	int width_;
+	int height_;
+	size_t headerSize_;
+	std::atomic<bool> ok_;
+public:
+	/** Creates filename and writes the header. format must be NPY or PFM. */
+	FieldStreamWriter(std::string const & filename, FieldFormat format, int width, int height);
+	~FieldStreamWriter();
+
+	FieldStreamWriter(FieldStreamWriter const &) = delete;
+	FieldStreamWriter& operator=(FieldStreamWriter const &) = delete;
+
+	/** Write rows [y0, y1), given as (y1 - y0) * width values starting with row y0. */
+	void writeRows(int y0, int y1, double const * rows);
+
+	/**
+	 * Close the file.
+	 * @returns false if the file could not be created or any write failed */
+	bool close();
+};
+
+/**
+ * NPY or PFM file of float32 pixels, created at its full size and memory
+ * mapped, so that fields far larger than memory can be stored into it tile by
+ * tile. Finished rows are handed to the kernel with flushRows(), which keeps
+ * only the rows being worked on resident.
+ */
+class MappedFieldFile {
+	void* mapping_;
+	size_t mappingSize_;
+	float* pixels_;
+	FieldFormat format_;
+	size_t width_;
+	size_t height_;
+	bool ok_;
+public:
+	/** Creates filename (format must be NPY or PFM) and maps it. */
+	MappedFieldFile(std::string const & filename, FieldFormat format, size_t width, size_t height);
+	~MappedFieldFile();
+
+	MappedFieldFile(MappedFieldFile const &) = delete;
+	MappedFieldFile& operator=(MappedFieldFile const &) = delete;
+
+	bool isOpen() const { return pixels_ != nullptr; }
+
+	size_t width() const { return width_; }
+	size_t height() const { return height_; }
+
+	/** width() pixels of row y (counted from the top, also for PFM). */
+	float* row(size_t y) { return pixels_ + (format_ == FieldFormat::PFM ? height_ - 1 - y : y) * width_; }
+
+	/**
+	 * Start writing rows [y0, y1) back to the file, and drop them from memory.
+	 * They are mapped in again if touched later. Safe to call from several threads. */
+	void flushRows(size_t y0, size_t y1);
+
+	/**
+	 * Write everything back and unmap the file.
+	 * @returns false if the file could not be created or written */
+	bool close();
+};
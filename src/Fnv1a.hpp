@@ -0,0 +1,59 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include "Transducer.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+/** Incremental 64 bit FNV-1a hash, used to name cache files after their contents. */
+class Fnv1a {
+	uint64_t hash_;
+public:
+	Fnv1a() : hash_(14695981039346656037ULL) {}
+
+	void add(void const * data, size_t size)
+	{
+		unsigned char const * bytes = static_cast<unsigned char const *>(data);
+		for (size_t i = 0; i < size; i++)
+		{
+			hash_ ^= bytes[i];
+			hash_ *= 1099511628211ULL;
+		}
+	}
+
+	void add(uint64_t value) { add(&value, sizeof(value)); }
+	void add(double value) { add(&value, sizeof(value)); }
+
+	/** Length prefixed, so that ("ab", "c") and ("a", "bc") differ */
+	void add(std::string const & s)
+	{
+		add(uint64_t(s.size()));
+		add(s.data(), s.size());
+	}
+
+	void add(std::vector<double> const & values)
+	{
+		add(uint64_t(values.size()));
+		add(values.data(), values.size() * sizeof(double));
+	}
+
+	/** Transducer positions */
+	void add(std::vector<Transducer> const & transducers)
+	{
+		add(uint64_t(transducers.size()));
+		for (Transducer const & t : transducers)
+		{
+			double pos[3] = { t.pos.x, t.pos.y, t.pos.z };
+			add(pos, sizeof(pos));
+		}
+	}
+
+	uint64_t value() const { return hash_; }
+};
@@ -11,5 +11,6 @@
 
 class ITransducerArray {
 public:
+	virtual ~ITransducerArray() {}
 	virtual const std::vector<Transducer>& getTransducers() const = 0;
 };
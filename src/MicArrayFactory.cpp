@@ -0,0 +1,44 @@
+//
+// Copyright(C) 2014,2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "MicArrayFactory.hpp"
+
+#include "arrays/DualRingTransducerArray.hpp"
+#include "arrays/HomogeneousTransducerArray.hpp"
+#include "arrays/RandomTransducerArray.hpp"
+#include "arrays/RectangularTransducerArray.hpp"
+#include "arrays/SingleRingTransducerArray.hpp"
+#include "arrays/SpiralTransducerArray.hpp"
+
+#include <ctime>
+#include <iostream>
+
+std::unique_ptr<ITransducerArray> createMicArray(int type)
+{
+	switch(MicArrayType(type))
+	{
+	case RING:
+		return std::unique_ptr<ITransducerArray>(new SingleRingTransducerArray(48, 0.25));
+	case RESPEAKER_4_MIC_FOR_RPI:
+		return std::unique_ptr<ITransducerArray>(new RectangularTransducerArray(2, 0.058, 2, 0.058));
+	case RESPEAKER_6_MIC_FOR_RPI:
+		return std::unique_ptr<ITransducerArray>(new SingleRingTransducerArray(7, 0.0925/2));
+	case DOUBLE_RING:
+		return std::unique_ptr<ITransducerArray>(new DualRingTransducerArray(32, 0.25, 16, 0.125));
+	case RECTANGULAR:
+		return std::unique_ptr<ITransducerArray>(new RectangularTransducerArray(7, 0.5/6, 7, 0.5/6));
+	case HOMO:
+		return std::unique_ptr<ITransducerArray>(new HomogeneousTransducerArray(52, 0.07));
+	case SPIRAL1:
+		return std::unique_ptr<ITransducerArray>(new SpiralTransducerArray(0.010, 0.0, 0.3, 3.7, 48));
+	case RANDOM:
+	{
+		long seed = time(NULL);
+		std::cout << "Random seed = " << seed << std::endl;
+		srand48(seed);
+		return std::unique_ptr<ITransducerArray>(new RandomTransducerArray(48, 0.5, 0.5));
+	}
+	}
+	return nullptr;
+}
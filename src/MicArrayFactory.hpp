@@ -0,0 +1,25 @@
+//
+// Copyright(C) 2014,2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include "ITransducerArray.hpp"
+
+#include <memory>
+
+
+/** The built-in mic array geometries (selected with -t). */
+enum MicArrayType {
+	RING = 0,
+	DOUBLE_RING = 1,
+	RECTANGULAR = 2,
+	HOMO = 3,
+	SPIRAL1 = 7,
+	RESPEAKER_6_MIC_FOR_RPI = 6,
+	RESPEAKER_4_MIC_FOR_RPI = 4,
+	RANDOM = 10,
+};
+
+/** @returns the mic array for type, or nullptr for unknown types. */
+std::unique_ptr<ITransducerArray> createMicArray(int type);
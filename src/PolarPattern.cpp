@@ -0,0 +1,80 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "PolarPattern.hpp"
+#include "FieldKernel.hpp"
+#include "RenderSound.hpp"
+#include "TransducerBlock.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+
+
+namespace {
+	/** Directions evaluated per job */
+	const size_t anglesPerJob = 1024;
+}
+
+double polarPatternAngle(size_t i, size_t numAngles)
+{
+	return i * 360.0 / (numAngles - 1); // -1 to actually get both 0 and 360 degrees
+}
+
+bool computePolarPattern(
+		double z,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		std::vector<double> & dB,
+		WorkerPool & pool,
+		size_t numAngles)
+{
+	if (numAngles < 2)
+	{
+		dB.clear();
+		return false;
+	}
+
+	TransducerBlock block(transducers);
+	dB.resize(numAngles);
+
+	const size_t numJobs = (numAngles + anglesPerJob - 1) / anglesPerJob;
+	pool.parallelFor(numJobs, [&](size_t job)
+	{
+		size_t end = std::min(numAngles, (job + 1) * anglesPerJob);
+		for (size_t i = job * anglesPerJob; i < end; i++)
+		{
+			double angle = polarPatternAngle(i, numAngles);
+			double x = z * cos(angle * M_PI / 180.0);
+			double y = z * sin(angle * M_PI / 180.0);
+			Pos listenerPos(x, 0, y);
+
+			dB[i] = phasorToRms(accumulateField(block, listenerPos, audioFrequency, speedOfSound));
+		}
+	});
+
+	double maxval = *std::max_element(dB.begin(), dB.end());
+	for (double & v : dB)
+	{
+		v = 10.0 * log10(v / maxval);
+	}
+	return true;
+}
+
+bool writePolarPatternText(std::string const & filename, std::vector<double> const & dB)
+{
+	std::unique_ptr<FILE, int(*)(FILE*)> file(fopen(filename.c_str(), "w"), fclose);
+	if (!file)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < dB.size(); i++)
+	{
+		fprintf(file.get(), "%.4f %.6f\n", polarPatternAngle(i, dB.size()), dB[i]);
+	}
+	return !ferror(file.get());
+}
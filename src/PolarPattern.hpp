@@ -0,0 +1,43 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include "Transducer.hpp"
+#include "WorkerPool.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+/** Default number of directions in a polar pattern. */
+const size_t polarPatternAngles = 20000;
+
+/** Angle (degrees) of direction i out of numAngles (at least 2), from 0 to 360 (both included). */
+double polarPatternAngle(size_t i, size_t numAngles);
+
+/**
+ * Sound level on a circle with radius z around the array, in the x-z plane
+ * (the plane plotted by renderSoundPolarPattern()).
+ *
+ * dB[i] is the level at polarPatternAngle(i, numAngles), relative to the
+ * loudest direction (so all values are <= 0). dB is resized to numAngles and
+ * can be reused between calls without reallocating. The directions are split
+ * over the threads in pool, and evaluated without any heap allocation.
+ * @returns false (leaving dB empty) if numAngles < 2 */
+bool computePolarPattern(
+		double z,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		std::vector<double> & dB,
+		WorkerPool & pool,
+		size_t numAngles = polarPatternAngles);
+
+/**
+ * Write a polar pattern as text, one "angle dB" line per direction.
+ * Much cheaper than drawing and encoding a png, and easy to plot elsewhere.
+ * @returns false if the file could not be written */
+bool writePolarPatternText(std::string const & filename, std::vector<double> const & dB);
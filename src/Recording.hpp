@@ -0,0 +1,46 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include "AlignedAllocator.hpp"
+
+#include <cstddef>
+
+
+/**
+ * Multichannel audio, as float samples in [-1, 1], stored planar (all samples
+ * of channel 0, then of channel 1, ...) with every channel 64 byte aligned.
+ */
+class Recording {
+	int samplerate_;
+	size_t numChannels_;
+	size_t numSamples_;
+	size_t stride_;
+	AlignedVector<float> data_;
+public:
+	Recording() : samplerate_(0), numChannels_(0), numSamples_(0), stride_(0) {}
+
+	Recording(int samplerate, size_t numChannels, size_t numSamples) : Recording()
+	{
+		resize(samplerate, numChannels, numSamples);
+	}
+
+	/** Reallocates (zero filled) for numChannels x numSamples. */
+	void resize(int samplerate, size_t numChannels, size_t numSamples)
+	{
+		samplerate_ = samplerate;
+		numChannels_ = numChannels;
+		numSamples_ = numSamples;
+		stride_ = (numSamples + 15) & ~size_t(15);
+		data_.assign(numChannels * stride_, 0.0f);
+	}
+
+	int samplerate() const { return samplerate_; }
+	size_t numChannels() const { return numChannels_; }
+	size_t numSamples() const { return numSamples_; }
+
+	float* channel(size_t i) { return data_.data() + i * stride_; }
+	float const * channel(size_t i) const { return data_.data() + i * stride_; }
+};
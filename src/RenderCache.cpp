@@ -0,0 +1,108 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "RenderCache.hpp"
+#include "Fnv1a.hpp"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+
+namespace {
+	const char fieldMagic[8] = "ACFLD1";
+
+	struct FieldHeader {
+		char magic[8];
+		uint64_t key;
+		uint64_t width;
+		uint64_t height;
+	};
+}
+
+uint64_t renderCacheKey(
+		std::string const & renderer,
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound)
+{
+	Fnv1a hash;
+	hash.add(renderCacheVersion);
+	hash.add(renderer);
+	hash.add(xvals);
+	hash.add(yvals);
+	hash.add(z);
+	hash.add(audioFrequency);
+	hash.add(transducers);
+	hash.add(speedOfSound);
+	return hash.value();
+}
+
+RenderCache::RenderCache(std::string const & directory)
+: directory_(directory)
+{
+	// no code
+}
+
+std::string RenderCache::filename(uint64_t key) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "field_%016llx.bin", (unsigned long long)key);
+	return directory_ + "/" + name;
+}
+
+bool RenderCache::load(uint64_t key, FieldBuffer & img) const
+{
+	std::ifstream in(filename(key), std::ios::binary);
+	FieldHeader header;
+	if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+		memcmp(header.magic, fieldMagic, sizeof(fieldMagic)) != 0 ||
+		header.key != key ||
+		header.width == 0 || header.height == 0 ||
+		header.width * header.height > (uint64_t(1) << 32))
+	{
+		return false;
+	}
+
+	img.resize(int(header.width), int(header.height));
+	if (!in.read(reinterpret_cast<char*>(img.data()), img.size() * sizeof(double)))
+	{
+		return false;
+	}
+
+	// Trailing data means the file is not what we wrote
+	return in.peek() == std::ifstream::traits_type::eof();
+}
+
+bool RenderCache::store(uint64_t key, FieldBuffer const & img) const
+{
+	FieldHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, fieldMagic, sizeof(header.magic));
+	header.key = key;
+	header.width = img.width();
+	header.height = img.height();
+
+	const std::string name = filename(key);
+	// Unique per process and call, so concurrent stores never write the same file
+	static std::atomic<unsigned> counter(0);
+	const std::string temporary = name + "." + std::to_string(getpid()) + "." + std::to_string(counter++) + ".tmp";
+	{
+		std::ofstream out(temporary, std::ios::binary);
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(reinterpret_cast<const char*>(img.data()), img.size() * sizeof(double));
+		if (!out)
+		{
+			remove(temporary.c_str());
+			return false;
+		}
+	}
+	return rename(temporary.c_str(), name.c_str()) == 0;
+}
@@ -0,0 +1,58 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include "FieldBuffer.hpp"
+#include "Transducer.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+/**
+ * Bumped whenever a renderer changes its output, so that results cached by
+ * an older build are never returned. */
+const uint64_t renderCacheVersion = 2;
+
+/**
+ * Key for one rendered field: hash of the renderer, the grid the field is
+ * evaluated over, the array geometry and the physical parameters.
+ * @param renderer name of the renderer, followed by any settings of its own
+ *        which change the result (e.g. "nufft:1e-06:avx2") */
+uint64_t renderCacheKey(
+		std::string const & renderer,
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound);
+
+/**
+ * Directory of rendered fields, one file per key (field_<key>.bin), holding
+ * the raw doubles so that a hit gives exactly the field that was rendered.
+ *
+ * Files are written under a temporary name and renamed into place, so
+ * concurrent runs sharing a directory never see a partial file.
+ */
+class RenderCache {
+	std::string directory_;
+public:
+	explicit RenderCache(std::string const & directory);
+
+	/** Name of the file holding key. */
+	std::string filename(uint64_t key) const;
+
+	/**
+	 * Fill img with the field cached under key.
+	 * @returns false (img unspecified) if there is no valid entry */
+	bool load(uint64_t key, FieldBuffer & img) const;
+
+	/**
+	 * Cache img under key.
+	 * @returns false if the file could not be written */
+	bool store(uint64_t key, FieldBuffer const & img) const;
+};
@@ -3,15 +3,34 @@
 //
 
 #include "RenderSound.hpp"
+#include "FieldKernel.hpp"
+#include "PolarPattern.hpp"
+#include "TransducerBlock.hpp"
 
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
 #include <opencv2/highgui.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <limits>
+#include <memory>
 
 
+std::vector<double> linspace(double first, double last, int N)
+{
+	std::vector<double> retval(N);
+
+	for (int i = 0; i < N; i++)
+	{
+		double alpha = i * 1.0 / (N-1);
+		retval[i] = (1-alpha) * first  +  alpha * last;
+	}
+
+	return retval;
+}
+
 std::vector<std::complex<double> >
 getPhasors(std::vector<Transducer> const & transducers, Pos const & listenerPos, double audioFrequency, double speedOfSound)
 {
@@ -27,7 +46,7 @@ getPhasors(std::vector<Transducer> const & transducers, Pos const & listenerPos,
 	return phasors;
 }
 
-std::complex<double> sumPhasors(std::vector<std::complex<double> > phasors)
+std::complex<double> sumPhasors(std::vector<std::complex<double> > const & phasors)
 {
 	std::complex<double> resultingPhasor = {};
 	for (auto const & phasor : phasors)
@@ -37,6 +56,62 @@ std::complex<double> sumPhasors(std::vector<std::complex<double> > phasors)
 	return resultingPhasor;
 }
 
+std::complex<double>
+accumulateField(std::vector<Transducer> const & transducers, Pos const & listenerPos, double audioFrequency, double speedOfSound)
+{
+	// Same arithmetic (and summation order) as sumPhasors(getPhasors(...)),
+	// so the results are bit-identical, but without any temporary vector.
+	double re = 0;
+	double im = 0;
+	for (size_t i = 0; i < transducers.size(); i++)
+	{
+		double distance = listenerPos.dist(transducers[i].pos);
+		double amplitude = 1.0 / sqr(distance);
+		double phase = 2 * M_PI * distance * audioFrequency / speedOfSound;
+		re += amplitude * cos(phase);
+		im += amplitude * sin(phase);
+	}
+	return std::complex<double>(re, im);
+}
+
+double phasorToRms(std::complex<double> const & phasor)
+{
+	return 1.0 / sqrt(2.0) * sqrt( sqr(phasor.real()) + sqr(phasor.imag()) );
+}
+
+namespace {
+	/** Edge length (in pixels) of the square tiles the wall is split into. */
+	const size_t wallTileSize = 64;
+
+	void renderWallTile(
+			const std::vector<double>& xvals,
+			const std::vector<double>& yvals,
+			double z,
+			double audioFrequency,
+			FieldKernelIsa isa,
+			TransducerBlock const & transducers,
+			const double speedOfSound,
+			double* img,
+			size_t imgStride,
+			size_t x0, size_t x1,
+			size_t y0, size_t y1)
+	{
+		for (size_t yind = y0; yind < y1; yind++)
+		{
+			double y = yvals[yind];
+			double* dst = img + (yind - y0) * imgStride;
+			for (size_t xind = x0; xind < x1; xind++)
+			{
+				double x = xvals[xind];
+
+				Pos listenerPos(x, y, z);
+
+				dst[xind - x0] = phasorToRms(accumulateField(isa, transducers, listenerPos, audioFrequency, speedOfSound));
+			}
+		}
+	}
+}
+
 /** 
  * Sample grid (x and y) determined by xvals and yvals
  * @param img destination location to store measured values (allocated by caller).
@@ -50,33 +125,173 @@ void renderSoundOnWall(
         const double speedOfSound,
 		double* img)
 {
-	const int w = xvals.size();
+	TransducerBlock block(transducers);
+	renderWallTile(xvals, yvals, z, audioFrequency, getFieldKernelIsa(), block, speedOfSound, img, xvals.size(),
+		0, xvals.size(), 0, yvals.size());
+}
 
-	for (size_t yind = 0; yind < yvals.size(); yind++)
+namespace {
+	void renderWallTiles(
+			const std::vector<double>& xvals,
+			const std::vector<double>& yvals,
+			double z,
+			double audioFrequency,
+			const std::vector<Transducer>& transducers,
+			const double speedOfSound,
+			double* img,
+			WorkerPool & pool,
+			std::function<void(int y0, int y1)> const * rowsDone)
 	{
-		double y = yvals[yind];
-		for (size_t xind = 0; xind < xvals.size(); xind++)
+		TransducerBlock block(transducers);
+		const FieldKernelIsa isa = getFieldKernelIsa();
+		const size_t tilesX = (xvals.size() + wallTileSize - 1) / wallTileSize;
+		const size_t tilesY = (yvals.size() + wallTileSize - 1) / wallTileSize;
+
+		// Tiles left to render in each band of rows
+		std::unique_ptr<std::atomic<size_t>[]> remaining(new std::atomic<size_t>[tilesY]);
+		for (size_t i = 0; i < tilesY; i++)
 		{
-			double x = xvals[xind];
+			remaining[i] = tilesX;
+		}
 
-			Pos listenerPos(x, y, z);
+		pool.parallelFor(tilesX * tilesY, [&](size_t tile)
+		{
+			size_t x0 = (tile % tilesX) * wallTileSize;
+			size_t y0 = (tile / tilesX) * wallTileSize;
+			size_t x1 = std::min(x0 + wallTileSize, xvals.size());
+			size_t y1 = std::min(y0 + wallTileSize, yvals.size());
 
-			std::vector<std::complex<double> > phasors = getPhasors(transducers, listenerPos, audioFrequency, speedOfSound);
-			std::complex<double> resultingPhasor = sumPhasors(phasors);
+			renderWallTile(xvals, yvals, z, audioFrequency, isa, block, speedOfSound,
+				img + y0 * xvals.size() + x0, xvals.size(), x0, x1, y0, y1);
 
-			double rms = 1.0 / sqrt(2.0) * sqrt( sqr(resultingPhasor.real()) + sqr(resultingPhasor.imag()) );
-			img[yind * w + xind] = rms;
-		}
+			if (rowsDone && --remaining[tile / tilesX] == 0)
+			{
+				(*rowsDone)(y0, y1);
+			}
+		});
 	}
 }
 
+void renderSoundOnWall(
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		double* img,
+		WorkerPool & pool)
+{
+	renderWallTiles(xvals, yvals, z, audioFrequency, transducers, speedOfSound, img, pool, nullptr);
+}
 
-// This is so fast that we don't need any optimizations
-void renderSoundPolarPattern(
-	double z,
-	double audioFrequency,
-	const std::vector<Transducer>& transducers,
-	const double speedOfSound,
+void renderSoundOnWall(
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		FieldBuffer & img)
+{
+	img.resize(xvals.size(), yvals.size());
+	renderSoundOnWall(xvals, yvals, z, audioFrequency, transducers, speedOfSound, img.data());
+}
+
+void renderSoundOnWall(
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		FieldBuffer & img,
+		WorkerPool & pool)
+{
+	img.resize(xvals.size(), yvals.size());
+	renderSoundOnWall(xvals, yvals, z, audioFrequency, transducers, speedOfSound, img.data(), pool);
+}
+
+void renderSoundOnWall(
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		FieldBuffer & img,
+		WorkerPool & pool,
+		std::function<void(int y0, int y1)> const & rowsDone)
+{
+	img.resize(xvals.size(), yvals.size());
+	renderWallTiles(xvals, yvals, z, audioFrequency, transducers, speedOfSound, img.data(), pool, &rowsDone);
+}
+
+bool renderSoundOnWallToFile(
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		std::string const & filename,
+		FieldFormat format,
+		WorkerPool & pool)
+{
+	MappedFieldFile file(filename, format, xvals.size(), yvals.size());
+	if (!file.isOpen())
+	{
+		return false;
+	}
+
+	TransducerBlock block(transducers);
+	const FieldKernelIsa isa = getFieldKernelIsa();
+	const size_t tilesX = (xvals.size() + wallTileSize - 1) / wallTileSize;
+	const size_t tilesY = (yvals.size() + wallTileSize - 1) / wallTileSize;
+
+	// Tiles left to render in each band of rows
+	std::unique_ptr<std::atomic<size_t>[]> remaining(new std::atomic<size_t>[tilesY]);
+	for (size_t i = 0; i < tilesY; i++)
+	{
+		remaining[i] = tilesX;
+	}
+
+	// One tile buffer per worker
+	std::vector<std::vector<double> > buffers(pool.getNumThreads(), std::vector<double>(wallTileSize * wallTileSize));
+
+	pool.parallelForWorker(tilesX * tilesY, [&](size_t tile, int worker)
+	{
+		std::vector<double> & buffer = buffers[worker];
+
+		size_t x0 = (tile % tilesX) * wallTileSize;
+		size_t y0 = (tile / tilesX) * wallTileSize;
+		size_t x1 = std::min(x0 + wallTileSize, xvals.size());
+		size_t y1 = std::min(y0 + wallTileSize, yvals.size());
+
+		renderWallTile(xvals, yvals, z, audioFrequency, isa, block, speedOfSound,
+			buffer.data(), wallTileSize, x0, x1, y0, y1);
+
+		for (size_t yind = y0; yind < y1; yind++)
+		{
+			double const * src = buffer.data() + (yind - y0) * wallTileSize;
+			float* dst = file.row(yind) + x0;
+			for (size_t xind = 0; xind < x1 - x0; xind++)
+			{
+				dst[xind] = float(src[xind]);
+			}
+		}
+
+		if (--remaining[tile / tilesX] == 0)
+		{
+			file.flushRows(y0, y1);
+		}
+	});
+
+	return file.close();
+}
+
+bool drawPolarPattern(
+	std::vector<double> const & dB,
 	std::string const & title,
 	std::string const & filename)
 {
@@ -98,12 +313,12 @@ void renderSoundPolarPattern(
 
 	for (int i = 1; i < 6; i++)
 	{
-		double dB = -i * 5;
+		double ringdB = -i * 5;
 		std::ostringstream oss;
 		oss << -i*5 << "dB";
 		cv::putText(img,
 			oss.str().c_str(),
-			cv::Point2i(w/2 + 5, center.y - dBToRadii(dB)),
+			cv::Point2i(w/2 + 5, center.y - dBToRadii(ringdB)),
 			/* font */ 0,
 			/* scale */ 0.67,
 			cv::Scalar(0, 0, 0),
@@ -124,31 +339,12 @@ void renderSoundPolarPattern(
 		);
 	}
 
-	std::vector<double> vals(20000);
-	for (size_t i = 0; i < vals.size(); i++)
-	{
-		double angle = i * 360.0 / (vals.size() - 1); // -1 to actually get both 0 and 360 degrees
-		double x = z * cos(angle * M_PI / 180.0);
-		double y = z * sin(angle * M_PI / 180.0);
-		Pos listenerPos(x, 0, y);
-
-		std::vector<std::complex<double> > phasors = getPhasors(transducers, listenerPos, audioFrequency, speedOfSound);
-		std::complex<double> resultingPhasor = sumPhasors(phasors);
-
-		double rms = 1.0 / sqrt(2.0) * sqrt( sqr(resultingPhasor.real()) + sqr(resultingPhasor.imag()) );
-		vals[i] = rms;
-	}
-
-	double maxval = *std::max_element(vals.begin(), vals.end());
-
 	bool firstPoint = true;
 	cv::Point2d last(0, 0);
-	for (size_t i = 0; i < vals.size(); i++)
+	for (size_t i = 0; i < dB.size(); i++)
 	{
-		double angle = i * 360.0 / (vals.size() - 1); // -1 to actually get both 0 and 360 degrees
-		double relativeVal = vals[i] / maxval; // range 0 .. 1
-		double scaleddB = 10.0 * log10(relativeVal);
-		double scaledVal = dBToRadii(scaleddB);
+		double angle = polarPatternAngle(i, dB.size());
+		double scaledVal = dBToRadii(dB[i]);
 
 		double x = scaledVal * cos(angle * M_PI / 180) + center.x;
 		double y = scaledVal * sin(angle * M_PI / 180) + center.y;
@@ -167,5 +363,31 @@ void renderSoundPolarPattern(
 	}
 	//cv::imshow("polar", img);
 	//cv::waitKey(0);
-	cv::imwrite(filename, img);
+	return cv::imwrite(filename, img);
+}
+
+bool renderSoundPolarPattern(
+	double z,
+	double audioFrequency,
+	const std::vector<Transducer>& transducers,
+	const double speedOfSound,
+	std::string const & title,
+	std::string const & filename,
+	WorkerPool & pool)
+{
+	std::vector<double> dB;
+	return computePolarPattern(z, audioFrequency, transducers, speedOfSound, dB, pool) &&
+		drawPolarPattern(dB, title, filename);
+}
+
+bool renderSoundPolarPattern(
+	double z,
+	double audioFrequency,
+	const std::vector<Transducer>& transducers,
+	const double speedOfSound,
+	std::string const & title,
+	std::string const & filename)
+{
+	WorkerPool pool(1);
+	return renderSoundPolarPattern(z, audioFrequency, transducers, speedOfSound, title, filename, pool);
 }
@@ -4,19 +4,38 @@
 
 #pragma once
 
+#include "FieldBuffer.hpp"
+#include "FieldWriter.hpp"
 #include "Transducer.hpp"
+#include "WorkerPool.hpp"
 
 #include <complex>
+#include <functional>
 #include <string>
 #include <vector>
 
 
+/** N evenly spaced values from first to last (both included). */
+std::vector<double> linspace(double first, double last, int N);
+
+/** Phasor from each transducer at listenerPos (mostly kept for tests). */
 std::vector<std::complex<double> >
 getPhasors(std::vector<Transducer> const & transducers, Pos const & listenerPos, double audioFrequency, double speedOfSound);
 
-std::complex<double> sumPhasors(std::vector<std::complex<double> > phasors);
+std::complex<double> sumPhasors(std::vector<std::complex<double> > const & phasors);
+
+/**
+ * Fused sumPhasors(getPhasors(...)): the resulting phasor at listenerPos,
+ * computed without any heap allocation. Gives bit-identical results. */
+std::complex<double>
+accumulateField(std::vector<Transducer> const & transducers, Pos const & listenerPos, double audioFrequency, double speedOfSound);
+
+/** RMS value of a sinusoid described by phasor. */
+double phasorToRms(std::complex<double> const & phasor);
 
-/** First naive renderer. */
+/**
+ * First naive renderer.
+ * Uses the field kernel selected by setFieldKernelIsa() (see FieldKernel.hpp). */
 void renderSoundOnWall(
 		const std::vector<double>& xvals,
 		const std::vector<double>& yvals,
@@ -26,7 +45,95 @@ void renderSoundOnWall(
         const double speedOfSound,
 		double* img);
 
-void renderSoundPolarPattern(
+/**
+ * Same as above, but the wall is split into tiles which are rendered in
+ * parallel by the threads in pool. The result is bit-identical to the serial
+ * version. */
+void renderSoundOnWall(
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		double* img,
+		WorkerPool & pool);
+
+/** Renders into img, which is resized to xvals.size() x yvals.size(). */
+void renderSoundOnWall(
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		FieldBuffer & img);
+
+void renderSoundOnWall(
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		FieldBuffer & img,
+		WorkerPool & pool);
+
+/**
+ * Same as above, calling rowsDone(y0, y1) as soon as all tiles of the band of
+ * rows [y0, y1) are rendered, e.g. to write them out while the rest of the wall
+ * is still being rendered. Called from the worker thread which finished the
+ * band, so bands are reported out of order and concurrently. */
+void renderSoundOnWall(
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		FieldBuffer & img,
+		WorkerPool & pool,
+		std::function<void(int y0, int y1)> const & rowsDone);
+
+/**
+ * Out-of-core renderSoundOnWall() for walls too large for memory (like 65536^2).
+ * Each tile is rendered into a small per-worker buffer and stored as float32
+ * straight into a memory mapped NPY or PFM file (see MappedFieldFile). Every
+ * finished band of rows is flushed and dropped, so only about one band per
+ * thread is resident, whatever the size of the wall.
+ * @returns false if format is not NPY or PFM, or the file could not be written */
+bool renderSoundOnWallToFile(
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		std::string const & filename,
+		FieldFormat format,
+		WorkerPool & pool);
+
+/**
+ * Plot a polar pattern from computePolarPattern() (see PolarPattern.hpp),
+ * with rings every 5 dB down to -30 dB, and write it as an image.
+ * @returns false if the image could not be written */
+bool drawPolarPattern(
+		std::vector<double> const & dB,
+		std::string const & title,
+		std::string const & filename);
+
+/** computePolarPattern() followed by drawPolarPattern(). */
+bool renderSoundPolarPattern(
+		double z,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		std::string const & title,
+		std::string const & filename,
+		WorkerPool & pool);
+
+/** Same as above, single threaded. */
+bool renderSoundPolarPattern(
 		double z,
 		double audioFrequency,
 		const std::vector<Transducer>& transducers,
@@ -0,0 +1,240 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "RenderSoundAdaptive.hpp"
+#include "FieldKernel.hpp"
+#include "RenderSound.hpp"
+#include "TransducerBlock.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+
+namespace {
+	enum SampleState : unsigned char {
+		EMPTY = 0,
+		INTERPOLATED = 1,
+		EXACT = 2
+	};
+
+	/** Samples of one coarse cell, including its right and bottom edges. */
+	class CellSampler {
+		std::vector<double> const & xvals_;
+		std::vector<double> const & yvals_;
+		double z_;
+		double audioFrequency_;
+		double speedOfSound_;
+		FieldKernelIsa isa_;
+		TransducerBlock const & block_;
+
+		size_t x0_, y0_;
+		size_t stride_;
+		std::vector<double> value_;
+		std::vector<unsigned char> state_;
+	public:
+		size_t evaluations;
+
+		CellSampler(
+				std::vector<double> const & xvals,
+				std::vector<double> const & yvals,
+				double z,
+				double audioFrequency,
+				double speedOfSound,
+				FieldKernelIsa isa,
+				TransducerBlock const & block)
+		: xvals_(xvals), yvals_(yvals), z_(z), audioFrequency_(audioFrequency), speedOfSound_(speedOfSound),
+			isa_(isa), block_(block), x0_(0), y0_(0), stride_(0), evaluations(0)
+		{
+			// no code
+		}
+
+		/** Start on the cell with top left pixel (x0, y0), w x h pixels including its far edges. */
+		void reset(size_t x0, size_t y0, size_t w, size_t h)
+		{
+			x0_ = x0;
+			y0_ = y0;
+			stride_ = w;
+			value_.assign(w * h, 0.0);
+			state_.assign(w * h, EMPTY);
+		}
+
+		/** Set an exact sample which is already known (cell corners). */
+		void set(size_t x, size_t y, double v)
+		{
+			value_[y * stride_ + x] = v;
+			state_[y * stride_ + x] = EXACT;
+		}
+
+		/** Exact field at cell pixel (x, y), evaluated once. */
+		double sample(size_t x, size_t y)
+		{
+			size_t i = y * stride_ + x;
+			if (state_[i] != EXACT)
+			{
+				Pos listenerPos(xvals_[x0_ + x], yvals_[y0_ + y], z_);
+				value_[i] = phasorToRms(accumulateField(isa_, block_, listenerPos, audioFrequency_, speedOfSound_));
+				state_[i] = EXACT;
+				evaluations++;
+			}
+			return value_[i];
+		}
+
+		/** Bilinear interpolation over [x0, x1] x [y0, y1] of the pixels not sampled exactly. */
+		void interpolate(size_t x0, size_t y0, size_t x1, size_t y1)
+		{
+			const double c00 = value_[y0 * stride_ + x0];
+			const double c10 = value_[y0 * stride_ + x1];
+			const double c01 = value_[y1 * stride_ + x0];
+			const double c11 = value_[y1 * stride_ + x1];
+			for (size_t y = y0; y <= y1; y++)
+			{
+				double ty = y1 == y0 ? 0.0 : double(y - y0) / (y1 - y0);
+				for (size_t x = x0; x <= x1; x++)
+				{
+					size_t i = y * stride_ + x;
+					if (state_[i] != EXACT)
+					{
+						double tx = x1 == x0 ? 0.0 : double(x - x0) / (x1 - x0);
+						value_[i] = (1 - ty) * ((1 - tx) * c00 + tx * c10) + ty * ((1 - tx) * c01 + tx * c11);
+						state_[i] = INTERPOLATED;
+					}
+				}
+			}
+		}
+
+		/** Cell pixel (x, y), which must have been sampled or interpolated. */
+		double at(size_t x, size_t y) const { return value_[y * stride_ + x]; }
+	};
+
+	/** Fill [x0, x1] x [y0, y1], whose corners are sampled. */
+	void refine(CellSampler & cell, size_t x0, size_t y0, size_t x1, size_t y1, double threshold)
+	{
+		if (x1 - x0 <= 2 && y1 - y0 <= 2)
+		{
+			// Every pixel is a sample point at this size
+			for (size_t y = y0; y <= y1; y++)
+			{
+				for (size_t x = x0; x <= x1; x++)
+				{
+					cell.sample(x, y);
+				}
+			}
+			return;
+		}
+
+		const size_t mx = (x0 + x1) / 2;
+		const size_t my = (y0 + y1) / 2;
+		const double c00 = cell.at(x0, y0);
+		const double c10 = cell.at(x1, y0);
+		const double c01 = cell.at(x0, y1);
+		const double c11 = cell.at(x1, y1);
+		const double tx = x1 == x0 ? 0.0 : double(mx - x0) / (x1 - x0);
+		const double ty = y1 == y0 ? 0.0 : double(my - y0) / (y1 - y0);
+
+		// Compare the edge midpoints and the center with the bilinear prediction
+		double error = std::fabs(cell.sample(mx, y0) - ((1 - tx) * c00 + tx * c10));
+		error = std::max(error, std::fabs(cell.sample(mx, y1) - ((1 - tx) * c01 + tx * c11)));
+		error = std::max(error, std::fabs(cell.sample(x0, my) - ((1 - ty) * c00 + ty * c01)));
+		error = std::max(error, std::fabs(cell.sample(x1, my) - ((1 - ty) * c10 + ty * c11)));
+		error = std::max(error, std::fabs(cell.sample(mx, my) -
+			((1 - ty) * ((1 - tx) * c00 + tx * c10) + ty * ((1 - tx) * c01 + tx * c11))));
+
+		if (error > threshold)
+		{
+			refine(cell, x0, y0, mx, my, threshold);
+			refine(cell, mx, y0, x1, my, threshold);
+			refine(cell, x0, my, mx, y1, threshold);
+			refine(cell, mx, my, x1, y1, threshold);
+		}
+		else
+		{
+			cell.interpolate(x0, y0, mx, my);
+			cell.interpolate(mx, y0, x1, my);
+			cell.interpolate(x0, my, mx, y1);
+			cell.interpolate(mx, my, x1, y1);
+		}
+	}
+}
+
+size_t renderSoundOnWallAdaptive(
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		double tolerance,
+		FieldBuffer & img,
+		WorkerPool & pool)
+{
+	const size_t w = xvals.size();
+	const size_t h = yvals.size();
+	img.resize(w, h);
+	if (w == 0 || h == 0)
+	{
+		return 0;
+	}
+
+	TransducerBlock block(transducers);
+	const FieldKernelIsa isa = getFieldKernelIsa();
+
+	// Cell edges: every adaptiveCoarseStep pixels, and the last pixel
+	std::vector<size_t> edgesX;
+	std::vector<size_t> edgesY;
+	for (size_t x = 0; x < w - 1; x += adaptiveCoarseStep) { edgesX.push_back(x); }
+	for (size_t y = 0; y < h - 1; y += adaptiveCoarseStep) { edgesY.push_back(y); }
+	edgesX.push_back(w - 1);
+	edgesY.push_back(h - 1);
+	const size_t cellsX = std::max<size_t>(1, edgesX.size() - 1);
+	const size_t cellsY = std::max<size_t>(1, edgesY.size() - 1);
+
+	// Coarse grid, shared by the cells
+	std::vector<double> coarse(edgesX.size() * edgesY.size());
+	pool.parallelFor(edgesY.size(), [&](size_t j)
+	{
+		for (size_t i = 0; i < edgesX.size(); i++)
+		{
+			Pos listenerPos(xvals[edgesX[i]], yvals[edgesY[j]], z);
+			coarse[j * edgesX.size() + i] = phasorToRms(accumulateField(isa, block, listenerPos, audioFrequency, speedOfSound));
+		}
+	});
+	const double threshold = tolerance * *std::max_element(coarse.begin(), coarse.end());
+
+	std::atomic<size_t> evaluations(coarse.size());
+	pool.parallelFor(cellsX * cellsY, [&](size_t c)
+	{
+		const size_t i = c % cellsX;
+		const size_t j = c / cellsX;
+		const size_t x0 = edgesX[i];
+		const size_t y0 = edgesY[j];
+		const size_t x1 = edgesX[std::min(i + 1, edgesX.size() - 1)];
+		const size_t y1 = edgesY[std::min(j + 1, edgesY.size() - 1)];
+		const size_t i1 = std::min(i + 1, edgesX.size() - 1);
+		const size_t j1 = std::min(j + 1, edgesY.size() - 1);
+
+		CellSampler cell(xvals, yvals, z, audioFrequency, speedOfSound, isa, block);
+		cell.reset(x0, y0, x1 - x0 + 1, y1 - y0 + 1);
+		cell.set(0, 0, coarse[j * edgesX.size() + i]);
+		cell.set(x1 - x0, 0, coarse[j * edgesX.size() + i1]);
+		cell.set(0, y1 - y0, coarse[j1 * edgesX.size() + i]);
+		cell.set(x1 - x0, y1 - y0, coarse[j1 * edgesX.size() + i1]);
+		refine(cell, 0, 0, x1 - x0, y1 - y0, threshold);
+
+		// The right and bottom edges belong to the next cell, except at the border of the wall
+		const size_t xEnd = x1 == w - 1 ? x1 : x1 - 1;
+		const size_t yEnd = y1 == h - 1 ? y1 : y1 - 1;
+		for (size_t y = y0; y <= yEnd; y++)
+		{
+			double* dst = img.row(y);
+			for (size_t x = x0; x <= xEnd; x++)
+			{
+				dst[x] = cell.at(x - x0, y - y0);
+			}
+		}
+		evaluations += cell.evaluations;
+	});
+
+	return evaluations;
+}
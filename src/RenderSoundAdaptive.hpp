@@ -0,0 +1,45 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include "FieldBuffer.hpp"
+#include "Transducer.hpp"
+#include "WorkerPool.hpp"
+
+#include <cstddef>
+#include <vector>
+
+
+/** Spacing (in pixels) of the coarse grid the adaptive renderer starts from. */
+const size_t adaptiveCoarseStep = 16;
+
+/** Default error target of renderSoundOnWallAdaptive(), relative to the peak (below one 8 bit PGM step). */
+const double adaptiveDefaultTolerance = 1e-3;
+
+/**
+ * renderSoundOnWall() evaluating the field only where it changes fast.
+ *
+ * The field is first evaluated on a grid with adaptiveCoarseStep pixel spacing.
+ * Every cell is then checked by evaluating its edge midpoints and center: if
+ * they are within tolerance * (peak of the coarse grid) of the bilinear
+ * interpolation from the corners, the four quadrants are filled by bilinear
+ * interpolation from those 9 samples. Otherwise the quadrants are checked the
+ * same way, recursively, down to single pixels. Smooth areas thus cost a few
+ * evaluations per cell, while nulls and lobe edges are evaluated exactly.
+ * The check only bounds the error at the checked points, the interpolated
+ * pixels in between typically stay within a few times tolerance * peak.
+ *
+ * The cells are rendered in parallel by the threads in pool.
+ * @returns number of field evaluations used (w * h for a full render) */
+size_t renderSoundOnWallAdaptive(
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		double tolerance,
+		FieldBuffer & img,
+		WorkerPool & pool);
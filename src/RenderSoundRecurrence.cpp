@@ -0,0 +1,210 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "RenderSoundRecurrence.hpp"
+#include "RenderSound.hpp"
+#include "TransducerBlock.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace {
+	const size_t tileSize = 64;
+
+	/** exp(i*eps) for |eps| <= recurrenceMaxTaylorStep, error < |eps|^12/12! */
+	inline void expiTaylor(double eps, double & c, double & s)
+	{
+		double e2 = eps * eps;
+		c = 1 + e2 * (-1.0/2 + e2 * (1.0/24 + e2 * (-1.0/720 + e2 * (1.0/40320 + e2 * (-1.0/3628800)))));
+		s = eps * (1 + e2 * (-1.0/6 + e2 * (1.0/120 + e2 * (-1.0/5040 + e2 * (1.0/362880 + e2 * (-1.0/39916800))))));
+	}
+
+	/** Per-transducer recurrence state for one row segment. */
+	struct RowState {
+		AlignedVector<double> dyz2;   // (y - ty)^2 + (z - tz)^2
+		AlignedVector<double> d;      // distance at the previous pixel
+		AlignedVector<double> delta;  // phase step into the previous pixel
+		AlignedVector<double> pRe, pIm;
+		AlignedVector<double> rRe, rIm;
+		AlignedVector<double> amp;
+		AlignedVector<double> eps;
+
+		explicit RowState(size_t n)
+		: dyz2(n), d(n), delta(n), pRe(n), pIm(n), rRe(n), rIm(n), amp(n), eps(n)
+		{
+			// no code
+		}
+	};
+
+	/**
+	 * Advance all transducers one pixel with the Taylor rotation step.
+	 * Branch (and reduction) free, so that it vectorizes. */
+	void incrementalStep(
+			size_t M, double x, double k,
+			double const * __restrict tx,
+			double const * __restrict dyz2,
+			double* __restrict d,
+			double* __restrict delta,
+			double* __restrict pRe,
+			double* __restrict pIm,
+			double* __restrict rRe,
+			double* __restrict rIm,
+			double* __restrict amp,
+			double* __restrict eps)
+	{
+		for (size_t j = 0; j < M; j++)
+		{
+			double d2 = sqr(x - tx[j]) + dyz2[j];
+			double dNew = std::sqrt(d2);
+			double deltaNew = k * (dNew - d[j]);
+			double e = deltaNew - delta[j];
+
+			double cosEps, sinEps;
+			expiTaylor(e, cosEps, sinEps);
+			double rReNew = rRe[j] * cosEps - rIm[j] * sinEps;
+			double rImNew = rRe[j] * sinEps + rIm[j] * cosEps;
+			double pReNew = pRe[j] * rReNew - pIm[j] * rImNew;
+			double pImNew = pRe[j] * rImNew + pIm[j] * rReNew;
+
+			rRe[j] = rReNew;
+			rIm[j] = rImNew;
+			pRe[j] = pReNew;
+			pIm[j] = pImNew;
+			d[j] = dNew;
+			delta[j] = deltaNew;
+			amp[j] = 1.0 / d2;
+			eps[j] = e;
+		}
+	}
+
+	void renderRow(
+			TransducerBlock const & block,
+			double const * xs, size_t count,
+			double y, double z, double k,
+			RowState & st,
+			double* dst)
+	{
+		const size_t M = block.size();
+		double const * tx = block.x();
+		double const * ty = block.y();
+		double const * tz = block.z();
+
+		for (size_t j = 0; j < M; j++)
+		{
+			st.dyz2[j] = sqr(y - ty[j]) + sqr(z - tz[j]);
+		}
+
+		for (size_t c = 0; c < count; c++)
+		{
+			const double x = xs[c];
+			const size_t sinceAnchor = c % recurrenceAnchorInterval;
+
+			if (sinceAnchor == 0)
+			{
+				// Exact phasor
+				for (size_t j = 0; j < M; j++)
+				{
+					double d2 = sqr(x - tx[j]) + st.dyz2[j];
+					double d = std::sqrt(d2);
+					st.d[j] = d;
+					st.amp[j] = 1.0 / d2;
+					st.pRe[j] = cos(k * d);
+					st.pIm[j] = sin(k * d);
+				}
+			}
+			else if (sinceAnchor == 1)
+			{
+				// Exact rotation
+				for (size_t j = 0; j < M; j++)
+				{
+					double d2 = sqr(x - tx[j]) + st.dyz2[j];
+					double d = std::sqrt(d2);
+					double delta = k * (d - st.d[j]);
+					st.rRe[j] = cos(delta);
+					st.rIm[j] = sin(delta);
+
+					double pRe = st.pRe[j] * st.rRe[j] - st.pIm[j] * st.rIm[j];
+					double pIm = st.pRe[j] * st.rIm[j] + st.pIm[j] * st.rRe[j];
+					st.pRe[j] = pRe;
+					st.pIm[j] = pIm;
+					st.d[j] = d;
+					st.delta[j] = delta;
+					st.amp[j] = 1.0 / d2;
+				}
+			}
+			else
+			{
+				incrementalStep(M, x, k, tx, st.dyz2.data(), st.d.data(), st.delta.data(),
+					st.pRe.data(), st.pIm.data(), st.rRe.data(), st.rIm.data(), st.amp.data(), st.eps.data());
+
+				for (size_t j = 0; j < M; j++)
+				{
+					if (std::fabs(st.eps[j]) > recurrenceMaxTaylorStep)
+					{
+						// Grid too coarse here for the Taylor step, re-anchor this transducer
+						st.rRe[j] = cos(st.delta[j]);
+						st.rIm[j] = sin(st.delta[j]);
+						st.pRe[j] = cos(k * st.d[j]);
+						st.pIm[j] = sin(k * st.d[j]);
+					}
+				}
+			}
+
+			double re = 0;
+			double im = 0;
+			for (size_t j = 0; j < M; j++)
+			{
+				re += st.amp[j] * st.pRe[j];
+				im += st.amp[j] * st.pIm[j];
+			}
+			dst[c] = phasorToRms(std::complex<double>(re, im));
+		}
+	}
+}
+
+void renderSoundOnWallRecurrence(
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		double* img,
+		WorkerPool & pool)
+{
+	TransducerBlock block(transducers);
+	const double k = 2 * M_PI * audioFrequency / speedOfSound;
+	const size_t w = xvals.size();
+	const size_t tilesX = (xvals.size() + tileSize - 1) / tileSize;
+	const size_t tilesY = (yvals.size() + tileSize - 1) / tileSize;
+
+	pool.parallelFor(tilesX * tilesY, [&](size_t tile)
+	{
+		size_t x0 = (tile % tilesX) * tileSize;
+		size_t y0 = (tile / tilesX) * tileSize;
+		size_t x1 = std::min(x0 + tileSize, xvals.size());
+		size_t y1 = std::min(y0 + tileSize, yvals.size());
+
+		RowState state(block.size());
+		for (size_t yind = y0; yind < y1; yind++)
+		{
+			renderRow(block, &xvals[x0], x1 - x0, yvals[yind], z, k, state, img + yind * w + x0);
+		}
+	});
+}
+
+void renderSoundOnWallRecurrence(
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		FieldBuffer & img,
+		WorkerPool & pool)
+{
+	img.resize(xvals.size(), yvals.size());
+	renderSoundOnWallRecurrence(xvals, yvals, z, audioFrequency, transducers, speedOfSound, img.data(), pool);
+}
@@ -0,0 +1,61 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include "FieldBuffer.hpp"
+#include "Transducer.hpp"
+#include "WorkerPool.hpp"
+
+#include <vector>
+
+
+/** Number of pixels between exact evaluations along a row. */
+const int recurrenceAnchorInterval = 32;
+
+/** Largest second phase difference (radians) handled by the Taylor step. */
+const double recurrenceMaxTaylorStep = 0.25;
+
+
+/**
+ * Fast-path version of renderSoundOnWall() which avoids most sin/cos calls.
+ *
+ * Along each row the phasor of every transducer is updated incrementally:
+ * with d[n] the (exactly computed) distance at pixel n, and
+ * delta[n] = k * (d[n] - d[n-1]) the phase step,
+ *
+ *   r[n] = r[n-1] * exp(i * (delta[n] - delta[n-1]))    (rotation per pixel)
+ *   p[n] = p[n-1] * r[n]                                (phasor)
+ *
+ * The second difference of the phase is small on a smooth grid (|eps| <~ k*dx^2/z),
+ * so exp(i*eps) is evaluated with a degree 11 Taylor polynomial. p and r are
+ * re-anchored with exact sin/cos every recurrenceAnchorInterval pixels, and
+ * immediately whenever |eps| exceeds recurrenceMaxTaylorStep (coarse grids).
+ *
+ * Error bound: the Taylor truncation is below |eps|^12/12! < 2e-16 per step,
+ * and each step adds a few ulps of rounding to r and p, which grow at most
+ * quadratically between anchors. With an anchor interval of 32 every phasor
+ * stays within ~1e-12 (relative) of exact, so each pixel is within
+ * 1e-11 * sum(1/d_i^2) of renderSoundOnWall(), far below the 1e-9 target.
+ * xvals do not have to be evenly spaced.
+ */
+void renderSoundOnWallRecurrence(
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		double* img,
+		WorkerPool & pool);
+
+void renderSoundOnWallRecurrence(
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		double audioFrequency,
+		const std::vector<Transducer>& transducers,
+		const double speedOfSound,
+		FieldBuffer & img,
+		WorkerPool & pool);
@@ -0,0 +1,78 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "SceneSimulator.hpp"
+
+#include <algorithm>
+
+
+SceneSimulator::SceneSimulator(std::vector<FakePointSoundSource> const & sources, std::vector<Transducer> const & mics, int samplerate)
+: sources_(sources),
+	numChannels_(mics.size()),
+	samplerate_(samplerate)
+{
+	std::vector<Pos> positions;
+	for (auto const & mic : mics)
+	{
+		positions.push_back(mic.pos);
+	}
+
+	for (auto const & source : sources_)
+	{
+		responses_.push_back(source.getResponse(positions));
+	}
+}
+
+SceneSimulator::SceneSimulator(std::vector<FakePointSoundSource> const & sources, ITransducerArray const & array, int samplerate)
+: SceneSimulator(sources, array.getTransducers(), samplerate)
+{
+	// no code
+}
+
+void SceneSimulator::render(int64_t firstSample, double* out, size_t numSamples, SampleLayout layout, WorkerPool & pool) const
+{
+	// Interleaved rows are kept whole, so that jobs do not share cache lines
+	const size_t micsPerJob = layout == SampleLayout::PLANAR ? sceneMicsPerJob : std::max<size_t>(numChannels_, 1);
+	const size_t micGroups = (numChannels_ + micsPerJob - 1) / micsPerJob;
+	const size_t timeBlocks = (numSamples + sceneBlockSamples - 1) / sceneBlockSamples;
+
+	pool.parallelFor(micGroups * timeBlocks, [&](size_t job)
+	{
+		size_t ch0 = (job % micGroups) * micsPerJob;
+		size_t ch1 = std::min(ch0 + micsPerJob, numChannels_);
+		size_t n0 = (job / micGroups) * sceneBlockSamples;
+		size_t n1 = std::min(n0 + sceneBlockSamples, numSamples);
+
+		double* dst;
+		size_t stride;
+		if (layout == SampleLayout::PLANAR)
+		{
+			dst = out + ch0 * numSamples + n0;
+			stride = numSamples;
+			for (size_t ch = ch0; ch < ch1; ch++)
+			{
+				std::fill(out + ch * numSamples + n0, out + ch * numSamples + n1, 0.0);
+			}
+		}
+		else
+		{
+			dst = out + n0 * numChannels_ + ch0;
+			stride = numChannels_;
+			std::fill(out + n0 * numChannels_, out + n1 * numChannels_, 0.0);
+		}
+
+		for (size_t i = 0; i < sources_.size(); i++)
+		{
+			sources_[i].addSamples(responses_[i], ch0, ch1, samplerate_, firstSample + int64_t(n0),
+					dst, n1 - n0, layout, stride);
+		}
+	});
+}
+
+std::vector<double> SceneSimulator::render(int64_t firstSample, size_t numSamples, SampleLayout layout, WorkerPool & pool) const
+{
+	std::vector<double> samples(numChannels_ * numSamples);
+	render(firstSample, samples.data(), numSamples, layout, pool);
+	return samples;
+}
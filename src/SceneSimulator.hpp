@@ -0,0 +1,50 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include "FakePointSoundSource.hpp"
+#include "ITransducerArray.hpp"
+#include "Transducer.hpp"
+#include "WorkerPool.hpp"
+
+#include <cstdint>
+#include <vector>
+
+
+/**
+ * Time domain recording of a scene of point sources, as picked up by every
+ * mic of an array: channel i is the sum of all sources at transducer i.
+ *
+ * The propagation gain and delay of every (source, mic) pair is computed once
+ * up front. render() splits the requested time span into blocks of
+ * sceneBlockSamples, and (for planar output) the mics into groups of
+ * sceneMicsPerJob, and synthesizes the jobs in parallel.
+ */
+class SceneSimulator {
+	std::vector<FakePointSoundSource> sources_;
+	std::vector<SourceResponse> responses_;
+	size_t numChannels_;
+	int samplerate_;
+
+public:
+	SceneSimulator(std::vector<FakePointSoundSource> const & sources, std::vector<Transducer> const & mics, int samplerate);
+	SceneSimulator(std::vector<FakePointSoundSource> const & sources, ITransducerArray const & array, int samplerate);
+
+	size_t numChannels() const { return numChannels_; }
+	int samplerate() const { return samplerate_; }
+
+	/**
+	 * Samples [firstSample, firstSample + numSamples) of every channel, written
+	 * to out (numChannels() * numSamples values, in layout). */
+	void render(int64_t firstSample, double* out, size_t numSamples, SampleLayout layout, WorkerPool & pool) const;
+
+	std::vector<double> render(int64_t firstSample, size_t numSamples, SampleLayout layout, WorkerPool & pool) const;
+};
+
+/** Samples per parallel job of SceneSimulator::render(). */
+const size_t sceneBlockSamples = 4096;
+
+/** Channels per parallel job of SceneSimulator::render(), for planar output. */
+const size_t sceneMicsPerJob = 16;
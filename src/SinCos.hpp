@@ -0,0 +1,96 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include "SinCosPolynomial.hpp"
+
+#include <cstdint>
+#include <cstring>
+
+
+namespace fastsincos {
+	using namespace sincospolynomial;
+
+	// pi/2 split in three parts with trailing zero bits (from fdlibm), so that
+	// q * PIO2_1 and q * PIO2_2 are exact without FMA for |q| < 2^20
+	const double PIO2_1 = 1.57079632673412561417e+00;
+	const double PIO2_2 = 6.07710050630396597660e-11;
+	const double PIO2_3 = 2.02226624871116645580e-21;
+
+	// Single precision counterparts (from cephes sinf.c): pi/2 in three parts with
+	// q * PIO2_1F exact for |q| < 2^16, 1.5 * 2^23 for rounding, and polynomials on [-pi/4, pi/4]
+	const float PIO2_1F = 1.5703125f;
+	const float PIO2_2F = 4.837512969970703125e-4f;
+	const float PIO2_3F = 7.54978995489188216e-8f;
+	const float TWO_OVER_PIF = 0.636619772f;
+	const float ROUND_MAGICF = 12582912.0f;
+
+	const float S1F = -1.6666654611e-1f;
+	const float S2F =  8.3321608736e-3f;
+	const float S3F = -1.9515295891e-4f;
+
+	const float C1F =  4.166664568298827e-2f;
+	const float C2F = -1.388731625493765e-3f;
+	const float C3F =  2.443315711809948e-5f;
+}
+
+/**
+ * sin(x) and cos(x) for |x| < 1e5, within ~1 ulp.
+ *
+ * Branch free (the quadrant is selected with bit masks), so loops calling it
+ * are vectorized by the compiler, unlike loops calling sin() and cos().
+ * The portable counterpart of the intrinsics in FieldKernelSimd.hpp.
+ */
+inline void sinCos(double x, double & s, double & c)
+{
+	using namespace fastsincos;
+
+	double shifted = x * TWO_OVER_PI + ROUND_MAGIC;
+	double q = shifted - ROUND_MAGIC;
+	double r = ((x - q * PIO2_1) - q * PIO2_2) - q * PIO2_3;
+	double r2 = r * r;
+	double sp = r + r * r2 * (S1 + r2 * (S2 + r2 * (S3 + r2 * (S4 + r2 * (S5 + r2 * S6)))));
+	double cp = 1.0 - 0.5 * r2 + r2 * r2 * (C1 + r2 * (C2 + r2 * (C3 + r2 * (C4 + r2 * (C5 + r2 * C6)))));
+
+	// The low bits of shifted hold the quadrant q mod 4:
+	// 0: (sp, cp), 1: (cp, -sp), 2: (-sp, -cp), 3: (-cp, sp)
+	uint64_t quadrant, sBits, cBits;
+	memcpy(&quadrant, &shifted, sizeof(quadrant));
+	memcpy(&sBits, &sp, sizeof(sBits));
+	memcpy(&cBits, &cp, sizeof(cBits));
+	uint64_t swap = uint64_t(0) - (quadrant & 1);
+	uint64_t s0 = (cBits & swap) | (sBits & ~swap);
+	uint64_t c0 = (sBits & swap) | (cBits & ~swap);
+	s0 ^= (quadrant & 2) << 62;
+	c0 ^= ((quadrant + 1) & 2) << 62;
+	memcpy(&s, &s0, sizeof(s));
+	memcpy(&c, &c0, sizeof(c));
+}
+
+/** Single precision sinCos() for |x| < 1e5, within ~2e-7 (absolute, for |x| < 1e3). */
+inline void sinCos(float x, float & s, float & c)
+{
+	using namespace fastsincos;
+
+	float shifted = x * TWO_OVER_PIF + ROUND_MAGICF;
+	float q = shifted - ROUND_MAGICF;
+	float r = ((x - q * PIO2_1F) - q * PIO2_2F) - q * PIO2_3F;
+	float r2 = r * r;
+	float sp = r + r * r2 * (S1F + r2 * (S2F + r2 * S3F));
+	float cp = 1.0f - 0.5f * r2 + r2 * r2 * (C1F + r2 * (C2F + r2 * C3F));
+
+	// Same quadrant selection as the double version
+	uint32_t quadrant, sBits, cBits;
+	memcpy(&quadrant, &shifted, sizeof(quadrant));
+	memcpy(&sBits, &sp, sizeof(sBits));
+	memcpy(&cBits, &cp, sizeof(cBits));
+	uint32_t swap = uint32_t(0) - (quadrant & 1);
+	uint32_t s0 = (cBits & swap) | (sBits & ~swap);
+	uint32_t c0 = (sBits & swap) | (cBits & ~swap);
+	s0 ^= (quadrant & 2) << 30;
+	c0 ^= ((quadrant + 1) & 2) << 30;
+	memcpy(&s, &s0, sizeof(s));
+	memcpy(&c, &c0, sizeof(c));
+}
@@ -0,0 +1,30 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+// Shared by sinCos() (SinCos.hpp) and the SIMD field kernels (FieldKernelSimd.hpp),
+// which only differ in how they split pi/2 for the argument reduction.
+
+namespace sincospolynomial {
+	const double TWO_OVER_PI = 0.63661977236758134308;
+
+	// 2^52 + 2^51: adding it rounds a double to an integer kept in the low mantissa bits
+	const double ROUND_MAGIC = 6755399441055744.0;
+
+	// sin/cos minimax polynomials on [-pi/4, pi/4] (from fdlibm k_sin.c / k_cos.c)
+	const double S1 = -1.66666666666666324348e-01;
+	const double S2 =  8.33333333332248946124e-03;
+	const double S3 = -1.98412698298579493134e-04;
+	const double S4 =  2.75573137070700676789e-06;
+	const double S5 = -2.50507602534068634195e-08;
+	const double S6 =  1.58969099521155010221e-10;
+
+	const double C1 =  4.16666666666666019037e-02;
+	const double C2 = -1.38888888888741095749e-03;
+	const double C3 =  2.48015872894767294178e-05;
+	const double C4 = -2.75573143513906633035e-07;
+	const double C5 =  2.08757232129817482790e-09;
+	const double C6 = -1.13596475577881948265e-11;
+}
@@ -0,0 +1,80 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+
+/**
+ * Lock-free, bounded single producer / single consumer queue.
+ *
+ * Items are exchanged with std::swap: tryPush() hands the producer back
+ * whatever the slot held before (an already consumed item), and tryPop()
+ * hands the consumer's old item to the slot. Items owning buffers (vectors,
+ * FieldBuffers) are thereby recycled, and nothing is allocated once every
+ * slot has been used.
+ *
+ * Exactly one thread may call tryPush(), and one (other) thread tryPop().
+ */
+template <typename T>
+class SpscRingBuffer {
+	std::vector<T> slots_;
+	size_t mask_;
+	alignas(64) std::atomic<size_t> head_;   // next slot to pop, written by the consumer
+	alignas(64) std::atomic<size_t> tail_;   // next slot to push, written by the producer
+	char padding_[64 - sizeof(std::atomic<size_t>)];
+
+public:
+	/** @param capacity rounded up to a power of two */
+	explicit SpscRingBuffer(size_t capacity)
+	: head_(0),
+		tail_(0)
+	{
+		size_t n = 1;
+		while (n < capacity)
+		{
+			n *= 2;
+		}
+		slots_.resize(n);
+		mask_ = n - 1;
+	}
+
+	SpscRingBuffer(SpscRingBuffer const &) = delete;
+	SpscRingBuffer& operator=(SpscRingBuffer const &) = delete;
+
+	size_t capacity() const { return slots_.size(); }
+
+	/** Approximate when called concurrently with the other side. */
+	size_t size() const { return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire); }
+
+	/** @return false (and leaves item alone) if the queue is full */
+	bool tryPush(T & item)
+	{
+		const size_t tail = tail_.load(std::memory_order_relaxed);
+		if (tail - head_.load(std::memory_order_acquire) == slots_.size())
+		{
+			return false;
+		}
+		std::swap(slots_[tail & mask_], item);
+		tail_.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	/** @return false (and leaves item alone) if the queue is empty */
+	bool tryPop(T & item)
+	{
+		const size_t head = head_.load(std::memory_order_relaxed);
+		if (head == tail_.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+		std::swap(slots_[head & mask_], item);
+		head_.store(head + 1, std::memory_order_release);
+		return true;
+	}
+};
@@ -0,0 +1,217 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "StreamingCamera.hpp"
+#include "Fft.hpp"
+#include "SpscRingBuffer.hpp"
+#include "WorkerPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+
+namespace {
+	typedef std::chrono::steady_clock Clock;
+
+	/** Sleep between polls of an empty (or full) queue. */
+	const std::chrono::microseconds pollInterval(200);
+
+	struct Block {
+		Recording samples;
+		size_t sequence = 0;
+		Clock::time_point captured;
+	};
+
+	struct Image {
+		FieldBuffer img;
+		Clock::time_point newestCapture;   // of the last block in the image
+	};
+
+	double seconds(Clock::duration d)
+	{
+		return std::chrono::duration<double>(d).count();
+	}
+}
+
+double StreamingStats::latencyPercentile(double fraction) const
+{
+	if (latencies.empty())
+	{
+		return 0;
+	}
+	std::vector<double> sorted = latencies;
+	std::sort(sorted.begin(), sorted.end());
+	return sorted[size_t(std::max(0.0, std::min(fraction, 1.0)) * (sorted.size() - 1) + 0.5)];
+}
+
+bool runStreamingCamera(
+		WavStream & source,
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		const std::vector<Transducer>& mics,
+		const double speedOfSound,
+		StreamingSettings const & settings,
+		std::function<void(FieldBuffer const & img, size_t index)> const & onImage,
+		StreamingStats & stats)
+{
+	const size_t M = source.numChannels();
+	const size_t N = settings.spectral.frameSize;
+	const size_t hop = N / 2;
+	const int fs = source.samplerate();
+	const size_t K = std::max<size_t>(settings.framesPerImage, 1);
+
+	// The same checks CrossSpectralMatrix::compute() would fail on, before any thread starts
+	if (M == 0 || M != mics.size() || fs <= 0 || N < 2 || nextPowerOfTwo(N) != N ||
+			crossSpectralBins(settings.spectral, fs).empty())
+	{
+		return false;
+	}
+
+	stats = StreamingStats();
+	SpscRingBuffer<Block> blocks(settings.captureQueue);
+	SpscRingBuffer<Image> images(settings.imageQueue);
+	std::atomic<bool> captureDone(false);
+	std::atomic<bool> beamformDone(false);
+	std::atomic<bool> failed(false);   // an image could not be computed, stops all stages
+	const Clock::time_point start = Clock::now();
+
+	std::thread capture([&]
+	{
+		Block block;
+		for (size_t sequence = 0; !failed; sequence++)
+		{
+			if (block.samples.numChannels() != M || block.samples.numSamples() != hop)
+			{
+				block.samples.resize(fs, M, hop);
+			}
+			if (source.read(block.samples, 0, hop) < hop)
+			{
+				break;
+			}
+			block.sequence = sequence;
+			stats.blocksCaptured++;
+
+			if (settings.realtime)
+			{
+				// A sound card delivers the block once its last sample has been recorded
+				std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(
+					std::chrono::duration<double>(double((sequence + 1) * hop) / fs)));
+				block.captured = Clock::now();
+				if (!blocks.tryPush(block))
+				{
+					stats.blocksDropped++;
+				}
+			}
+			else
+			{
+				block.captured = Clock::now();
+				while (!blocks.tryPush(block) && !failed)
+				{
+					std::this_thread::sleep_for(pollInterval);
+				}
+			}
+		}
+		stats.audioSeconds = double(stats.blocksCaptured * hop) / fs;
+		captureDone = true;
+	});
+
+	std::thread beamform([&]
+	{
+		WorkerPool pool(settings.beamformThreads);
+		Recording window(fs, M, (K + 1) * hop);
+		CrossSpectralMatrix csm;
+		Block block;
+		Image image;
+		size_t filled = 0;          // blocks in window
+		size_t expected = 0;        // sequence number of the next block
+
+		for (;;)
+		{
+			if (!blocks.tryPop(block))
+			{
+				if (captureDone && blocks.size() == 0)
+				{
+					break;
+				}
+				std::this_thread::sleep_for(pollInterval);
+				continue;
+			}
+
+			// Frames have to be contiguous, start over after a dropped block
+			if (block.sequence != expected)
+			{
+				filled = 0;
+			}
+			expected = block.sequence + 1;
+
+			for (size_t ch = 0; ch < M; ch++)
+			{
+				std::copy(block.samples.channel(ch), block.samples.channel(ch) + hop, window.channel(ch) + filled * hop);
+			}
+			filled++;
+			if (filled < K + 1)
+			{
+				continue;
+			}
+
+			if (!csm.compute(window, settings.spectral, pool) ||
+				!beamformCrossSpectral(xvals, yvals, z, csm, mics, speedOfSound, settings.removeDiagonal, image.img, pool))
+			{
+				failed = true;
+				break;
+			}
+			image.newestCapture = block.captured;
+			stats.imagesProduced++;
+
+			if (settings.realtime)
+			{
+				if (!images.tryPush(image))
+				{
+					stats.imagesDropped++;
+				}
+			}
+			else
+			{
+				while (!images.tryPush(image))
+				{
+					std::this_thread::sleep_for(pollInterval);
+				}
+			}
+
+			// The last block starts the next window, so no frame is skipped
+			for (size_t ch = 0; ch < M; ch++)
+			{
+				std::copy(window.channel(ch) + K * hop, window.channel(ch) + (K + 1) * hop, window.channel(ch));
+			}
+			filled = 1;
+		}
+		beamformDone = true;
+	});
+
+	// Output stage on the calling thread
+	Image image;
+	for (size_t index = 0; ; )
+	{
+		if (!images.tryPop(image))
+		{
+			if (beamformDone && images.size() == 0)
+			{
+				break;
+			}
+			std::this_thread::sleep_for(pollInterval);
+			continue;
+		}
+
+		onImage(image.img, index++);
+		stats.latencies.push_back(seconds(Clock::now() - image.newestCapture));
+	}
+
+	capture.join();
+	beamform.join();
+	stats.wallSeconds = seconds(Clock::now() - start);
+	return !failed;
+}
@@ -0,0 +1,67 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include "CrossSpectral.hpp"
+#include "FieldBuffer.hpp"
+#include "Transducer.hpp"
+#include "WavFile.hpp"
+
+#include <functional>
+#include <vector>
+
+
+struct StreamingSettings {
+	CrossSpectralSettings spectral;   //!< STFT frame size and band; one captured block is half a frame
+	size_t framesPerImage = 16;       //!< STFT frames averaged into each image
+	size_t captureQueue = 16;         //!< blocks between capture and beamforming
+	size_t imageQueue = 2;            //!< images between beamforming and output
+	bool realtime = false;            //!< capture at the samplerate and drop what does not fit, like a sound card; otherwise wait
+	bool removeDiagonal = false;      //!< see beamformCrossSpectral()
+	int beamformThreads = 1;          //!< worker threads of the beamforming stage
+};
+
+struct StreamingStats {
+	size_t blocksCaptured = 0;
+	size_t blocksDropped = 0;         //!< capture queue full (realtime only)
+	size_t imagesProduced = 0;
+	size_t imagesDropped = 0;         //!< image queue full (realtime only)
+	double audioSeconds = 0;          //!< of captured audio
+	double wallSeconds = 0;           //!< from start until the output stage finished
+	std::vector<double> latencies;    //!< per written image: seconds from capture of its newest block until written
+
+	/** Latency below which fraction (0..1) of the images were written, 0 without images. */
+	double latencyPercentile(double fraction) const;
+};
+
+/**
+ * Live acoustic camera over a (WAV) stream, such as a FIFO fed by a sound card.
+ *
+ * Three stages, each on its own thread (the output stage on the calling one),
+ * connected by SpscRingBuffer queues:
+ *
+ *   capture      reads blocks of frameSize / 2 samples from source
+ *   beamforming  collects framesPerImage STFT frames, then images their
+ *                cross-spectral matrix (beamformCrossSpectral())
+ *   output       calls onImage for every image
+ *
+ * Both queues are bounded, which bounds the latency. In realtime mode a stage
+ * never waits for the next one: a block or image that does not fit is
+ * dropped (and counted), and the beamforming stage restarts its window after
+ * a lost block. Otherwise the stages wait for each other, which measures the
+ * throughput of the pipeline.
+ *
+ * @return false if the settings do not fit the source (channel count,
+ *         frame size or band), or an image could not be computed. */
+bool runStreamingCamera(
+		WavStream & source,
+		const std::vector<double>& xvals,
+		const std::vector<double>& yvals,
+		double z,
+		const std::vector<Transducer>& mics,
+		const double speedOfSound,
+		StreamingSettings const & settings,
+		std::function<void(FieldBuffer const & img, size_t index)> const & onImage,
+		StreamingStats & stats);
@@ -0,0 +1,71 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "StringParse.hpp"
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <sstream>
+
+
+std::vector<std::string> splitString(std::string const & s, char delimiter)
+{
+	std::vector<std::string> parts;
+	std::istringstream iss(s);
+	std::string part;
+	while (std::getline(iss, part, delimiter))
+	{
+		parts.push_back(part);
+	}
+	return parts;
+}
+
+bool parseInt(std::string const & s, int & value)
+{
+	if (s.empty())
+	{
+		return false;
+	}
+	char* end = nullptr;
+	errno = 0;
+	long v = strtol(s.c_str(), &end, 10);
+	if (*end != '\0' || errno == ERANGE || v < INT_MIN || v > INT_MAX)
+	{
+		return false;
+	}
+	value = int(v);
+	return true;
+}
+
+bool parseIntList(std::string const & spec, std::vector<int> & values)
+{
+	values.clear();
+	for (std::string const & part : splitString(spec, ','))
+	{
+		int v;
+		if (!parseInt(part, v))
+		{
+			return false;
+		}
+		values.push_back(v);
+	}
+	return !values.empty();
+}
+
+bool formatNumberedFilename(std::string const & pattern, size_t number, std::string & filename)
+{
+	const size_t pos = pattern.find('%');
+	if (pos == std::string::npos)
+	{
+		filename = pattern;
+		return true;
+	}
+	if (pattern.compare(pos, 2, "%d") != 0 || pattern.find('%', pos + 1) != std::string::npos)
+	{
+		return false;
+	}
+	filename = pattern.substr(0, pos) + std::to_string(number) + pattern.substr(pos + 2);
+	return true;
+}
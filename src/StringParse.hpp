@@ -0,0 +1,26 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+
+/** Split s at every delimiter (an empty trailing part is dropped). */
+std::vector<std::string> splitString(std::string const & s, char delimiter);
+
+/**
+ * Parse a whole string as a decimal int.
+ * @returns false if s is empty, has trailing characters or does not fit an int */
+bool parseInt(std::string const & s, int & value);
+
+/** Parse a comma separated list of integers, e.g. "0,1,2,3,4,6". */
+bool parseIntList(std::string const & spec, std::vector<int> & values);
+
+/**
+ * Replace the %d in pattern by number, e.g. "img%d.pgm" -> "img7.pgm".
+ * A pattern without any % is returned as is.
+ * @returns false if pattern has a % which is not that one %d */
+bool formatNumberedFilename(std::string const & pattern, size_t number, std::string & filename);
@@ -0,0 +1,174 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "Sweep.hpp"
+
+#include "DistanceTable.hpp"
+#include "FieldBuffer.hpp"
+#include "FieldKernel.hpp"
+#include "FieldWriter.hpp"
+#include "MicArrayFactory.hpp"
+#include "PolarPattern.hpp"
+#include "RenderCache.hpp"
+#include "RenderSound.hpp"
+#include "StringParse.hpp"
+
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+
+bool parseSweepRange(std::string const & spec, std::vector<int> & values)
+{
+	std::vector<std::string> parts = splitString(spec, ':');
+	int first, last, step;
+	if (parts.size() != 3 ||
+		!parseInt(parts[0], first) ||
+		!parseInt(parts[1], last) ||
+		!parseInt(parts[2], step) ||
+		step <= 0 || last < first)
+	{
+		return false;
+	}
+
+	values.clear();
+	for (int f = first; f <= last; f += step)
+	{
+		values.push_back(f);
+	}
+	return true;
+}
+
+std::string sweepOutputFilename(SweepSettings const & settings, int frequency, int type)
+{
+	char name[64];
+	if (settings.polar)
+	{
+		snprintf(name, sizeof(name), "out_polar_f%06d_t%d.%s", frequency, type, settings.polarText ? "txt" : "png");
+	}
+	else
+	{
+		snprintf(name, sizeof(name), "out_wall_f%06d_t%d.%s", frequency, type, fieldFormatExtension(settings.format));
+	}
+	return settings.outputDir + "/" + name;
+}
+
+int runSweep(SweepSettings const & settings, WorkerPool & pool)
+{
+	// Build every geometry once, shared (read only) by all jobs
+	std::map<int, std::vector<Transducer> > geometries;
+	for (int type : settings.types)
+	{
+		std::unique_ptr<ITransducerArray> micArray = createMicArray(type);
+		if (!micArray)
+		{
+			std::cout << "ERROR: unknown mic array type " << type << std::endl;
+			return int(settings.frequencies.size() * settings.types.size());
+		}
+		geometries[type] = micArray->getTransducers();
+	}
+
+	const int w = settings.dimension;
+	const int h = settings.dimension;
+	std::vector<double> xvals = linspace(settings.xmin, settings.xmax, w);
+	std::vector<double> yvals = linspace(settings.ymin, settings.ymax, h);
+
+	// Distances are the same for every frequency, so compute (or map) them once per geometry
+	std::map<int, std::unique_ptr<DistanceTable> > distanceTables;
+	if (!settings.polar && !settings.distanceCacheDir.empty())
+	{
+		for (int type : settings.types)
+		{
+			distanceTables[type].reset(new DistanceTable());
+			loadOrBuildDistanceTable(settings.distanceCacheDir, xvals, yvals, settings.z, geometries.at(type),
+				*distanceTables[type], pool);
+		}
+	}
+
+	// All geometries for one frequency next to each other, like runme.sh did
+	const size_t numTypes = settings.types.size();
+	const size_t numJobs = settings.frequencies.size() * numTypes;
+
+	RenderCache renderCache(settings.renderCacheDir);
+	std::mutex outputMutex;
+	int failed = 0;
+
+	// One image buffer per worker, reused by every job that worker runs
+	std::vector<FieldBuffer> images(pool.getNumThreads());
+	std::vector<std::vector<double> > patterns(pool.getNumThreads());
+
+	pool.parallelForWorker(numJobs, [&](size_t job, int worker)
+	{
+		FieldBuffer & img = images[worker];
+		std::vector<double> & dB = patterns[worker];
+
+		int frequency = settings.frequencies[job / numTypes];
+		int type = settings.types[job % numTypes];
+		std::vector<Transducer> const & mics = geometries.at(type);
+		std::string filename = sweepOutputFilename(settings, frequency, type);
+		bool ok = true;
+
+		if (settings.polar)
+		{
+			if (!computePolarPattern(settings.z, frequency, mics, settings.speedOfSound, dB, pool))
+			{
+				ok = false;
+			}
+			else if (settings.polarText)
+			{
+				ok = writePolarPatternText(filename, dB);
+			}
+			else
+			{
+				std::ostringstream oss;
+				oss << "f=" << frequency << ", t=" << type;
+				ok = drawPolarPattern(dB, oss.str(), filename);
+			}
+		}
+		else
+		{
+			const bool useTable = distanceTables.count(type) != 0;
+			const std::string renderer = std::string(useTable ? "near:table:" : "near:")
+				+ fieldKernelIsaName(getFieldKernelIsa());
+			const uint64_t key = renderCacheKey(renderer,
+				xvals, yvals, settings.z, frequency, mics, settings.speedOfSound);
+			const bool cached = !settings.renderCacheDir.empty() && renderCache.load(key, img);
+
+			if (!cached)
+			{
+				if (useTable)
+				{
+					renderSoundOnWall(*distanceTables.at(type), frequency, settings.speedOfSound, img, pool);
+				}
+				else
+				{
+					renderSoundOnWall(xvals, yvals, settings.z, frequency, mics, settings.speedOfSound, img);
+				}
+
+				if (!settings.renderCacheDir.empty())
+				{
+					// Best effort, a failed store only costs a render next time
+					renderCache.store(key, img);
+				}
+			}
+			ok = writeField(filename, settings.format, img, settings.dynamicRangedB);
+		}
+
+		std::lock_guard<std::mutex> lock(outputMutex);
+		if (!ok)
+		{
+			failed++;
+			std::cout << "ERROR: could not write " << filename << std::endl;
+		}
+		else
+		{
+			std::cout << filename << std::endl;
+		}
+	});
+
+	return failed;
+}
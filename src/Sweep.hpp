@@ -0,0 +1,44 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include "FieldWriter.hpp"
+#include "WorkerPool.hpp"
+
+#include <string>
+#include <vector>
+
+
+/**
+ * Parse "first:last:step" (like seq) into the list of frequencies.
+ * @returns false on malformed input */
+bool parseSweepRange(std::string const & spec, std::vector<int> & values);
+
+/** Everything needed to render a batch of frequency / geometry combinations. */
+struct SweepSettings {
+	std::vector<int> frequencies;
+	std::vector<int> types;       //!< mic array types, see createMicArray()
+	bool polar;                   //!< render polar plots instead of walls
+	bool polarText = false;       //!< write polar patterns as text instead of drawing png plots
+	int dimension;                //!< width and height of wall images
+	double z;                     //!< distance to wall (and radius of polar plots)
+	double xmin, xmax, ymin, ymax;
+	double speedOfSound;
+	std::string outputDir;
+	std::string distanceCacheDir; //!< if set, walls are rendered from distance tables cached here (see DistanceTable)
+	std::string renderCacheDir;   //!< if set, rendered walls are looked up in and added to this RenderCache
+	FieldFormat format = FieldFormat::PGM;  //!< file format of walls
+	double dynamicRangedB = 60;   //!< dB range of FieldFormat::PGM16_DB walls
+};
+
+/** Name of the file a single sweep job is written to (same names as runme.sh used). */
+std::string sweepOutputFilename(SweepSettings const & settings, int frequency, int type);
+
+/**
+ * Render every frequency / type combination in settings.
+ * Each geometry is built once. Jobs are spread over the threads in pool,
+ * and every worker reuses its image buffer between jobs.
+ * @returns number of jobs that failed */
+int runSweep(SweepSettings const & settings, WorkerPool & pool);
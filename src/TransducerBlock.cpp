@@ -0,0 +1,26 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "TransducerBlock.hpp"
+
+
+TransducerBlock::TransducerBlock(std::vector<Transducer> const & transducers)
+: size_(transducers.size())
+{
+	size_t padded = (size_ + simdWidth - 1) / simdWidth * simdWidth;
+	Pos padPos = size_ ? transducers[0].pos : Pos();
+
+	x_.resize(padded, padPos.x);
+	y_.resize(padded, padPos.y);
+	z_.resize(padded, padPos.z);
+	weight_.resize(padded, 0.0);
+
+	for (size_t i = 0; i < size_; i++)
+	{
+		x_[i] = transducers[i].pos.x;
+		y_[i] = transducers[i].pos.y;
+		z_[i] = transducers[i].pos.z;
+		weight_[i] = 1.0;
+	}
+}
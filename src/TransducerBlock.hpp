@@ -0,0 +1,44 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include "AlignedAllocator.hpp"
+#include "Transducer.hpp"
+
+#include <vector>
+
+
+/**
+ * Structure-of-arrays copy of a set of transducers, for the SIMD field kernels.
+ *
+ * The x, y, z and weight arrays are 64 byte aligned and padded to a multiple
+ * of simdWidth. Padding elements sit on top of the first transducer (so their
+ * distance to any listener is well defined) and have weight 0.
+ */
+class TransducerBlock {
+	size_t size_;
+	AlignedVector<double> x_;
+	AlignedVector<double> y_;
+	AlignedVector<double> z_;
+	AlignedVector<double> weight_;
+public:
+	/** Widest supported vector, in doubles (AVX-512). */
+	static const size_t simdWidth = 8;
+
+	explicit TransducerBlock(std::vector<Transducer> const & transducers);
+
+	/** Number of real transducers. */
+	size_t size() const { return size_; }
+
+	/** Length of the arrays, including padding. */
+	size_t paddedSize() const { return x_.size(); }
+
+	double const * x() const { return x_.data(); }
+	double const * y() const { return y_.data(); }
+	double const * z() const { return z_.data(); }
+
+	/** 1 for real transducers, 0 for padding. */
+	double const * weight() const { return weight_.data(); }
+};
@@ -0,0 +1,219 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "WavFile.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+
+namespace {
+	const uint16_t formatPcm = 1;
+	const uint16_t formatFloat = 3;
+	const uint16_t formatExtensible = 0xfffe;
+
+	uint32_t readLe(unsigned char const * p, int bytes)
+	{
+		uint32_t value = 0;
+		for (int i = bytes - 1; i >= 0; i--)
+		{
+			value = (value << 8) | p[i];
+		}
+		return value;
+	}
+
+	void appendLe(std::string & out, uint32_t value, int bytes)
+	{
+		for (int i = 0; i < bytes; i++)
+		{
+			out.push_back(char((value >> (8 * i)) & 0xff));
+		}
+	}
+
+	/** One sample (little endian) in [-1, 1). */
+	float decodeSample(unsigned char const * p, uint16_t format, int bytes)
+	{
+		if (format == formatFloat)
+		{
+			uint32_t bits = readLe(p, 4);
+			float value;
+			memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+
+		// Sign extend from the top byte
+		uint32_t bits = readLe(p, bytes) << (32 - 8 * bytes);
+		return float(int32_t(bits) / 2147483648.0);
+	}
+}
+
+WavStream::WavStream()
+: format_(0),
+	bytesPerSample_(0),
+	numChannels_(0),
+	samplerate_(0),
+	remaining_(0)
+{
+	// no code
+}
+
+bool WavStream::open(std::string const & filename)
+{
+	in_.open(filename, std::ios::binary);
+	unsigned char riff[12];
+	if (!in_.read(reinterpret_cast<char*>(riff), sizeof(riff)) ||
+			memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0)
+	{
+		return false;
+	}
+
+	bool haveFormat = false;
+	unsigned char chunk[8];
+	while (in_.read(reinterpret_cast<char*>(chunk), sizeof(chunk)))
+	{
+		const uint32_t size = readLe(chunk + 4, 4);
+
+		if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16 && size < 1024)
+		{
+			std::vector<unsigned char> body(size + (size & 1));
+			if (!in_.read(reinterpret_cast<char*>(body.data()), body.size()))
+			{
+				return false;
+			}
+			format_ = readLe(body.data(), 2);
+			numChannels_ = readLe(body.data() + 2, 2);
+			samplerate_ = readLe(body.data() + 4, 4);
+			const int bitsPerSample = readLe(body.data() + 14, 2);
+			if (format_ == formatExtensible && size >= 26)
+			{
+				// The first two bytes of the sub format GUID are the actual format
+				format_ = readLe(body.data() + 24, 2);
+			}
+
+			const bool supported =
+				(format_ == formatPcm && (bitsPerSample == 16 || bitsPerSample == 24 || bitsPerSample == 32)) ||
+				(format_ == formatFloat && bitsPerSample == 32);
+			if (!supported || numChannels_ == 0 || samplerate_ <= 0)
+			{
+				return false;
+			}
+			bytesPerSample_ = bitsPerSample / 8;
+			haveFormat = true;
+		}
+		else if (memcmp(chunk, "data", 4) == 0 && haveFormat)
+		{
+			remaining_ = size == 0 || size == 0xffffffff ? UINT64_MAX : size;
+			return true;
+		}
+		else
+		{
+			// Chunks are padded to an even number of bytes
+			in_.ignore(size + (size & 1));
+		}
+	}
+	return false;
+}
+
+size_t WavStream::dataFrames() const
+{
+	return remaining_ == UINT64_MAX ? 0 : remaining_ / (bytesPerSample_ * numChannels_);
+}
+
+size_t WavStream::read(Recording & block, size_t offset, size_t numFrames)
+{
+	const size_t frameBytes = size_t(bytesPerSample_) * numChannels_;
+	numFrames = std::min<uint64_t>(numFrames, remaining_ / frameBytes);
+	buffer_.resize(numFrames * frameBytes);
+	in_.read(reinterpret_cast<char*>(buffer_.data()), buffer_.size());
+
+	const size_t frames = size_t(in_.gcount()) / frameBytes;
+	for (size_t ch = 0; ch < numChannels_; ch++)
+	{
+		float* dst = block.channel(ch) + offset;
+		unsigned char const * src = buffer_.data() + ch * bytesPerSample_;
+		for (size_t n = 0; n < frames; n++)
+		{
+			dst[n] = decodeSample(src + n * frameBytes, format_, bytesPerSample_);
+		}
+	}
+	remaining_ -= frames * frameBytes;
+	return frames;
+}
+
+bool readWav(std::string const & filename, Recording & recording)
+{
+	WavStream stream;
+	if (!stream.open(filename))
+	{
+		return false;
+	}
+
+	// Read in pieces, so that memory follows the samples actually in the file: the
+	// header length is unknown for streams, and only an upper bound for a truncated file
+	const size_t piece = 1 << 16;
+	std::vector<Recording> pieces;
+	size_t total = 0;
+	for (;;)
+	{
+		pieces.push_back(Recording(stream.samplerate(), stream.numChannels(), piece));
+		const size_t got = stream.read(pieces.back(), 0, piece);
+		total += got;
+		if (got < piece)
+		{
+			break;
+		}
+	}
+
+	recording.resize(stream.samplerate(), stream.numChannels(), total);
+	size_t offset = 0;
+	for (Recording const & p : pieces)
+	{
+		const size_t count = std::min(p.numSamples(), total - offset);
+		for (size_t ch = 0; ch < stream.numChannels(); ch++)
+		{
+			std::copy(p.channel(ch), p.channel(ch) + count, recording.channel(ch) + offset);
+		}
+		offset += count;
+	}
+	return true;
+}
+
+bool writeWav(std::string const & filename, Recording const & recording)
+{
+	const uint32_t channels = recording.numChannels();
+	const uint32_t dataBytes = uint32_t(recording.numSamples() * channels * 4);
+
+	std::string header;
+	header += "RIFF";
+	appendLe(header, 36 + dataBytes, 4);
+	header += "WAVEfmt ";
+	appendLe(header, 16, 4);
+	appendLe(header, formatFloat, 2);
+	appendLe(header, channels, 2);
+	appendLe(header, recording.samplerate(), 4);
+	appendLe(header, recording.samplerate() * channels * 4, 4);
+	appendLe(header, channels * 4, 2);
+	appendLe(header, 32, 2);
+	header += "data";
+	appendLe(header, dataBytes, 4);
+
+	std::string data;
+	data.reserve(dataBytes);
+	for (size_t n = 0; n < recording.numSamples(); n++)
+	{
+		for (size_t ch = 0; ch < channels; ch++)
+		{
+			uint32_t bits;
+			memcpy(&bits, recording.channel(ch) + n, sizeof(bits));
+			appendLe(data, bits, 4);
+		}
+	}
+
+	std::ofstream out(filename, std::ios::binary);
+	out << header << data;
+	return bool(out);
+}
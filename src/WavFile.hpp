@@ -0,0 +1,58 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include "Recording.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+/**
+ * Sequential reader of a RIFF/WAVE file: 16, 24 or 32 bit integer PCM, or
+ * 32 bit float (also as WAVE_FORMAT_EXTENSIBLE). Integer samples are scaled
+ * to [-1, 1).
+ *
+ * Never seeks, so it also reads from FIFOs and pipes, such as the output of
+ * "arecord -t wav". A data chunk size of 0 or 0xffffffff (written by
+ * recorders which do not know the length up front) means "until end of file".
+ */
+class WavStream {
+	std::ifstream in_;
+	uint16_t format_;
+	int bytesPerSample_;
+	size_t numChannels_;
+	int samplerate_;
+	uint64_t remaining_;            // bytes left of the data chunk
+	std::vector<unsigned char> buffer_;
+
+public:
+	WavStream();
+
+	/** Open filename and read the header, up to the start of the samples. */
+	bool open(std::string const & filename);
+
+	int samplerate() const { return samplerate_; }
+	size_t numChannels() const { return numChannels_; }
+
+	/** Samples per channel in the data chunk, or 0 if unknown. */
+	size_t dataFrames() const;
+
+	/**
+	 * Read up to numFrames frames, de-interleaved into
+	 * block.channel(ch)[offset, offset + numFrames).
+	 * @return frames read, less than numFrames only at the end of the data. */
+	size_t read(Recording & block, size_t offset, size_t numFrames);
+};
+
+/**
+ * Read a whole WAVE file (see WavStream for the supported formats).
+ * @return false if the file can not be read or has an unsupported format. */
+bool readWav(std::string const & filename, Recording & recording);
+
+/** Write recording as a 32 bit float WAVE file. */
+bool writeWav(std::string const & filename, Recording const & recording);
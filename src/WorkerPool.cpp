@@ -0,0 +1,160 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "WorkerPool.hpp"
+
+#include <algorithm>
+
+
+namespace {
+	thread_local bool t_insideJob = false;
+}
+
+WorkerPool::WorkerPool(int numThreads)
+: numThreads_(numThreads),
+	job_(nullptr),
+	generation_(0),
+	busyWorkers_(0),
+	stop_(false)
+{
+	if (numThreads_ <= 0)
+	{
+		numThreads_ = std::max<int>(1, std::thread::hardware_concurrency());
+	}
+
+	slots_.reset(new Slot[numThreads_]);
+	for (int i = 0; i < numThreads_; i++)
+	{
+		slots_[i].next = 0;
+		slots_[i].end = 0;
+	}
+
+	// The calling thread is worker 0
+	for (int i = 1; i < numThreads_; i++)
+	{
+		threads_.emplace_back(&WorkerPool::workerLoop, this, i);
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	wakeCv_.notify_all();
+	for (auto & t : threads_)
+	{
+		t.join();
+	}
+}
+
+void WorkerPool::workerLoop(int index)
+{
+	size_t seenGeneration = 0;
+	for (;;)
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		wakeCv_.wait(lock, [&] { return stop_ || generation_ != seenGeneration; });
+		if (stop_)
+		{
+			return;
+		}
+		seenGeneration = generation_;
+		lock.unlock();
+
+		runSlots(index);
+
+		lock.lock();
+		if (--busyWorkers_ == 0)
+		{
+			doneCv_.notify_one();
+		}
+	}
+}
+
+void WorkerPool::runSlots(int self)
+{
+	t_insideJob = true;
+
+	// Own range first, then steal from the others
+	for (int k = 0; k < numThreads_; k++)
+	{
+		Slot & slot = slots_[(self + k) % numThreads_];
+		for (;;)
+		{
+			size_t i = slot.next.fetch_add(1);
+			if (i >= slot.end)
+			{
+				break;
+			}
+
+			try
+			{
+				(*job_)(i, self);
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				if (!error_)
+				{
+					error_ = std::current_exception();
+				}
+			}
+		}
+	}
+
+	t_insideJob = false;
+}
+
+void WorkerPool::parallelFor(size_t numJobs, std::function<void(size_t)> const & job)
+{
+	parallelForWorker(numJobs, [&job](size_t i, int) { job(i); });
+}
+
+void WorkerPool::parallelForWorker(size_t numJobs, std::function<void(size_t, int)> const & job)
+{
+	// Serially on the calling thread, which is the only worker of this call
+	if (threads_.empty() || numJobs <= 1 || t_insideJob)
+	{
+		for (size_t i = 0; i < numJobs; i++)
+		{
+			job(i, 0);
+		}
+		return;
+	}
+
+	std::lock_guard<std::mutex> callLock(callMutex_);
+
+	for (int i = 0; i < numThreads_; i++)
+	{
+		slots_[i].next = numJobs * i / numThreads_;
+		slots_[i].end = numJobs * (i + 1) / numThreads_;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		job_ = &job;
+		error_ = nullptr;
+		busyWorkers_ = threads_.size();
+		generation_++;
+	}
+	wakeCv_.notify_all();
+
+	runSlots(0);
+
+	std::exception_ptr error;
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		doneCv_.wait(lock, [&] { return busyWorkers_ == 0; });
+		job_ = nullptr;
+		error = error_;
+		error_ = nullptr;
+	}
+
+	if (error)
+	{
+		std::rethrow_exception(error);
+	}
+}
@@ -0,0 +1,75 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/**
+ * Fixed set of worker threads executing independent, numbered jobs.
+ *
+ * Jobs are split into one contiguous range per thread (so neighbouring
+ * tiles stay on the same core). A thread that runs out of work steals
+ * the remaining jobs from the other ranges.
+ *
+ * A parallelFor() issued from inside a job runs serially on the calling
+ * thread, so code using the pool can be nested freely.
+ */
+class WorkerPool {
+	struct Slot {
+		std::atomic<size_t> next;
+		size_t end;
+		char padding[64 - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+	};
+
+	int numThreads_;
+	std::vector<std::thread> threads_;
+	std::unique_ptr<Slot[]> slots_;
+
+	std::mutex callMutex_;
+	std::mutex mutex_;
+	std::condition_variable wakeCv_;
+	std::condition_variable doneCv_;
+	std::function<void(size_t, int)> const * job_;
+	size_t generation_;
+	int busyWorkers_;
+	bool stop_;
+	std::exception_ptr error_;
+
+	void workerLoop(int index);
+	void runSlots(int self);
+
+public:
+	/**
+	 * @param numThreads number of threads to spread jobs over (the thread calling
+	 *        parallelFor() counts as one of them). 0 means one per hardware thread. */
+	explicit WorkerPool(int numThreads = 0);
+	~WorkerPool();
+
+	WorkerPool(WorkerPool const &) = delete;
+	WorkerPool& operator=(WorkerPool const &) = delete;
+
+	int getNumThreads() const { return numThreads_; }
+
+	/**
+	 * Call job(i) for every i in [0, numJobs), and return when all are done.
+	 * The first exception thrown by a job is rethrown here. */
+	void parallelFor(size_t numJobs, std::function<void(size_t)> const & job);
+
+	/**
+	 * Same as parallelFor(), but calls job(i, worker) with the index of the
+	 * thread running it, in [0, getNumThreads()). Jobs running at the same time
+	 * within one call never share a worker index, so per-worker scratch
+	 * allocated by the caller can be indexed by it. */
+	void parallelForWorker(size_t numJobs, std::function<void(size_t, int)> const & job);
+};
@@ -0,0 +1,60 @@
+//
+// Copyright(C) 2014,2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "arrays/HomogeneousTransducerArray.hpp"
+
+#include <algorithm>
+
+namespace {
+    struct Comp {
+        bool operator()(const Transducer&a, const Transducer&b)
+        {
+            double ra = a.pos.dist(Pos(0,0,0));
+            double rb = b.pos.dist(Pos(0,0,0));
+
+            return ra < rb;
+        }
+    };
+}
+
+void HomogeneousTransducerArray::addRectangular(int numTransducersX, double spacingX, int numTransducersY, double spacingY)
+{
+    double xoffs = - 0.5*(numTransducersX-1) * spacingX;
+    double yoffs = - 0.5*(numTransducersY-1) * spacingY;
+
+    for (int y = 0; y < numTransducersY; y++) {
+        for (int x = 0; x < numTransducersX; x++) {
+            double X = x * spacingX + xoffs;
+            double Y = y * spacingY + yoffs;
+
+//            std::cout << "x,y= (" << X << ", " << Y << ")\n";
+            Transducer tmp;
+            tmp.pos.x = X;
+            tmp.pos.y = Y;
+            tmp.pos.z = 0;
+            _transducers.push_back(tmp);
+        }
+    }
+}
+
+/**
+ * @param numTransducers number of transducers to place
+ * @param spacing how close to pack the elements */
+HomogeneousTransducerArray::HomogeneousTransducerArray(int numTransducers, double spacing)
+{
+    // Over-populate our array of mics
+    addRectangular(numTransducers*2, spacing, numTransducers*2, spacing);
+
+    // Sort them on radius
+    Comp cmp;
+    std::sort(_transducers.begin(), _transducers.end(), cmp);
+
+    // remove the excess ones
+    _transducers.erase(_transducers.begin() + numTransducers, _transducers.end());
+}
+
+const std::vector<Transducer>& HomogeneousTransducerArray::getTransducers() const
+{
+    return _transducers;
+}
@@ -0,0 +1,20 @@
+//
+// Copyright(C) 2014,2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include "ITransducerArray.hpp"
+
+
+class HomogeneousTransducerArray : public ITransducerArray {
+	std::vector<Transducer> _transducers;
+	void addRectangular(int numTransducersX, double spacingX, int numTransducersY, double spacingY);
+public:
+	/**
+	 * @param numTransducers number of transducers to place
+	 * @param spacing how close to pack the elements */
+	HomogeneousTransducerArray(int numTransducers, double spacing);
+
+	const std::vector<Transducer>& getTransducers() const override;
+};
@@ -0,0 +1,29 @@
+//
+// Copyright(C) 2014,2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "arrays/SpiralTransducerArray.hpp"
+
+#include <cmath>
+
+SpiralTransducerArray::SpiralTransducerArray(double a, double b, double c, double transducersPerRevolution, int numTransducers)
+{
+    for (int i = 0; i < numTransducers; i++)
+    {
+        double alpha = 2 * M_PI * i / transducersPerRevolution;
+        double x = a * cos(alpha) * exp(b*alpha) * (c * (1 + alpha));
+        double y = a * sin(alpha) * exp(b*alpha) * (c * (1 + alpha));
+
+//        std::cout << "x,y= (" << x << ", " << y << "), r=" << sqrt(sqr(x)+sqr(y)) << "\n";
+        Transducer tmp;
+        tmp.pos.x = x;
+        tmp.pos.y = y;
+        tmp.pos.z = 0;
+        _transducers.push_back(tmp);
+    }
+}
+
+const std::vector<Transducer>& SpiralTransducerArray::getTransducers() const
+{
+    return _transducers;
+}
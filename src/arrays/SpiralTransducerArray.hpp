@@ -0,0 +1,16 @@
+//
+// Copyright(C) 2014,2020 Simon Gustafsson (optisimon.com)
+//
+
+#pragma once
+
+#include "ITransducerArray.hpp"
+
+
+class SpiralTransducerArray : public ITransducerArray {
+	std::vector<Transducer> _transducers;
+public:
+	SpiralTransducerArray(double a, double b, double c, double transducersPerRevolution, int numTransducers);
+
+	const std::vector<Transducer>& getTransducers() const override;
+};
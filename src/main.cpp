@@ -17,6 +17,7 @@
 #include <math.h>
 #include <limits>
 #include <string.h>
+#include <stdio.h>
 #include <algorithm>
 
 #include "ArgumentParser.h"
@@ -28,120 +29,33 @@ const double speedOfSound = 343; //  m/s
 #include "ITransducerArray.hpp"
 #include "FakePointSoundSource.hpp"
 #include "RenderSound.hpp"
-
-#include "arrays/SingleRingTransducerArray.hpp"
-#include "arrays/DualRingTransducerArray.hpp"
-#include "arrays/RectangularTransducerArray.hpp"
-#include "arrays/RandomTransducerArray.hpp"
-
-class SpiralTransducerArray : public ITransducerArray {
-	std::vector<Transducer> _transducers;
-	public:
-		/** @param radius1, radius2 radius of mic ring in meter */
-		SpiralTransducerArray(double a, double b, double c, double transducersPerRevolution, int numTransducers)
-		{
-			for (int i = 0; i < numTransducers; i++)
-			{
-				double alpha = 2 * M_PI * i / transducersPerRevolution;
-				double x = a * cos(alpha) * exp(b*alpha) * (c * (1 + alpha));
-				double y = a * sin(alpha) * exp(b*alpha) * (c * (1 + alpha));
-
-//				std::cout << "x,y= (" << x << ", " << y << "), r=" << sqrt(sqr(x)+sqr(y)) << "\n";
-				Transducer tmp;
-				tmp.pos.x = x;
-				tmp.pos.y = y;
-				tmp.pos.z = 0;
-				_transducers.push_back(tmp);
-			}
-		}
-
-		const std::vector<Transducer>& getTransducers() const override {
-			return _transducers;
-		}
-};
-
-class HomogeneousTransducerArray : public ITransducerArray {
-	std::vector<Transducer> _transducers;
-	void addTransducer(double X, double Y)
-	{
-		std::cout << "x,y= (" << X << ", " << Y << ")\n";
-		Transducer tmp;
-		tmp.pos.x = X;
-		tmp.pos.y = Y;
-		tmp.pos.z = 0;
-		_transducers.push_back(tmp);
-	}
-
-	void addRectangular(int numTransducersX, double spacingX, int numTransducersY, double spacingY)
-	{
-		double xoffs = - 0.5*(numTransducersX-1) * spacingX;
-		double yoffs = - 0.5*(numTransducersY-1) * spacingY;
-
-		for (int y = 0; y < numTransducersY; y++) {
-			for (int x = 0; x < numTransducersX; x++) {
-				double X = x * spacingX + xoffs;
-				double Y = y * spacingY + yoffs;
-
-//				std::cout << "x,y= (" << X << ", " << Y << ")\n";
-				Transducer tmp;
-				tmp.pos.x = X;
-				tmp.pos.y = Y;
-				tmp.pos.z = 0;
-				_transducers.push_back(tmp);
-			}
-		}
-	}
-	struct Comp {
-		bool operator()(const Transducer&a, const Transducer&b)
-		{
-			double ra = a.pos.dist(Pos(0,0,0));
-			double rb = b.pos.dist(Pos(0,0,0));
-
-			return ra < rb;
-		}
-	};
-public:
-	/**
-	 * @param numTransducers number of transducers to place
-	 * @param spacing how close to pack the elements */
-	HomogeneousTransducerArray(int numTransducers, double spacing)
-	{
-		// Over-populate our array of mics
-		addRectangular(numTransducers*2, spacing, numTransducers*2, spacing);
-
-		// Sort them on radius
-		Comp cmp;
-		std::sort(_transducers.begin(), _transducers.end(), cmp);
-
-		// remove the excess ones
-		_transducers.erase(_transducers.begin() + numTransducers, _transducers.end());
-	}
-
-	const std::vector<Transducer>& getTransducers() const override {
-		return _transducers;
-	}
-};
-
-
-
-std::vector<double> linspace(double first, double last, int N)
-{
-	std::vector<double> retval(N);
-
-	for (int i = 0; i < N; i++)
-	{
-		double alpha = i * 1.0 / (N-1);
-		retval[i] = (1-alpha) * first  +  alpha * last;
-	}
-
-	return retval;
-}
-
+#include "RenderSoundAdaptive.hpp"
+#include "RenderSoundRecurrence.hpp"
+#include "FarField.hpp"
+#include "FarFieldFft.hpp"
+#include "FarFieldNufft.hpp"
+#include "Broadband.hpp"
+#include "CrossSpectral.hpp"
+#include "DelayAndSum.hpp"
+#include "DirectivitySphere.hpp"
+#include "DistanceTable.hpp"
+#include "FieldKernel.hpp"
+#include "FieldPrecision.hpp"
+#include "PolarPattern.hpp"
+#include "RenderCache.hpp"
+#include "WorkerPool.hpp"
+
+#include "FieldBuffer.hpp"
+#include "FieldWriter.hpp"
+#include "MicArrayFactory.hpp"
+#include "StreamingCamera.hpp"
+#include "StringParse.hpp"
+#include "Sweep.hpp"
+#include "WavFile.hpp"
 
 void drawMicsToFile(const char* filename, std::vector<Transducer>& mics, int w, int h)
 {
-	unsigned char img[w*h];
-	memset(img, 0, w*h);
+	std::vector<unsigned char> img(size_t(w) * h, 0);
 
 	if (mics.size())
 	{
@@ -205,14 +119,64 @@ int main(int argc, char* argv[])
 	int showHelp = 0;
 	int dimensionArg = 512;
 	int polar = 0;
+	int polarText = 0;
+	int outOfCore = 0;
+	int numThreads = 0;
+	std::string isaArg = "scalar";
+	std::string precisionArg;
+	int reportError = 0;
+	std::string sweepArg;
+	std::string typesArg = "0,1,2,3,4,6";
+	std::string modeArg = "near";
+	std::string sphereArg;
+	std::string distanceCacheArg;
+	std::string renderCacheArg;
+	std::string formatArg = "pgm";
+	double dbRangeArg = 60;
+	std::string broadbandArg;
+	int binsArg = 32;
+	double toleranceArg = 0;
+	std::string recordingArg;
+	std::string beamformerArg = "csm";
+	std::string bandArg;
+	int frameSizeArg = 1024;
+	int removeDiagonal = 0;
+	std::string streamArg;
+	int streamFramesArg = 16;
+	int realtime = 0;
 
 	ArgumentParser parser;
 	parser.addInt("-f", &audioFrequency, "Frequency generated by simulator");
 	parser.addInt("-t", &typeArg, "Type of mic array");
 	parser.addInt("--dimension", &dimensionArg, "Width as well as height of wall image");
 	parser.addString("-o", &outputFilename, "Destination image filename");
+	parser.addString("--format", &formatArg, "Output format: pgm, pgm16db (16 bit dB scale), npy or pfm (float32)");
+	parser.addDouble("--db-range", &dbRangeArg, "Dynamic range (dB) of --format pgm16db");
+	parser.addSwitch("--out-of-core", &outOfCore, "Render tile by tile into a memory mapped npy or pfm file (walls larger than memory, --mode near)");
 	parser.addSwitch("-h", &showHelp, "Show this help");
 	parser.addSwitch("--polar", &polar, "Draw polar plot (instead of plot against plane in space)");
+	parser.addSwitch("--polar-text", &polarText, "With --polar, write the pattern as text (angle dB) instead of a png");
+	parser.addInt("--threads", &numThreads, "Number of worker threads (0 = one per core)");
+	parser.addString("--mode", &modeArg, "Wall renderer: near, recurrence, adaptive, farfield, uv or nufft (see README)");
+	parser.addDouble("--tolerance", &toleranceArg, "Accuracy of --mode nufft and adaptive, relative to the peak (0 = the mode's default)");
+	parser.addString("--isa", &isaArg, "Field kernel instruction set (scalar, auto, avx2, avx512). The default scalar kernel reproduces earlier images bit for bit");
+	parser.addString("--precision", &precisionArg, "Render with the double, float or mixed (float, double sums) kernel (--mode near)");
+	parser.addSwitch("--report-error", &reportError, "With --precision, also render the double reference and print the error");
+	parser.addString("--sweep", &sweepArg, "Render all frequencies first:last:step (-o is then an output directory, --mode near only)");
+	parser.addString("--broadband", &broadbandArg, "Render a band instead of -f: octave:FC, third-octave:FC, band:FLOW:FHIGH or custom:F1=W1,F2=W2,...");
+	parser.addInt("--bins", &binsArg, "Number of frequencies per --broadband band");
+	parser.addString("--distance-cache", &distanceCacheArg, "Directory for distance tables, reused between frequencies and runs (--mode near)");
+	parser.addString("--render-cache", &renderCacheArg, "Directory of rendered fields; identical walls are loaded from it instead of rendered");
+	parser.addString("--sphere", &sphereArg, "Write the 3D directivity (at distance z) over grid:NTHETA:NPHI or fibonacci:N directions to -o");
+	parser.addString("--recording", &recordingArg, "Image a WAV recording (one channel per mic of -t), see --beamformer");
+	parser.addString("--beamformer", &beamformerArg, "With --recording: csm (frequency domain, default) or das (time domain delay-and-sum)");
+	parser.addString("--band", &bandArg, "With --beamformer csm, only use frequencies FLOW:FHIGH (Hz)");
+	parser.addInt("--frame-size", &frameSizeArg, "With --beamformer csm, STFT frame length (a power of two)");
+	parser.addSwitch("--remove-diagonal", &removeDiagonal, "With --beamformer csm, leave out the auto spectra (uncorrelated mic noise)");
+	parser.addString("--stream", &streamArg, "Live camera over a WAV file or FIFO (e.g. from arecord -t wav); -o may contain %d for numbered images");
+	parser.addInt("--stream-frames", &streamFramesArg, "With --stream, STFT frames (of --frame-size) per image");
+	parser.addSwitch("--realtime", &realtime, "With --stream, capture at the samplerate and drop blocks and images which do not keep up");
+	parser.addString("--types", &typesArg, "Comma separated mic array types for --sweep");
 	parser.parse(argc, argv);
 
 	if (showHelp)
@@ -228,63 +192,104 @@ int main(int argc, char* argv[])
 	}
 
 
+	if (toleranceArg <= 0)
+	{
+		toleranceArg = modeArg == "adaptive" ? adaptiveDefaultTolerance : nufftDefaultTolerance;
+	}
+
+	FieldFormat format;
+	if (!parseFieldFormat(formatArg, format))
+	{
+		std::cout << "ERROR: unknown format \"" << formatArg << "\"." << std::endl;
+		return 2;
+	}
+
+	FieldPrecision precision = FieldPrecision::DOUBLE;
+	if (precisionArg.size() && !parseFieldPrecision(precisionArg, precision))
+	{
+		std::cout << "ERROR: unknown precision \"" << precisionArg << "\"." << std::endl;
+		return 2;
+	}
+
+	FieldKernelIsa isa;
+	if (!parseFieldKernelIsa(isaArg, isa))
+	{
+		std::cout << "ERROR: unknown instruction set \"" << isaArg << "\"." << std::endl;
+		return 2;
+	}
+	if (!isFieldKernelIsaSupported(isa))
+	{
+		std::cout << "WARNING: " << fieldKernelIsaName(isa) << " not supported, using scalar kernel." << std::endl;
+	}
+	setFieldKernelIsa(isa);
+
+	const double z = 10;
+	const double xmin = -10;
+	const double ymin = -10;
+	const double xmax = 10;
+	const double ymax = 10;
+
+	if (sweepArg.size())
+	{
+		if (modeArg != "near" || precisionArg.size() || broadbandArg.size())
+		{
+			std::cout << "ERROR: --sweep renders with --mode near only, without --precision or --broadband." << std::endl;
+			return 2;
+		}
+
+		SweepSettings settings;
+		if (!parseSweepRange(sweepArg, settings.frequencies))
+		{
+			std::cout << "ERROR: --sweep expects first:last:step, got \"" << sweepArg << "\"." << std::endl;
+			return 2;
+		}
+		if (!parseIntList(typesArg, settings.types))
+		{
+			std::cout << "ERROR: --types expects a comma separated list, got \"" << typesArg << "\"." << std::endl;
+			return 2;
+		}
+		settings.polar = polar;
+		settings.polarText = polarText;
+		settings.dimension = dimensionArg;
+		settings.z = z;
+		settings.xmin = xmin;
+		settings.xmax = xmax;
+		settings.ymin = ymin;
+		settings.ymax = ymax;
+		settings.speedOfSound = speedOfSound;
+		settings.outputDir = outputFilename;
+		settings.distanceCacheDir = distanceCacheArg;
+		settings.renderCacheDir = renderCacheArg;
+		settings.format = format;
+		settings.dynamicRangedB = dbRangeArg;
+
+		std::cout
+		<< "Starting sweep: "
+		<< settings.frequencies.size() << " frequencies x " << settings.types.size() << " types"
+		<< ", dimension=" << dimensionArg
+		<< ", threads=" << numThreads
+		<< ", isa=" << fieldKernelIsaName(getFieldKernelIsa())
+		<< ", o=" << outputFilename << std::endl;
+
+		WorkerPool pool(numThreads);
+		return runSweep(settings, pool) ? 1 : 0;
+	}
+
 	std::cout
 	<< "Starting beamforming simulator: "
 	<< ", f=" << audioFrequency
 	<< ", t=" << typeArg
 	<< ", dimension=" << dimensionArg
+	<< ", threads=" << numThreads
+	<< ", isa=" << fieldKernelIsaName(getFieldKernelIsa())
+	<< ", mode=" << modeArg
 	<< ", o=" << outputFilename << std::endl;
 
-	enum MicArrayType {
-		RING = 0,
-		DOUBLE_RING = 1,
-		RECTANGULAR = 2,
-		HOMO = 3,
-		SPIRAL1 = 7,
-		RESPEAKER_6_MIC_FOR_RPI = 6,
-		RESPEAKER_4_MIC_FOR_RPI = 4,
-		RANDOM = 10,
-	};
-
-	MicArrayType type = MicArrayType( typeArg );
-
-	ITransducerArray* micArray = 0;
-
-	switch(type)
-	{
-	case RING:
-		micArray = new SingleRingTransducerArray(48, 0.25);
-		break;
-	case RESPEAKER_4_MIC_FOR_RPI:
-		micArray = new RectangularTransducerArray(2, 0.058, 2, 0.058);
-		break;
-	case RESPEAKER_6_MIC_FOR_RPI:
-		micArray = new SingleRingTransducerArray(7, 0.0925/2);
-		break;
-	case DOUBLE_RING:
-		micArray = new DualRingTransducerArray(32, 0.25, 16, 0.125);
-		break;
-	case RECTANGULAR:
-		micArray = new RectangularTransducerArray(7, 0.5/6, 7, 0.5/6);
-		break;
-	case HOMO:
-		micArray = new HomogeneousTransducerArray(52, 0.07);
-		break;
-	case SPIRAL1:
-		micArray = new SpiralTransducerArray(0.010, 0.0, 0.3, 3.7, 48);
-		break;
-	case RANDOM:
+	std::unique_ptr<ITransducerArray> micArray = createMicArray(typeArg);
+	if (!micArray)
 	{
-		long seed = time(NULL);
-		std::cout << "Random seed = " << seed << std::endl;
-		srand48(seed);
-		micArray = new RandomTransducerArray(48, 0.5, 0.5);
-		break;
-	}
-	default:
 		assert(false);
 		return 1;
-		break;
 	}
 	//SingleRingTransducerArray micArray(48, 0.25);
 
@@ -298,11 +303,6 @@ int main(int argc, char* argv[])
 
 	// Dumbest most stupid way to sum up data...
 
-	const double z = 10;
-	const double xmin = -10;
-	const double ymin = -10;
-	const double xmax = 10;
-	const double ymax = 10;
 	const int w = dimensionArg;
 	const int h = dimensionArg;
 
@@ -317,42 +317,321 @@ int main(int argc, char* argv[])
 //	std::ofstream out("delme.m");
 //	out << "colormap(gray)\n";
 
-	double img[w*h];
 
+	if (sphereArg.size())
+	{
+		SphereGrid grid;
+		if (!parseSphereGrid(sphereArg, grid))
+		{
+			std::cout << "ERROR: --sphere expects grid:NTHETA:NPHI or fibonacci:N, got \"" << sphereArg << "\"." << std::endl;
+			return 2;
+		}
 
-	if (polar)
+		WorkerPool pool(numThreads);
+		DirectivitySphere sphere;
+		computeDirectivitySphere(grid, z, audioFrequency, mics, speedOfSound, sphere, pool);
+		if (!writeDirectivitySphere(outputFilename, sphere))
+		{
+			std::cout << "ERROR: could not write " << outputFilename << std::endl;
+			return 1;
+		}
+	}
+	else if (polar)
 	{
-		std::ostringstream oss;
-		oss << "f=" << audioFrequency << ", t=" << typeArg;
+		WorkerPool pool(numThreads);
+		std::vector<double> dB;
+		if (!computePolarPattern(z, audioFrequency, mics, speedOfSound, dB, pool))
+		{
+			std::cout << "ERROR: could not compute the polar pattern." << std::endl;
+			return 1;
+		}
 
-		renderSoundPolarPattern(z, audioFrequency, mics, speedOfSound, oss.str(), outputFilename);
+		if (polarText)
+		{
+			if (!writePolarPatternText(outputFilename, dB))
+			{
+				std::cout << "ERROR: could not write " << outputFilename << std::endl;
+				return 1;
+			}
+		}
+		else
+		{
+			std::ostringstream oss;
+			oss << "f=" << audioFrequency << ", t=" << typeArg;
+			if (!drawPolarPattern(dB, oss.str(), outputFilename))
+			{
+				std::cout << "ERROR: could not write " << outputFilename << std::endl;
+				return 1;
+			}
+		}
 	}
-	else
+	else if (streamArg.size())
 	{
-		renderSoundOnWall(xvals, yvals, z, audioFrequency, mics, speedOfSound, img);
-		//	//std::cout << "];" << std::endl << std::endl;
-		//	out << "];\nimagesc(img)" << std::endl;
+		StreamingSettings settings;
+		settings.spectral.frameSize = frameSizeArg;
+		settings.framesPerImage = streamFramesArg;
+		settings.realtime = realtime;
+		settings.removeDiagonal = removeDiagonal;
+		settings.beamformThreads = numThreads;
+		if (bandArg.size() && !parseCrossSpectralBand(bandArg, settings.spectral))
+		{
+			std::cout << "ERROR: --band expects FLOW:FHIGH, got \"" << bandArg << "\"." << std::endl;
+			return 2;
+		}
 
-		std::cout << "Done processing image" << std::endl;
+		std::string filename;
+		if (!formatNumberedFilename(outputFilename, 0, filename))
+		{
+			std::cout << "ERROR: -o may only contain a single %d with --stream, got \"" << outputFilename << "\"." << std::endl;
+			return 2;
+		}
+
+		WavStream source;
+		if (!source.open(streamArg))
+		{
+			std::cout << "ERROR: could not read " << streamArg << std::endl;
+			return 1;
+		}
+
+		size_t writeErrors = 0;
+		StreamingStats stats;
+		const bool ok = runStreamingCamera(source, xvals, yvals, z, mics, speedOfSound, settings,
+			[&](FieldBuffer const & img, size_t index)
+			{
+				formatNumberedFilename(outputFilename, index, filename);
+				if (!writeField(filename, format, img, dbRangeArg))
+				{
+					writeErrors++;
+				}
+			}, stats);
+		if (!ok)
+		{
+			std::cout
+			<< "ERROR: " << streamArg << " has " << source.numChannels() << " channels, expected " << mics.size()
+			<< " (and --frame-size must be a power of two, with at least one bin in --band)." << std::endl;
+			return 2;
+		}
+
+		std::cout
+		<< "Streamed " << stats.audioSeconds << " s of audio in " << stats.wallSeconds << " s ("
+		<< stats.audioSeconds / stats.wallSeconds << "x real time)" << std::endl
+		<< "Blocks: " << stats.blocksCaptured << " captured, " << stats.blocksDropped << " dropped" << std::endl
+		<< "Images: " << stats.imagesProduced << " produced, " << stats.imagesDropped << " dropped, "
+		<< stats.latencies.size() << " written" << std::endl
+		<< "Latency: median " << 1000 * stats.latencyPercentile(0.5) << " ms, 99% " << 1000 * stats.latencyPercentile(0.99)
+		<< " ms, max " << 1000 * stats.latencyPercentile(1) << " ms" << std::endl;
+		if (writeErrors)
+		{
+			std::cout << "ERROR: could not write " << writeErrors << " images to " << outputFilename << std::endl;
+			return 1;
+		}
+	}
+	else if (recordingArg.size())
+	{
+		Recording recording;
+		if (!readWav(recordingArg, recording))
+		{
+			std::cout << "ERROR: could not read " << recordingArg << std::endl;
+			return 1;
+		}
 
-		double max_val = 0;
-		for (int i = 0; i < w*h; i++)
+		WorkerPool pool(numThreads);
+		FieldBuffer img;
+		if (beamformerArg == "das")
+		{
+			DelayAndSum das(xvals, yvals, z, mics, recording.samplerate(), speedOfSound);
+			if (!das.image(recording, img, pool))
+			{
+				std::cout
+				<< "ERROR: " << recordingArg << " has " << recording.numChannels() << " channels and "
+				<< recording.numSamples() << " samples, expected " << mics.size() << " channels and more than "
+				<< das.maxDelay() << " samples." << std::endl;
+				return 2;
+			}
+		}
+		else if (beamformerArg == "csm")
 		{
-			if (img[i] > max_val) {
-				max_val = img[i];
+			CrossSpectralSettings settings;
+			settings.frameSize = frameSizeArg;
+			if (bandArg.size() && !parseCrossSpectralBand(bandArg, settings))
+			{
+				std::cout << "ERROR: --band expects FLOW:FHIGH, got \"" << bandArg << "\"." << std::endl;
+				return 2;
+			}
+
+			CrossSpectralMatrix csm;
+			if (!csm.compute(recording, settings, pool))
+			{
+				std::cout
+				<< "ERROR: could not compute the cross-spectral matrix of " << recordingArg
+				<< " (frame size a power of two, at most " << recording.numSamples() << " samples, and a band with at least one bin)." << std::endl;
+				return 2;
+			}
+			if (!beamformCrossSpectral(xvals, yvals, z, csm, mics, speedOfSound, removeDiagonal, img, pool))
+			{
+				std::cout
+				<< "ERROR: " << recordingArg << " has " << recording.numChannels() << " channels, expected "
+				<< mics.size() << "." << std::endl;
+				return 2;
 			}
 		}
+		else
+		{
+			std::cout << "ERROR: unknown beamformer \"" << beamformerArg << "\"." << std::endl;
+			return 2;
+		}
+		std::cout << "Done processing image" << std::endl;
+
+		if (!writeField(outputFilename, format, img, dbRangeArg))
+		{
+			std::cout << "ERROR: could not write " << outputFilename << std::endl;
+			return 1;
+		}
+	}
+	else if (outOfCore)
+	{
+		if (modeArg != "near" || broadbandArg.size() || (format != FieldFormat::NPY && format != FieldFormat::PFM))
+		{
+			std::cout << "ERROR: --out-of-core needs --mode near and --format npy or pfm." << std::endl;
+			return 2;
+		}
+		if (precisionArg.size() || distanceCacheArg.size() || renderCacheArg.size())
+		{
+			std::cout << "ERROR: --out-of-core renders without --precision, --distance-cache or --render-cache." << std::endl;
+			return 2;
+		}
 
-		if (outputFilename.size())
+		WorkerPool pool(numThreads);
+		if (!renderSoundOnWallToFile(xvals, yvals, z, audioFrequency, mics, speedOfSound, outputFilename, format, pool))
 		{
-			std::ofstream imgFile(outputFilename);
-			imgFile << "P5\n" << w << " " << h << "\n" << 255 << "\n";
+			std::cout << "ERROR: could not write " << outputFilename << std::endl;
+			return 1;
+		}
+		std::cout << "Done processing image" << std::endl;
+	}
+	else
+	{
+		FieldBuffer img(w, h);
+		WorkerPool pool(numThreads);
 
-			for (int i = 0; i < w*h; i++)
+		// Everything besides the grid and geometry which changes the rendered field
+		std::ostringstream renderer;
+		if (broadbandArg.size())
+		{
+			renderer << "broadband:" << broadbandArg << ":" << binsArg;
+		}
+		else
+		{
+			renderer << modeArg;
+			if (modeArg == "near" && precisionArg.size())
+			{
+				renderer << ":" << fieldPrecisionName(precision);
+			}
+			else if (modeArg == "near" && distanceCacheArg.size())
+			{
+				renderer << ":table";
+			}
+			else if (modeArg == "nufft" || modeArg == "adaptive")
+			{
+				renderer << ":" << toleranceArg;
+			}
+		}
+		// The SIMD kernels round differently from the scalar one
+		renderer << ":" << fieldKernelIsaName(getFieldKernelIsa());
+
+		RenderCache renderCache(renderCacheArg);
+		const uint64_t renderKey = modeArg == "uv" || modeArg == "nufft"
+			? renderCacheKey(renderer.str(), linspace(-1, 1, w), linspace(-1, 1, h), z, audioFrequency, mics, speedOfSound)
+			: renderCacheKey(renderer.str(), xvals, yvals, z, audioFrequency, mics, speedOfSound);
+		const bool cached = renderCacheArg.size() && renderCache.load(renderKey, img);
+		std::unique_ptr<FieldStreamWriter> stream;
+
+		if (cached)
+		{
+			std::cout << "Loaded " << renderCache.filename(renderKey) << std::endl;
+		}
+		else if (broadbandArg.size())
+		{
+			BroadbandSpectrum spectrum;
+			if (!parseBroadbandSpectrum(broadbandArg, binsArg, spectrum))
+			{
+				std::cout << "ERROR: could not parse --broadband \"" << broadbandArg << "\"." << std::endl;
+				return 2;
+			}
+			renderBroadbandOnWall(xvals, yvals, z, spectrum, mics, speedOfSound, img, pool);
+		}
+		else if (modeArg == "near" && precisionArg.size())
+		{
+			renderSoundOnWallPrecision(xvals, yvals, z, audioFrequency, mics, speedOfSound, precision, img, pool);
+			if (reportError)
 			{
-				imgFile << (unsigned char)(img[i] * 255 / max_val);
+				FieldBuffer reference;
+				renderSoundOnWall(xvals, yvals, z, audioFrequency, mics, speedOfSound, reference, pool);
+				FieldError error = compareFields(reference, img);
+				std::cout
+				<< "Error of " << fieldPrecisionName(precision) << " against double: "
+				<< "max " << error.maxRelative << ", rms " << error.rmsRelative << " (relative to the peak)" << std::endl;
 			}
 		}
+		else if (modeArg == "near" && distanceCacheArg.size())
+		{
+			DistanceTable table;
+			loadOrBuildDistanceTable(distanceCacheArg, xvals, yvals, z, mics, table, pool);
+			renderSoundOnWall(table, audioFrequency, speedOfSound, img, pool);
+		}
+		else if (modeArg == "near" && (format == FieldFormat::NPY || format == FieldFormat::PFM))
+		{
+			// Write every band of rows as soon as it is rendered
+			stream.reset(new FieldStreamWriter(outputFilename, format, w, h));
+			renderSoundOnWall(xvals, yvals, z, audioFrequency, mics, speedOfSound, img, pool,
+				[&](int y0, int y1) { stream->writeRows(y0, y1, img.row(y0)); });
+		}
+		else if (modeArg == "near")
+		{
+			renderSoundOnWall(xvals, yvals, z, audioFrequency, mics, speedOfSound, img, pool);
+		}
+		else if (modeArg == "recurrence")
+		{
+			renderSoundOnWallRecurrence(xvals, yvals, z, audioFrequency, mics, speedOfSound, img, pool);
+		}
+		else if (modeArg == "adaptive")
+		{
+			size_t evaluations = renderSoundOnWallAdaptive(xvals, yvals, z, audioFrequency, mics, speedOfSound, toleranceArg, img, pool);
+			std::cout << "Evaluated " << evaluations << " of " << img.size() << " pixels" << std::endl;
+		}
+		else if (modeArg == "farfield")
+		{
+			renderFarFieldOnWall(xvals, yvals, z, audioFrequency, mics, speedOfSound, img, pool);
+		}
+		else if (modeArg == "uv")
+		{
+			renderFarFieldFft(linspace(-1, 1, w), linspace(-1, 1, h), audioFrequency, mics, speedOfSound, img, pool);
+		}
+		else if (modeArg == "nufft")
+		{
+			renderFarFieldNufft(linspace(-1, 1, w), linspace(-1, 1, h), audioFrequency, mics, speedOfSound, toleranceArg, img, pool);
+		}
+		else
+		{
+			std::cout << "ERROR: unknown mode \"" << modeArg << "\"." << std::endl;
+			return 2;
+		}
+		//	//std::cout << "];" << std::endl << std::endl;
+		//	out << "];\nimagesc(img)" << std::endl;
+
+		std::cout << "Done processing image" << std::endl;
+
+		if (!cached && renderCacheArg.size() && !renderCache.store(renderKey, img))
+		{
+			std::cout << "WARNING: could not write " << renderCache.filename(renderKey) << std::endl;
+		}
+
+		const bool written = stream ? stream->close() : writeField(outputFilename, format, img, dbRangeArg);
+		if (!written)
+		{
+			std::cout << "ERROR: could not write " << outputFilename << std::endl;
+			return 1;
+		}
 	}
 
 	return 0;
@@ -0,0 +1,60 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "ApertureGrid.hpp"
+
+#include "arrays/RectangularTransducerArray.hpp"
+#include "arrays/SingleRingTransducerArray.hpp"
+
+#include <gtest/gtest.h>
+
+
+TEST(ApertureGrid, RectangularArrayIsFullGrid)
+{
+    RectangularTransducerArray mics(7, 0.5/6, 3, 0.1);
+    ApertureGrid grid;
+    ASSERT_TRUE(detectApertureGrid(mics.getTransducers(), grid));
+
+    EXPECT_EQ(7, grid.nx);
+    EXPECT_EQ(3, grid.ny);
+    EXPECT_NEAR(0.5/6, grid.dx, 1e-12);
+    EXPECT_NEAR(0.1, grid.dy, 1e-12);
+    EXPECT_NEAR(-0.25, grid.x0, 1e-12);
+    EXPECT_NEAR(-0.1, grid.y0, 1e-12);
+    EXPECT_TRUE(grid.isFull());
+}
+
+TEST(ApertureGrid, SparseGridHasZeroWeights)
+{
+    // An L shape on a 3x3 lattice with spacing 0.5
+    std::vector<Transducer> mics(5);
+    mics[0].pos = Pos(0.0, 0.0, 0);
+    mics[1].pos = Pos(0.5, 0.0, 0);
+    mics[2].pos = Pos(1.0, 0.0, 0);
+    mics[3].pos = Pos(0.0, 0.5, 0);
+    mics[4].pos = Pos(0.0, 1.0, 0);
+
+    ApertureGrid grid;
+    ASSERT_TRUE(detectApertureGrid(mics, grid));
+    ASSERT_EQ(3, grid.nx);
+    ASSERT_EQ(3, grid.ny);
+    EXPECT_FALSE(grid.isFull());
+    EXPECT_EQ(std::vector<double>({1, 1, 1, 1, 0, 0, 1, 0, 0}), grid.weights);
+}
+
+TEST(ApertureGrid, RingIsNotGridded)
+{
+    SingleRingTransducerArray mics(7, 0.25);
+    ApertureGrid grid;
+    EXPECT_FALSE(detectApertureGrid(mics.getTransducers(), grid));
+}
+
+TEST(ApertureGrid, DifferentZIsNotGridded)
+{
+    std::vector<Transducer> mics(2);
+    mics[0].pos = Pos(0, 0, 0);
+    mics[1].pos = Pos(1, 0, 0.1);
+    ApertureGrid grid;
+    EXPECT_FALSE(detectApertureGrid(mics, grid));
+}
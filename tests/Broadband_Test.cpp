@@ -0,0 +1,135 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "Broadband.hpp"
+#include "RenderSound.hpp"
+
+#include "arrays/SingleRingTransducerArray.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+
+namespace {
+    /** Reference: one renderSoundOnWall() per frequency, powers added up */
+    FieldBuffer renderPerFrequency(std::vector<double> const & xvals, std::vector<double> const & yvals, double z,
+            BroadbandSpectrum const & spectrum, std::vector<Transducer> const & mics)
+    {
+        FieldBuffer sum(xvals.size(), yvals.size());
+        std::fill(sum.data(), sum.data() + sum.size(), 0.0);
+        for (size_t n = 0; n < spectrum.frequencies.size(); n++)
+        {
+            FieldBuffer img;
+            renderSoundOnWall(xvals, yvals, z, spectrum.frequencies[n], mics, 343, img);
+            for (size_t i = 0; i < img.size(); i++)
+            {
+                sum.data()[i] += spectrum.weights[n] * sqr(img.data()[i]);
+            }
+        }
+        for (size_t i = 0; i < sum.size(); i++)
+        {
+            sum.data()[i] = std::sqrt(sum.data()[i]);
+        }
+        return sum;
+    }
+
+    void expectEachPixelRelativeNear(FieldBuffer const & expected, FieldBuffer const & actual, double tolerance)
+    {
+        ASSERT_EQ(expected.size(), actual.size());
+        for (size_t i = 0; i < expected.size(); i++)
+        {
+            ASSERT_NEAR(expected.data()[i], actual.data()[i], tolerance * expected.data()[i]) << "pixel " << i;
+        }
+    }
+}
+
+TEST(Broadband, Spectra)
+{
+    BroadbandSpectrum s = bandSpectrum(1000, 2000, 4);
+    EXPECT_EQ(std::vector<double>({ 1125, 1375, 1625, 1875 }), s.frequencies);
+    EXPECT_EQ(std::vector<double>({ 0.25, 0.25, 0.25, 0.25 }), s.weights);
+
+    // Octave band around 1000 Hz is [707, 1414]
+    s = fractionalOctaveSpectrum(1000, 1, 2);
+    const double width = 1000 * (sqrt(2.0) - 1 / sqrt(2.0));
+    EXPECT_NEAR(1000 / sqrt(2.0) + 0.25 * width, s.frequencies[0], 1e-9);
+    EXPECT_NEAR(1000 / sqrt(2.0) + 0.75 * width, s.frequencies[1], 1e-9);
+
+    // Linear bins, so the middle one is the arithmetic mean of the band edges
+    s = fractionalOctaveSpectrum(1000, 3, 3);
+    EXPECT_NEAR(500 * (pow(2.0, -1.0 / 6) + pow(2.0, 1.0 / 6)), s.frequencies[1], 1e-9);
+}
+
+TEST(Broadband, Parse)
+{
+    BroadbandSpectrum s;
+    ASSERT_TRUE(parseBroadbandSpectrum("octave:1000", 8, s));
+    EXPECT_EQ(8u, s.frequencies.size());
+    ASSERT_TRUE(parseBroadbandSpectrum("third-octave:2000", 5, s));
+    EXPECT_NEAR(1000 * (pow(2.0, -1.0 / 6) + pow(2.0, 1.0 / 6)), s.frequencies[2], 1e-9);
+    ASSERT_TRUE(parseBroadbandSpectrum("band:500:1500", 10, s));
+    EXPECT_EQ(550.0, s.frequencies[0]);
+
+    ASSERT_TRUE(parseBroadbandSpectrum("custom:1000=3,2500=1", 10, s));
+    EXPECT_EQ(std::vector<double>({ 1000, 2500 }), s.frequencies);
+    EXPECT_EQ(std::vector<double>({ 0.75, 0.25 }), s.weights);
+
+    EXPECT_FALSE(parseBroadbandSpectrum("octave", 8, s));
+    EXPECT_FALSE(parseBroadbandSpectrum("band:1500:500", 8, s));
+    EXPECT_FALSE(parseBroadbandSpectrum("custom:", 8, s));
+    EXPECT_FALSE(parseBroadbandSpectrum("custom:1000", 8, s));
+    EXPECT_FALSE(parseBroadbandSpectrum("custom:1000=0", 8, s));
+    EXPECT_FALSE(parseBroadbandSpectrum("custom:1000=0,2000=0", 8, s));
+    EXPECT_FALSE(parseBroadbandSpectrum("pink:1000", 8, s));
+    EXPECT_FALSE(parseBroadbandSpectrum("octave:1000", 0, s));
+}
+
+TEST(Broadband, SingleFrequencyMatchesNarrowband)
+{
+    SingleRingTransducerArray mics(48, 0.25);
+    std::vector<double> xvals = linspace(-10, 10, 40);
+    std::vector<double> yvals = linspace(-10, 10, 30);
+    WorkerPool pool(2);
+
+    BroadbandSpectrum s;
+    s.frequencies = { 3000 };
+    s.weights = { 1 };
+
+    FieldBuffer expected;
+    FieldBuffer actual;
+    renderSoundOnWall(xvals, yvals, 10, 3000, mics.getTransducers(), 343, expected);
+    renderBroadbandOnWall(xvals, yvals, 10, s, mics.getTransducers(), 343, actual, pool);
+    // The default scalar kernel uses libm sin/cos, the broadband renderer sinCos()
+    // (~1 ulp), which pixels in deep nulls amplify to a few 1e-12 relative
+    expectEachPixelRelativeNear(expected, actual, 1e-11);
+}
+
+TEST(Broadband, BandMatchesSumOfNarrowband)
+{
+    SingleRingTransducerArray mics(48, 0.25);
+    std::vector<double> xvals = linspace(-10, 10, 32);
+    std::vector<double> yvals = linspace(-10, 10, 24);
+    WorkerPool pool(2);
+
+    // 70 evenly spaced bins, more than two anchor intervals
+    BroadbandSpectrum s = fractionalOctaveSpectrum(2000, 1, 70);
+    FieldBuffer actual;
+    renderBroadbandOnWall(xvals, yvals, 10, s, mics.getTransducers(), 343, actual, pool);
+    expectEachPixelRelativeNear(renderPerFrequency(xvals, yvals, 10, s, mics.getTransducers()), actual, 1e-10);
+}
+
+TEST(Broadband, CustomSpectrumMatchesSumOfNarrowband)
+{
+    SingleRingTransducerArray mics(7, 0.05);
+    std::vector<double> xvals = linspace(-10, 10, 20);
+    std::vector<double> yvals = linspace(-10, 10, 20);
+    WorkerPool pool(1);
+
+    BroadbandSpectrum s;
+    ASSERT_TRUE(parseBroadbandSpectrum("custom:500=1,1200=2,4000=0.5", 1, s));
+    FieldBuffer actual;
+    renderBroadbandOnWall(xvals, yvals, 10, s, mics.getTransducers(), 343, actual, pool);
+    expectEachPixelRelativeNear(renderPerFrequency(xvals, yvals, 10, s, mics.getTransducers()), actual, 1e-12);
+}
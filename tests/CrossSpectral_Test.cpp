@@ -0,0 +1,151 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "CrossSpectral.hpp"
+#include "DelayAndSum.hpp"
+#include "RenderSound.hpp"
+#include "SceneSimulator.hpp"
+
+#include "arrays/RectangularTransducerArray.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdlib>
+
+
+namespace {
+    Recording simulate(std::vector<FakePointSoundSource> const & sources, std::vector<Transducer> const & mics,
+            int samplerate, size_t numSamples)
+    {
+        WorkerPool pool(1);
+        SceneSimulator scene(sources, mics, samplerate);
+        std::vector<double> samples = scene.render(0, numSamples, SampleLayout::PLANAR, pool);
+
+        Recording recording(samplerate, mics.size(), numSamples);
+        for (size_t ch = 0; ch < mics.size(); ch++)
+        {
+            std::copy(samples.begin() + ch * numSamples, samples.begin() + (ch + 1) * numSamples, recording.channel(ch));
+        }
+        return recording;
+    }
+
+    int argmax(FieldBuffer const & img)
+    {
+        return std::max_element(img.data(), img.data() + img.size()) - img.data();
+    }
+}
+
+TEST(CrossSpectral, MatchesDirectDft)
+{
+    // Odd number of channels, so one FFT carries a single channel
+    const size_t N = 64;
+    Recording recording(8000, 3, 200);
+    srand48(3);
+    for (size_t ch = 0; ch < 3; ch++)
+    {
+        for (size_t n = 0; n < 200; n++)
+        {
+            recording.channel(ch)[n] = float(drand48() - 0.5);
+        }
+    }
+
+    CrossSpectralSettings settings;
+    settings.frameSize = N;
+    settings.minFrequency = 1000;
+    settings.maxFrequency = 2000;
+    CrossSpectralMatrix csm;
+    WorkerPool pool(2);
+    ASSERT_TRUE(csm.compute(recording, settings, pool));
+    ASSERT_EQ(5u, csm.numFrames());   // (200 - 64) / 32 + 1
+    ASSERT_EQ(9u, csm.numBins());     // bins 8 ... 16 of 125 Hz
+    EXPECT_EQ(8u, csm.binIndex(0));
+    EXPECT_DOUBLE_EQ(2000, csm.binFrequency(8));
+
+    for (size_t b = 0; b < csm.numBins(); b++)
+    {
+        const size_t k = csm.binIndex(b);
+        std::vector<std::complex<double> > expected(9, 0.0);
+        for (size_t frame = 0; frame < csm.numFrames(); frame++)
+        {
+            std::complex<double> X[3];
+            for (size_t ch = 0; ch < 3; ch++)
+            {
+                for (size_t n = 0; n < N; n++)
+                {
+                    double w = 0.5 - 0.5 * std::cos(2 * M_PI * n / N);
+                    X[ch] += w * recording.channel(ch)[frame * N / 2 + n] * std::polar(1.0, -2 * M_PI * k * n / N);
+                }
+            }
+            for (size_t i = 0; i < 3; i++)
+            {
+                for (size_t j = 0; j < 3; j++)
+                {
+                    expected[i * 3 + j] += X[i] * std::conj(X[j]) / double(csm.numFrames());
+                }
+            }
+        }
+
+        for (size_t i = 0; i < 3; i++)
+        {
+            for (size_t j = 0; j < 3; j++)
+            {
+                EXPECT_NEAR(expected[i * 3 + j].real(), csm.at(b, i, j).real(), 1e-9);
+                EXPECT_NEAR(expected[i * 3 + j].imag(), csm.at(b, i, j).imag(), 1e-9);
+            }
+        }
+    }
+}
+
+TEST(CrossSpectral, AgreesWithDelayAndSum)
+{
+    RectangularTransducerArray array(8, 0.5 / 7, 8, 0.5 / 7);
+    std::vector<double> xvals = linspace(-2, 2, 21);
+    std::vector<double> yvals = linspace(-2, 2, 21);
+    const double z = 3;
+    const int samplerate = 48000;
+
+    const Pos sourcePos(xvals[15], yvals[7], z);
+    FakePointSoundSource source(sourcePos, 10.0, 4000, 0.0, 343);
+    Recording recording = simulate({ source }, array.getTransducers(), samplerate, 8192);
+    WorkerPool pool(2);
+
+    CrossSpectralMatrix csm;
+    ASSERT_TRUE(csm.compute(recording, CrossSpectralSettings(), pool));
+    FieldBuffer img;
+    ASSERT_TRUE(beamformCrossSpectral(xvals, yvals, z, csm, array.getTransducers(), 343, false, img, pool));
+    ASSERT_EQ(21, img.width());
+    ASSERT_EQ(21, img.height());
+    EXPECT_EQ(7 * 21 + 15, argmax(img));
+
+    // Same scale as the time domain beamformer (which loses a little to linear interpolation)
+    FieldBuffer reference;
+    DelayAndSum das(xvals, yvals, z, array.getTransducers(), samplerate, 343);
+    ASSERT_TRUE(das.image(recording, reference, pool));
+    EXPECT_NEAR(reference.at(15, 7), img.at(15, 7), 0.03 * reference.at(15, 7));
+
+    // Without the auto spectra, a single coherent source still peaks in the same place
+    ASSERT_TRUE(beamformCrossSpectral(xvals, yvals, z, csm, array.getTransducers(), 343, true, img, pool));
+    EXPECT_EQ(7 * 21 + 15, argmax(img));
+}
+
+TEST(CrossSpectral, RejectsBadInput)
+{
+    CrossSpectralMatrix csm;
+    WorkerPool pool(1);
+    CrossSpectralSettings settings;
+
+    settings.frameSize = 1000;
+    EXPECT_FALSE(csm.compute(Recording(8000, 2, 4000), settings, pool));
+    settings.frameSize = 1024;
+    EXPECT_FALSE(csm.compute(Recording(8000, 2, 1000), settings, pool));
+    settings.minFrequency = 5000;
+    EXPECT_FALSE(csm.compute(Recording(8000, 2, 4000), settings, pool));
+    settings.minFrequency = 0;
+    ASSERT_TRUE(csm.compute(Recording(8000, 2, 4000), settings, pool));
+
+    RectangularTransducerArray array(2, 0.1, 2, 0.1);
+    FieldBuffer img;
+    EXPECT_FALSE(beamformCrossSpectral(linspace(-1, 1, 4), linspace(-1, 1, 4), 1, csm, array.getTransducers(), 343, false, img, pool));
+}
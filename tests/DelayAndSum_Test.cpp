@@ -0,0 +1,88 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "DelayAndSum.hpp"
+#include "RenderSound.hpp"
+#include "SceneSimulator.hpp"
+
+#include "arrays/RectangularTransducerArray.hpp"
+
+#include <gtest/gtest.h>
+
+
+namespace {
+    Recording simulate(std::vector<FakePointSoundSource> const & sources, std::vector<Transducer> const & mics,
+            int samplerate, size_t numSamples)
+    {
+        WorkerPool pool(1);
+        SceneSimulator scene(sources, mics, samplerate);
+        std::vector<double> samples = scene.render(0, numSamples, SampleLayout::PLANAR, pool);
+
+        Recording recording(samplerate, mics.size(), numSamples);
+        for (size_t ch = 0; ch < mics.size(); ch++)
+        {
+            std::copy(samples.begin() + ch * numSamples, samples.begin() + (ch + 1) * numSamples, recording.channel(ch));
+        }
+        return recording;
+    }
+}
+
+TEST(DelayAndSum, PeakAtTheSource)
+{
+    RectangularTransducerArray array(8, 0.5 / 7, 8, 0.5 / 7);
+    std::vector<double> xvals = linspace(-2, 2, 21);
+    std::vector<double> yvals = linspace(-2, 2, 21);
+    const double z = 3;
+    const int samplerate = 48000;
+
+    // On the grid point (15, 7)
+    const Pos sourcePos(xvals[15], yvals[7], z);
+    FakePointSoundSource source(sourcePos, 10.0, 4000, 0.0, 343);
+    Recording recording = simulate({ source }, array.getTransducers(), samplerate, 4096);
+
+    DelayAndSum das(xvals, yvals, z, array.getTransducers(), samplerate, 343);
+    FieldBuffer img;
+    WorkerPool pool(2);
+    ASSERT_TRUE(das.image(recording, img, pool));
+    ASSERT_EQ(21, img.width());
+    ASSERT_EQ(21, img.height());
+
+    int bestX = 0;
+    int bestY = 0;
+    for (int y = 0; y < img.height(); y++)
+    {
+        for (int x = 0; x < img.width(); x++)
+        {
+            if (img.at(x, y) > img.at(bestX, bestY))
+            {
+                bestX = x;
+                bestY = y;
+            }
+        }
+    }
+    EXPECT_EQ(15, bestX);
+    EXPECT_EQ(7, bestY);
+
+    // Perfectly aligned there: the rms of the average mic signal (linear interpolation loses a little)
+    double meanAmplitude = 0;
+    for (auto const & mic : array.getTransducers())
+    {
+        meanAmplitude += source.getAmplitude(mic.pos) / array.getTransducers().size();
+    }
+    EXPECT_NEAR(meanAmplitude / std::sqrt(2.0), img.at(15, 7), 0.03 * meanAmplitude);
+}
+
+TEST(DelayAndSum, RejectsMismatchedRecordings)
+{
+    RectangularTransducerArray array(2, 0.1, 2, 0.1);
+    std::vector<double> vals = linspace(-1, 1, 5);
+    DelayAndSum das(vals, vals, 1, array.getTransducers(), 16000, 343);
+    FieldBuffer img;
+    WorkerPool pool(1);
+
+    EXPECT_FALSE(das.image(Recording(16000, 3, 1000), img, pool));
+    EXPECT_FALSE(das.image(Recording(8000, 4, 1000), img, pool));
+    EXPECT_FALSE(das.image(Recording(16000, 4, das.maxDelay()), img, pool));
+    EXPECT_TRUE(das.image(Recording(16000, 4, 1000), img, pool));
+}
@@ -0,0 +1,124 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "DirectivitySphere.hpp"
+#include "RenderSound.hpp"
+
+#include "arrays/SingleRingTransducerArray.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+
+
+TEST(DirectivitySphere, ParseGrid)
+{
+    SphereGrid grid;
+    ASSERT_TRUE(parseSphereGrid("grid:91:180", grid));
+    EXPECT_EQ(SphereSampling::THETA_PHI, grid.sampling);
+    EXPECT_EQ(91, grid.nTheta);
+    EXPECT_EQ(180, grid.nPhi);
+    EXPECT_EQ(91 * 180, grid.count);
+
+    ASSERT_TRUE(parseSphereGrid("fibonacci:5000", grid));
+    EXPECT_EQ(SphereSampling::FIBONACCI, grid.sampling);
+    EXPECT_EQ(5000, grid.count);
+
+    EXPECT_FALSE(parseSphereGrid("grid:91", grid));
+    EXPECT_FALSE(parseSphereGrid("grid:1:10", grid));
+    EXPECT_FALSE(parseSphereGrid("fibonacci:", grid));
+    EXPECT_FALSE(parseSphereGrid("healpix:8", grid));
+    EXPECT_FALSE(parseSphereGrid("grid:3:4:", grid));
+    EXPECT_FALSE(parseSphereGrid("grid:3:4:5", grid));
+    EXPECT_FALSE(parseSphereGrid("grid::4", grid));
+    EXPECT_FALSE(parseSphereGrid("fibonacci:5,", grid));
+
+    // nTheta * nPhi must fit, not wrap around
+    EXPECT_FALSE(parseSphereGrid("grid:65536:65536", grid));
+    EXPECT_FALSE(parseSphereGrid("fibonacci:4294967297", grid));
+}
+
+TEST(DirectivitySphere, DirectionsAreUnitVectors)
+{
+    for (SphereGrid grid : { thetaPhiSphere(19, 36), fibonacciSphere(1000) })
+    {
+        Pos mean;
+        for (int i = 0; i < grid.count; i++)
+        {
+            Pos d = grid.direction(i);
+            EXPECT_NEAR(1.0, d.dist(Pos()), 1e-12);
+            mean.x += d.x / grid.count;
+            mean.y += d.y / grid.count;
+            mean.z += d.z / grid.count;
+        }
+        // Both samplings are symmetric around the origin
+        EXPECT_NEAR(0.0, mean.dist(Pos()), 1e-2);
+    }
+
+    SphereGrid grid = thetaPhiSphere(3, 4);
+    EXPECT_NEAR(1.0, grid.direction(0).z, 1e-12);     // theta = 0
+    EXPECT_NEAR(1.0, grid.direction(4).x, 1e-12);     // theta = 90, phi = 0
+    EXPECT_NEAR(1.0, grid.direction(5).y, 1e-12);     // theta = 90, phi = 90
+    EXPECT_NEAR(-1.0, grid.direction(11).z, 1e-12);   // theta = 180
+}
+
+TEST(DirectivitySphere, MatchesDirectEvaluation)
+{
+    SingleRingTransducerArray mics(48, 0.25);
+    SphereGrid grid = fibonacciSphere(3000);
+    WorkerPool pool(3);
+
+    DirectivitySphere sphere;
+    computeDirectivitySphere(grid, 10, 3000, mics.getTransducers(), 343, sphere, pool);
+    ASSERT_EQ(3000u, sphere.rms.size());
+
+    for (int i = 0; i < grid.count; i += 7)
+    {
+        double expected = phasorToRms(sumPhasors(getPhasors(mics.getTransducers(), grid.direction(i) * 10, 3000, 343)));
+        EXPECT_NEAR(expected, sphere.rms[i], 1e-6 * expected) << i;
+    }
+}
+
+TEST(DirectivitySphere, WriteAndRead)
+{
+    SingleRingTransducerArray mics(7, 0.05);
+    WorkerPool pool(1);
+    DirectivitySphere sphere;
+    computeDirectivitySphere(thetaPhiSphere(10, 20), 5, 2000, mics.getTransducers(), 343, sphere, pool);
+
+    const std::string filename = testing::TempDir() + "DirectivitySphere_Test.sphere";
+    ASSERT_TRUE(writeDirectivitySphere(filename, sphere));
+
+    DirectivitySphere loaded;
+    ASSERT_TRUE(readDirectivitySphere(filename, loaded));
+    EXPECT_EQ(SphereSampling::THETA_PHI, loaded.grid.sampling);
+    EXPECT_EQ(10, loaded.grid.nTheta);
+    EXPECT_EQ(20, loaded.grid.nPhi);
+    EXPECT_EQ(200, loaded.grid.count);
+    EXPECT_EQ(2000, loaded.audioFrequency);
+    EXPECT_EQ(5, loaded.radius);
+    EXPECT_EQ(343, loaded.speedOfSound);
+    EXPECT_EQ(sphere.rms, loaded.rms);
+    remove(filename.c_str());
+
+    EXPECT_FALSE(readDirectivitySphere(filename, loaded));
+}
+
+TEST(DirectivitySphere, ReadRejectsInconsistentGrid)
+{
+    SingleRingTransducerArray mics(7, 0.05);
+    WorkerPool pool(1);
+    DirectivitySphere sphere;
+    computeDirectivitySphere(thetaPhiSphere(10, 20), 5, 2000, mics.getTransducers(), 343, sphere, pool);
+
+    // A count which does not match nTheta * nPhi would make direction() go past the grid
+    sphere.grid.count = 150;
+    sphere.rms.resize(150);
+    const std::string filename = testing::TempDir() + "DirectivitySphere_Test_inconsistent.sphere";
+    ASSERT_TRUE(writeDirectivitySphere(filename, sphere));
+
+    DirectivitySphere loaded;
+    EXPECT_FALSE(readDirectivitySphere(filename, loaded));
+    remove(filename.c_str());
+}
@@ -0,0 +1,125 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "DistanceTable.hpp"
+#include "RenderSound.hpp"
+
+#include "arrays/SingleRingTransducerArray.hpp"
+#include "arrays/SpiralTransducerArray.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+
+
+namespace {
+    void expectNearRelativeToPeak(FieldBuffer const & expected, FieldBuffer const & actual, double tolerance)
+    {
+        ASSERT_EQ(expected.width(), actual.width());
+        ASSERT_EQ(expected.height(), actual.height());
+        double peak = *std::max_element(expected.data(), expected.data() + expected.size());
+        for (size_t i = 0; i < expected.size(); i++)
+        {
+            ASSERT_NEAR(expected.data()[i], actual.data()[i], tolerance * peak) << "pixel " << i;
+        }
+    }
+}
+
+TEST(DistanceTable, Layout)
+{
+    SingleRingTransducerArray mics(7, 0.05);
+    std::vector<double> xvals = linspace(-1, 1, 5);
+    std::vector<double> yvals = linspace(-1, 1, 3);
+    WorkerPool pool(1);
+
+    DistanceTable table;
+    table.build(xvals, yvals, 2, mics.getTransducers(), pool);
+    EXPECT_EQ(5u, table.width());
+    EXPECT_EQ(3u, table.height());
+    EXPECT_EQ(7u, table.numTransducers());
+    EXPECT_EQ(16u, table.stride());
+    EXPECT_FALSE(table.isMapped());
+
+    Pos listener(xvals[4], yvals[1], 2);
+    double reference = listener.dist(mics.getTransducers()[0].pos);
+    for (size_t j = 0; j < 7; j++)
+    {
+        double d = listener.dist(mics.getTransducers()[j].pos);
+        EXPECT_NEAR(d - reference, table.distance(4, 1)[j], 1e-7);
+        EXPECT_NEAR(1 / (d * d), table.amplitude(4, 1)[j], 1e-7 / (d * d));
+    }
+    for (size_t j = 7; j < 16; j++)
+    {
+        EXPECT_EQ(0.0f, table.amplitude(4, 1)[j]);
+    }
+}
+
+TEST(DistanceTable, KeyDependsOnGeometry)
+{
+    SingleRingTransducerArray ring(48, 0.25);
+    SingleRingTransducerArray smallRing(48, 0.2);
+    std::vector<double> vals = linspace(-10, 10, 64);
+
+    uint64_t key = distanceTableKey(vals, vals, 10, ring.getTransducers());
+    EXPECT_EQ(key, distanceTableKey(vals, vals, 10, ring.getTransducers()));
+    EXPECT_NE(key, distanceTableKey(vals, vals, 11, ring.getTransducers()));
+    EXPECT_NE(key, distanceTableKey(vals, linspace(-10, 10, 65), 10, ring.getTransducers()));
+    EXPECT_NE(key, distanceTableKey(vals, vals, 10, smallRing.getTransducers()));
+}
+
+TEST(DistanceTable, RenderMatchesDirect)
+{
+    SpiralTransducerArray mics(0.010, 0.0, 0.3, 3.7, 48);
+    std::vector<double> xvals = linspace(-10, 10, 48);
+    std::vector<double> yvals = linspace(-10, 10, 40);
+    WorkerPool pool(2);
+
+    DistanceTable table;
+    table.build(xvals, yvals, 10, mics.getTransducers(), pool);
+
+    for (double f : { 500.0, 3000.0, 12000.0 })
+    {
+        FieldBuffer expected;
+        FieldBuffer actual;
+        renderSoundOnWall(xvals, yvals, 10, f, mics.getTransducers(), 343, expected);
+        renderSoundOnWall(table, f, 343, actual, pool);
+        expectNearRelativeToPeak(expected, actual, 1e-5);
+    }
+}
+
+TEST(DistanceTable, SaveAndMap)
+{
+    SingleRingTransducerArray mics(48, 0.25);
+    std::vector<double> xvals = linspace(-10, 10, 33);
+    std::vector<double> yvals = linspace(-10, 10, 17);
+    WorkerPool pool(2);
+    const std::string directory = testing::TempDir();
+
+    DistanceTable built;
+    loadOrBuildDistanceTable(directory, xvals, yvals, 10, mics.getTransducers(), built, pool);
+
+    DistanceTable mapped;
+    loadOrBuildDistanceTable(directory, xvals, yvals, 10, mics.getTransducers(), mapped, pool);
+    ASSERT_TRUE(mapped.isMapped());
+    EXPECT_EQ(built.key(), mapped.key());
+    EXPECT_EQ(built.stride(), mapped.stride());
+
+    FieldBuffer fromBuilt;
+    FieldBuffer fromMapped;
+    renderSoundOnWall(built, 3000, 343, fromBuilt, pool);
+    renderSoundOnWall(mapped, 3000, 343, fromMapped, pool);
+    for (size_t i = 0; i < fromBuilt.size(); i++)
+    {
+        ASSERT_EQ(fromBuilt.data()[i], fromMapped.data()[i]);
+    }
+
+    // Another geometry must not pick up this file
+    char name[32];
+    snprintf(name, sizeof(name), "dist_%016llx.bin", (unsigned long long)mapped.key());
+    DistanceTable other;
+    EXPECT_FALSE(other.map(directory + name, mapped.key() + 1));
+    EXPECT_TRUE(other.map(directory + name, mapped.key()));
+    remove((directory + name).c_str());
+}
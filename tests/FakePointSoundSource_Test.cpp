@@ -87,3 +87,77 @@ TEST(FakePointSoundSource, TwoDistanceUnitsAway)
     EXPECT_NEAR(0.0, samples[2], 1e-10);
     EXPECT_NEAR(-0.5, samples[3], 1e-10);
 }
+
+namespace {
+    /** Direct evaluation, in long double so that it stays exact far into the signal. */
+    double referenceSample(Pos const & source, Pos const & listener, double amplitude, double freq, double phase,
+            double speedOfSound, int samplerate, int64_t n)
+    {
+        long double d = source.dist(listener);
+        long double t = (long double)n / samplerate - d / speedOfSound;
+        return double(amplitude / (d * d) * std::sin(2 * 3.141592653589793238462643383279503L * freq * t + phase));
+    }
+}
+
+TEST(FakePointSoundSource, BlockMatchesDirectEvaluation)
+{
+    Pos pos(0.3, -0.2, 2.0);
+    FakePointSoundSource dut(pos, 2.0, 1234.5, 0.7, 343.0);
+    Pos listenerPos(0.01, 0.02, 0.0);
+
+    // Far into the signal, and a length which is not a multiple of the block size
+    const int samplerate = 48000;
+    const int64_t firstSample = int64_t(samplerate) * 3600;
+    std::vector<double> samples(1000);
+    dut.getSamples(listenerPos, samplerate, firstSample, samples.data(), samples.size());
+
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        double expected = referenceSample(pos, listenerPos, 2.0, 1234.5, 0.7, 343.0, samplerate, firstSample + i);
+        ASSERT_NEAR(expected, samples[i], 1e-9) << "sample " << i;
+    }
+}
+
+TEST(FakePointSoundSource, ConsecutiveBlocksAreContinuous)
+{
+    FakePointSoundSource dut(Pos(0, 0, 1), 1.0, 440.0, 0.0, 343.0);
+    Pos listenerPos(0.1, 0, 0);
+
+    std::vector<double> whole = dut.getSamples(listenerPos, 44100, 300);
+    std::vector<double> blocks(300);
+    dut.getSamples(listenerPos, 44100, 0, blocks.data(), 100);
+    dut.getSamples(listenerPos, 44100, 100, blocks.data() + 100, 200);
+
+    for (size_t i = 0; i < whole.size(); i++)
+    {
+        EXPECT_NEAR(whole[i], blocks[i], 1e-12);
+    }
+}
+
+TEST(FakePointSoundSource, PlanarAndInterleavedLayouts)
+{
+    Pos pos(1.0, 0.5, 3.0);
+    FakePointSoundSource dut(pos, 1.0, 3000.0, 0.0, 343.0);
+    std::vector<Pos> listeners;
+    for (int i = 0; i < 5; i++)
+    {
+        listeners.push_back(Pos(0.05 * i, -0.03 * i, 0));
+    }
+
+    const int samplerate = 16000;
+    const size_t numSamples = 150;
+    std::vector<double> planar(numSamples * listeners.size());
+    std::vector<double> interleaved(numSamples * listeners.size());
+    dut.getSamples(listeners, samplerate, 7, planar.data(), numSamples, SampleLayout::PLANAR);
+    dut.getSamples(listeners, samplerate, 7, interleaved.data(), numSamples, SampleLayout::INTERLEAVED);
+
+    for (size_t ch = 0; ch < listeners.size(); ch++)
+    {
+        for (size_t n = 0; n < numSamples; n++)
+        {
+            double expected = referenceSample(pos, listeners[ch], 1.0, 3000.0, 0.0, 343.0, samplerate, 7 + n);
+            EXPECT_NEAR(expected, planar[ch * numSamples + n], 1e-12);
+            EXPECT_EQ(planar[ch * numSamples + n], interleaved[n * listeners.size() + ch]);
+        }
+    }
+}
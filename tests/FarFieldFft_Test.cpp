@@ -0,0 +1,123 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "FarFieldFft.hpp"
+#include "FarField.hpp"
+#include "RenderSound.hpp"
+
+#include "arrays/SingleRingTransducerArray.hpp"
+
+#include <gtest/gtest.h>
+
+
+namespace {
+    /** Every other position of a 9x5 lattice, spacing 5 cm, which is gridded but not full */
+    std::vector<Transducer> checkerboard()
+    {
+        std::vector<Transducer> mics;
+        for (int j = 0; j < 5; j++)
+        {
+            for (int i = 0; i < 9; i++)
+            {
+                if ((i + j) % 2 == 0)
+                {
+                    Transducer t;
+                    t.pos = Pos(-0.2 + 0.05 * i, -0.1 + 0.05 * j, 0);
+                    mics.push_back(t);
+                }
+            }
+        }
+        return mics;
+    }
+
+    void expectEachPixelAbsoluteNear(FieldBuffer const & expected, FieldBuffer const & actual, double tolerance)
+    {
+        ASSERT_EQ(expected.width(), actual.width());
+        ASSERT_EQ(expected.height(), actual.height());
+        for (size_t i = 0; i < expected.size(); i++)
+        {
+            ASSERT_NEAR(expected.data()[i], actual.data()[i], tolerance) << "pixel " << i;
+        }
+    }
+}
+
+TEST(FarFieldFft, EvenlySpaced)
+{
+    EXPECT_TRUE(isEvenlySpaced(linspace(-1, 1, 101)));
+    EXPECT_FALSE(isEvenlySpaced({ 0.0, 1.0, 3.0 }));
+    EXPECT_FALSE(isEvenlySpaced({ 1.0 }));
+}
+
+TEST(FarFieldFft, SparseGridMatchesDirections)
+{
+    auto mics = checkerboard();
+    std::vector<double> uvals = linspace(-1, 1, 61);
+    std::vector<double> vvals = linspace(-0.5, 0.8, 37);
+    WorkerPool pool(2);
+
+    FieldBuffer expected;
+    FieldBuffer actual;
+    renderFarFieldDirections(uvals, vvals, 5000, mics, 343, expected, pool);
+    renderFarFieldFft(uvals, vvals, 5000, mics, 343, actual, pool);
+    expectEachPixelAbsoluteNear(expected, actual, 1e-10 * mics.size());
+}
+
+TEST(FarFieldFft, FullGridMatchesDirections)
+{
+    std::vector<Transducer> mics(4);
+    mics[0].pos = Pos(0, 0, 0.5);
+    mics[1].pos = Pos(0.1, 0, 0.5);
+    mics[2].pos = Pos(0, 0.1, 0.5);
+    mics[3].pos = Pos(0.1, 0.1, 0.5);
+
+    ApertureGrid grid;
+    ASSERT_TRUE(detectApertureGrid(mics, grid));
+
+    std::vector<double> uvals = linspace(-1, 1, 40);
+    std::vector<double> vvals = linspace(-1, 1, 30);
+    WorkerPool pool(2);
+    FieldBuffer expected;
+    FieldBuffer actual;
+    renderFarFieldDirections(uvals, vvals, 3000, mics, 343, expected, pool);
+    renderFarFieldFft(uvals, vvals, 3000, grid, 343, actual, pool);
+    expectEachPixelAbsoluteNear(expected, actual, 1e-10 * mics.size());
+}
+
+TEST(FarFieldFft, NonGriddedFallsBack)
+{
+    auto mics = SingleRingTransducerArray(48, 0.25).getTransducers();
+    std::vector<double> uvals = linspace(-1, 1, 21);
+    std::vector<double> vvals = linspace(-1, 1, 21);
+    WorkerPool pool(1);
+
+    FieldBuffer expected;
+    FieldBuffer actual;
+    renderFarFieldDirections(uvals, vvals, 3000, mics, 343, expected, pool);
+    renderFarFieldFft(uvals, vvals, 3000, mics, 343, actual, pool);
+    expectEachPixelAbsoluteNear(expected, actual, 0);
+}
+
+TEST(FarFieldFft, LongLatticeMatchesDirections)
+{
+    // 100 positions along x uses the chirp-z transform
+    std::vector<Transducer> mics;
+    for (int i = 0; i < 100; i++)
+    {
+        if (i % 3 != 1)
+        {
+            Transducer t;
+            t.pos = Pos(0.01 * i, 0.02 * (i % 2), 0);
+            mics.push_back(t);
+        }
+    }
+
+    std::vector<double> uvals = linspace(-1, 1, 150);
+    std::vector<double> vvals = linspace(-1, 1, 20);
+    WorkerPool pool(2);
+    FieldBuffer expected;
+    FieldBuffer actual;
+    renderFarFieldDirections(uvals, vvals, 4000, mics, 343, expected, pool);
+    renderFarFieldFft(uvals, vvals, 4000, mics, 343, actual, pool);
+    expectEachPixelAbsoluteNear(expected, actual, 1e-10 * mics.size());
+}
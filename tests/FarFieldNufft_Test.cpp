@@ -0,0 +1,89 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "FarFieldNufft.hpp"
+#include "FarField.hpp"
+#include "MicArrayFactory.hpp"
+#include "RenderSound.hpp"
+
+#include <gtest/gtest.h>
+
+
+namespace {
+    double maxError(FieldBuffer const & expected, FieldBuffer const & actual)
+    {
+        double error = 0;
+        for (size_t i = 0; i < expected.size(); i++)
+        {
+            error = std::max(error, std::fabs(expected.data()[i] - actual.data()[i]));
+        }
+        return error;
+    }
+}
+
+TEST(FarFieldNufft, MatchesDirectionsWithinTolerance)
+{
+    std::vector<double> uvals = linspace(-1, 1, 81);
+    std::vector<double> vvals = linspace(-1, 1, 63);
+    WorkerPool pool(2);
+
+    for (int type : { RING, SPIRAL1, HOMO, RANDOM })
+    {
+        std::vector<Transducer> mics = createMicArray(type)->getTransducers();
+        FieldBuffer expected;
+        renderFarFieldDirections(uvals, vvals, 3000, mics, 343, expected, pool);
+
+        for (double tolerance : { 1e-3, 1e-6, 1e-10 })
+        {
+            FieldBuffer actual;
+            renderFarFieldNufft(uvals, vvals, 3000, mics, 343, tolerance, actual, pool);
+            ASSERT_EQ(expected.width(), actual.width());
+            ASSERT_EQ(expected.height(), actual.height());
+            EXPECT_LT(maxError(expected, actual), tolerance * mics.size()) << "type " << type << ", tolerance " << tolerance;
+        }
+    }
+}
+
+TEST(FarFieldNufft, PartialDirectionRange)
+{
+    std::vector<Transducer> mics = createMicArray(SPIRAL1)->getTransducers();
+    std::vector<double> uvals = linspace(-0.2, 0.3, 50);
+    std::vector<double> vvals = linspace(0.1, 0.15, 10);
+    WorkerPool pool(1);
+
+    FieldBuffer expected;
+    FieldBuffer actual;
+    renderFarFieldDirections(uvals, vvals, 8000, mics, 343, expected, pool);
+    renderFarFieldNufft(uvals, vvals, 8000, mics, 343, 1e-8, actual, pool);
+    EXPECT_LT(maxError(expected, actual), 1e-8 * mics.size());
+}
+
+TEST(FarFieldNufft, NonPlanarFallsBack)
+{
+    std::vector<Transducer> mics(3);
+    mics[0].pos = Pos(0, 0, 0);
+    mics[1].pos = Pos(0.1, 0, 0);
+    mics[2].pos = Pos(0, 0.1, 0.05);
+    std::vector<double> uvals = linspace(-1, 1, 11);
+    WorkerPool pool(1);
+
+    FieldBuffer expected;
+    FieldBuffer actual;
+    renderFarFieldDirections(uvals, uvals, 3000, mics, 343, expected, pool);
+    renderFarFieldNufft(uvals, uvals, 3000, mics, 343, 1e-3, actual, pool);
+    EXPECT_EQ(0, maxError(expected, actual));
+}
+
+TEST(FarFieldNufft, ZeroFrequency)
+{
+    std::vector<Transducer> mics = createMicArray(SPIRAL1)->getTransducers();
+    std::vector<double> uvals = linspace(-1, 1, 21);
+    WorkerPool pool(1);
+
+    FieldBuffer expected;
+    FieldBuffer actual;
+    renderFarFieldDirections(uvals, uvals, 0, mics, 343, expected, pool);
+    renderFarFieldNufft(uvals, uvals, 0, mics, 343, 1e-6, actual, pool);
+    EXPECT_EQ(0, maxError(expected, actual));
+}
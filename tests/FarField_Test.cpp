@@ -0,0 +1,87 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "FarField.hpp"
+#include "RenderSound.hpp"
+
+#include "arrays/RectangularTransducerArray.hpp"
+#include "arrays/SingleRingTransducerArray.hpp"
+
+#include <gtest/gtest.h>
+
+
+TEST(FarField, SeparableMatchesDirectSum)
+{
+    RectangularTransducerArray mics(7, 0.5/6, 5, 0.1);
+    FarFieldArrayFactor af(mics.getTransducers(), 3000, 343);
+    ASSERT_TRUE(af.isSeparable());
+
+    for (double u : { -0.9, -0.3, 0.0, 0.2, 0.7 })
+    {
+        for (double v : { -0.5, 0.0, 0.45 })
+        {
+            double w = std::sqrt(std::max(0.0, 1 - u*u - v*v));
+            EXPECT_NEAR(std::abs(af.evaluate(u, v, w)), af.magnitude(u, v, w), 1e-9) << u << ", " << v;
+        }
+    }
+    EXPECT_NEAR(35.0, af.magnitude(0, 0, 1), 1e-12);
+}
+
+TEST(FarField, RingIsNotSeparable)
+{
+    SingleRingTransducerArray mics(48, 0.25);
+    FarFieldArrayFactor af(mics.getTransducers(), 3000, 343);
+    EXPECT_FALSE(af.isSeparable());
+    EXPECT_NEAR(48.0, af.magnitude(0, 0, 1), 1e-9);
+}
+
+TEST(FarField, WallApproachesNearFieldFarAway)
+{
+    // At 1 km the 0.5 m aperture is deep in the far field
+    SingleRingTransducerArray mics(48, 0.25);
+    std::vector<double> xvals = linspace(-1000, 1000, 21);
+    std::vector<double> yvals = linspace(-1000, 1000, 21);
+    double z = 1000;
+
+    WorkerPool pool(2);
+    FieldBuffer nearField;
+    FieldBuffer farField;
+    renderSoundOnWall(xvals, yvals, z, 2000, mics.getTransducers(), 343, nearField, pool);
+    renderFarFieldOnWall(xvals, yvals, z, 2000, mics.getTransducers(), 343, farField, pool);
+
+    double peak = nearField.at(10, 10);
+    for (size_t i = 0; i < nearField.size(); i++)
+    {
+        EXPECT_NEAR(nearField.data()[i], farField.data()[i], 1e-3 * peak) << "pixel " << i;
+    }
+}
+
+TEST(FarField, DirectionTablesMatchDirectSum)
+{
+    std::vector<double> uvals = linspace(-1, 1, 33);
+    std::vector<double> vvals = linspace(-1, 1, 17);
+    WorkerPool pool(2);
+
+    std::vector<std::vector<Transducer> > arrays = {
+        SingleRingTransducerArray(48, 0.25).getTransducers(),
+        RectangularTransducerArray(7, 0.5/6, 7, 0.5/6).getTransducers(),
+    };
+
+    for (auto const & transducers : arrays)
+    {
+        FarFieldArrayFactor af(transducers, 4000, 343);
+        FieldBuffer img;
+        renderFarFieldDirections(uvals, vvals, 4000, transducers, 343, img, pool);
+
+        for (size_t b = 0; b < vvals.size(); b++)
+        {
+            for (size_t a = 0; a < uvals.size(); a++)
+            {
+                double w2 = 1 - sqr(uvals[a]) - sqr(vvals[b]);
+                double expected = w2 < 0 ? 0 : std::abs(af.evaluate(uvals[a], vvals[b], std::sqrt(w2))) / sqrt(2.0);
+                EXPECT_NEAR(expected, img.at(a, b), 1e-9);
+            }
+        }
+    }
+}
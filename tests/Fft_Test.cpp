@@ -0,0 +1,91 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "Fft.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdlib>
+
+
+namespace {
+    std::vector<std::complex<double> > randomSignal(size_t n)
+    {
+        std::vector<std::complex<double> > x(n);
+        for (auto & v : x)
+        {
+            v = std::complex<double>(rand() / double(RAND_MAX) - 0.5, rand() / double(RAND_MAX) - 0.5);
+        }
+        return x;
+    }
+
+    std::complex<double> directSum(std::vector<std::complex<double> > const & x, double theta)
+    {
+        std::complex<double> sum = 0;
+        for (size_t n = 0; n < x.size(); n++)
+        {
+            sum += x[n] * std::polar(1.0, -theta * double(n));
+        }
+        return sum;
+    }
+}
+
+TEST(Fft, NextPowerOfTwo)
+{
+    EXPECT_EQ(1u, nextPowerOfTwo(1));
+    EXPECT_EQ(2u, nextPowerOfTwo(2));
+    EXPECT_EQ(4u, nextPowerOfTwo(3));
+    EXPECT_EQ(1024u, nextPowerOfTwo(1000));
+}
+
+TEST(Fft, ForwardMatchesDft)
+{
+    for (size_t n : { 1, 2, 8, 64 })
+    {
+        auto x = randomSignal(n);
+        auto X = x;
+        Fft fft(n);
+        fft.forward(X.data());
+        for (size_t k = 0; k < n; k++)
+        {
+            std::complex<double> expected = directSum(x, 2 * M_PI * double(k) / double(n));
+            EXPECT_NEAR(expected.real(), X[k].real(), 1e-12) << "n=" << n << ", k=" << k;
+            EXPECT_NEAR(expected.imag(), X[k].imag(), 1e-12) << "n=" << n << ", k=" << k;
+        }
+    }
+}
+
+TEST(Fft, InverseRoundTrip)
+{
+    auto x = randomSignal(256);
+    auto y = x;
+    Fft fft(256);
+    fft.forward(y.data());
+    fft.inverse(y.data());
+    for (size_t i = 0; i < x.size(); i++)
+    {
+        EXPECT_NEAR(x[i].real(), y[i].real(), 1e-14);
+        EXPECT_NEAR(x[i].imag(), y[i].imag(), 1e-14);
+    }
+}
+
+TEST(ChirpZ, MatchesDirectSum)
+{
+    auto x = randomSignal(13);
+    const double theta0 = -2.7;
+    const double dTheta = 0.031;
+    ChirpZ cz(x.size(), 200, theta0, dTheta);
+
+    std::vector<std::complex<double> > out(200);
+    std::vector<std::complex<double> > scratch(cz.scratchSize());
+    cz.transform(x.data(), out.data(), scratch.data());
+
+    for (size_t m = 0; m < out.size(); m++)
+    {
+        std::complex<double> expected = directSum(x, theta0 + dTheta * double(m));
+        EXPECT_NEAR(expected.real(), out[m].real(), 1e-11) << m;
+        EXPECT_NEAR(expected.imag(), out[m].imag(), 1e-11) << m;
+    }
+}
@@ -0,0 +1,44 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "FieldBuffer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+
+TEST(FieldBuffer, RowMajorAndAligned)
+{
+    FieldBuffer img(5, 3);
+    ASSERT_EQ(5, img.width());
+    ASSERT_EQ(3, img.height());
+    ASSERT_EQ(15, img.size());
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(img.data()) % 64);
+
+    img.at(4, 2) = 7.0;
+    EXPECT_EQ(7.0, img.data()[2 * 5 + 4]);
+    EXPECT_EQ(img.data() + 10, img.row(2));
+}
+
+TEST(FieldBuffer, ShrinkingKeepsAllocation)
+{
+    FieldBuffer img(64, 64);
+    double* before = img.data();
+
+    img.resize(32, 16);
+    EXPECT_EQ(before, img.data());
+    EXPECT_EQ(32 * 16, img.size());
+
+    img.resize(64, 64);
+    EXPECT_EQ(before, img.data());
+}
+
+TEST(FieldBuffer, LargerThanTheStack)
+{
+    // 4096 x 4096 doubles would never have fit in the old stack VLA
+    FieldBuffer img(4096, 4096);
+    img.at(4095, 4095) = 1.0;
+    EXPECT_EQ(1.0, img.row(4095)[4095]);
+}
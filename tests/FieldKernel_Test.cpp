@@ -0,0 +1,94 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "FieldKernel.hpp"
+#include "RenderSound.hpp"
+
+#include "arrays/RandomTransducerArray.hpp"
+#include "arrays/SingleRingTransducerArray.hpp"
+
+#include <gtest/gtest.h>
+
+
+namespace {
+    void expectIsaMatchesScalar(FieldKernelIsa isa, std::vector<Transducer> const & transducers)
+    {
+        if (!isFieldKernelIsaSupported(isa))
+        {
+            return;
+        }
+
+        TransducerBlock block(transducers);
+        std::vector<Pos> listeners = { Pos(0, 0, 10), Pos(-10, 3.5, 10), Pos(7.25, -9.5, 0.5), Pos(-300, 200, 10) };
+
+        for (double f : { 100.0, 2000.0, 10000.0, 40000.0 })
+        {
+            for (Pos const & listenerPos : listeners)
+            {
+                // Both versions round the phase itself to ~phase*2^-52, which dominates for large phases
+                double sumOfAmplitudes = 0;
+                double maxPhase = 0;
+                for (Transducer const & t : transducers)
+                {
+                    sumOfAmplitudes += 1.0 / sqr(listenerPos.dist(t.pos));
+                    maxPhase = std::max(maxPhase, 2 * M_PI * f / 343 * listenerPos.dist(t.pos));
+                }
+                double tolerance = 1e-15 * (1 + maxPhase) * sumOfAmplitudes;
+
+                std::complex<double> expected = accumulateField(transducers, listenerPos, f, 343);
+                std::complex<double> actual = accumulateField(isa, block, listenerPos, f, 343);
+                EXPECT_NEAR(expected.real(), actual.real(), tolerance) << fieldKernelIsaName(isa) << " f=" << f;
+                EXPECT_NEAR(expected.imag(), actual.imag(), tolerance) << fieldKernelIsaName(isa) << " f=" << f;
+            }
+        }
+    }
+}
+
+TEST(FieldKernel, BlockIsPaddedWithZeroWeights)
+{
+    SingleRingTransducerArray mics(7, 1.0);
+    TransducerBlock block(mics.getTransducers());
+
+    ASSERT_EQ(7, block.size());
+    ASSERT_EQ(8, block.paddedSize());
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(block.x()) % 64);
+    EXPECT_EQ(1.0, block.weight()[6]);
+    EXPECT_EQ(0.0, block.weight()[7]);
+}
+
+TEST(FieldKernel, ScalarIsBitIdenticalToReference)
+{
+    SingleRingTransducerArray mics(48, 0.25);
+    TransducerBlock block(mics.getTransducers());
+    Pos listenerPos(-3.25, 4.5, 10);
+
+    std::complex<double> expected = accumulateField(mics.getTransducers(), listenerPos, 2000, 343);
+    std::complex<double> actual = accumulateField(FieldKernelIsa::SCALAR, block, listenerPos, 2000, 343);
+    EXPECT_EQ(expected.real(), actual.real());
+    EXPECT_EQ(expected.imag(), actual.imag());
+}
+
+TEST(FieldKernel, Avx2MatchesScalar)
+{
+    srand48(42);
+    expectIsaMatchesScalar(FieldKernelIsa::AVX2, RandomTransducerArray(13, 0.5, 0.5).getTransducers());
+    expectIsaMatchesScalar(FieldKernelIsa::AVX2, SingleRingTransducerArray(48, 0.25).getTransducers());
+}
+
+TEST(FieldKernel, Avx512MatchesScalar)
+{
+    srand48(42);
+    expectIsaMatchesScalar(FieldKernelIsa::AVX512, RandomTransducerArray(13, 0.5, 0.5).getTransducers());
+    expectIsaMatchesScalar(FieldKernelIsa::AVX512, SingleRingTransducerArray(48, 0.25).getTransducers());
+}
+
+TEST(FieldKernel, ParseIsaNames)
+{
+    FieldKernelIsa isa;
+    EXPECT_TRUE(parseFieldKernelIsa("scalar", isa));
+    EXPECT_EQ(FieldKernelIsa::SCALAR, isa);
+    EXPECT_TRUE(parseFieldKernelIsa("avx512", isa));
+    EXPECT_EQ(FieldKernelIsa::AVX512, isa);
+    EXPECT_FALSE(parseFieldKernelIsa("neon", isa));
+}
@@ -0,0 +1,100 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "FieldPrecision.hpp"
+#include "FieldKernel.hpp"
+#include "RenderSound.hpp"
+
+#include "arrays/RectangularTransducerArray.hpp"
+#include "arrays/SingleRingTransducerArray.hpp"
+#include "arrays/SpiralTransducerArray.hpp"
+
+#include <gtest/gtest.h>
+
+
+TEST(FieldPrecision, Parse)
+{
+    FieldPrecision precision;
+    ASSERT_TRUE(parseFieldPrecision("mixed", precision));
+    EXPECT_EQ(FieldPrecision::MIXED, precision);
+    EXPECT_STREQ("mixed", fieldPrecisionName(precision));
+    ASSERT_TRUE(parseFieldPrecision("float", precision));
+    EXPECT_EQ(FieldPrecision::FLOAT, precision);
+    EXPECT_FALSE(parseFieldPrecision("half", precision));
+}
+
+TEST(FieldPrecision, CompareFields)
+{
+    FieldBuffer reference(2, 2);
+    FieldBuffer field(2, 2);
+    reference.at(0, 0) = 4;
+    reference.at(1, 1) = 2;
+    field.at(0, 0) = 4;
+    field.at(1, 1) = 1;
+
+    FieldError error = compareFields(reference, field);
+    EXPECT_DOUBLE_EQ(1.0, error.maxAbsolute);
+    EXPECT_DOUBLE_EQ(0.25, error.maxRelative);
+    EXPECT_DOUBLE_EQ(0.5 / 4, error.rmsRelative);
+}
+
+TEST(FieldPrecision, AllVariantsMatchDoubleReference)
+{
+    SpiralTransducerArray mics(0.010, 0.0, 0.3, 3.7, 48);
+    // Not a multiple of the row segment length
+    std::vector<double> xvals = linspace(-10, 10, 301);
+    std::vector<double> yvals = linspace(-10, 10, 23);
+    WorkerPool pool(2);
+
+    FieldBuffer reference;
+    renderSoundOnWall(xvals, yvals, 10, 10000, mics.getTransducers(), 343, reference);
+
+    const FieldKernelIsa selected = getFieldKernelIsa();
+    for (FieldKernelIsa isa : { FieldKernelIsa::SCALAR, FieldKernelIsa::AVX2, FieldKernelIsa::AVX512 })
+    {
+        if (!isFieldKernelIsaSupported(isa))
+        {
+            continue;
+        }
+        setFieldKernelIsa(isa);
+
+        FieldBuffer img;
+        renderSoundOnWallPrecision(xvals, yvals, 10, 10000, mics.getTransducers(), 343, FieldPrecision::DOUBLE, img, pool);
+        EXPECT_LT(compareFields(reference, img).maxRelative, 1e-12) << fieldKernelIsaName(isa);
+
+        renderSoundOnWallPrecision(xvals, yvals, 10, 10000, mics.getTransducers(), 343, FieldPrecision::FLOAT, img, pool);
+        EXPECT_LT(compareFields(reference, img).maxRelative, 2e-4) << fieldKernelIsaName(isa);
+
+        renderSoundOnWallPrecision(xvals, yvals, 10, 10000, mics.getTransducers(), 343, FieldPrecision::MIXED, img, pool);
+        EXPECT_LT(compareFields(reference, img).maxRelative, 2e-4) << fieldKernelIsaName(isa);
+    }
+    setFieldKernelIsa(selected);
+}
+
+TEST(FieldPrecision, FixedSizeKernelsMatchGeneric)
+{
+    EXPECT_TRUE(hasFixedSizeFieldKernel(4));
+    EXPECT_TRUE(hasFixedSizeFieldKernel(7));
+    EXPECT_FALSE(hasFixedSizeFieldKernel(5));
+
+    RectangularTransducerArray respeaker4(2, 0.058, 2, 0.058);
+    SingleRingTransducerArray respeaker6(7, 0.0925/2);
+    std::vector<double> xvals = linspace(-10, 10, 270);
+    std::vector<double> yvals = linspace(-10, 10, 9);
+    WorkerPool pool(2);
+
+    for (ITransducerArray const * array : { static_cast<ITransducerArray const *>(&respeaker4), static_cast<ITransducerArray const *>(&respeaker6) })
+    {
+        for (FieldPrecision precision : { FieldPrecision::DOUBLE, FieldPrecision::FLOAT, FieldPrecision::MIXED })
+        {
+            FieldBuffer generic;
+            FieldBuffer fixed;
+            renderSoundOnWallPrecision(xvals, yvals, 10, 5000, array->getTransducers(), 343, precision, generic, pool, false);
+            renderSoundOnWallPrecision(xvals, yvals, 10, 5000, array->getTransducers(), 343, precision, fixed, pool, true);
+            double tolerance = precision == FieldPrecision::DOUBLE ? 1e-13 : 1e-4;
+            EXPECT_LT(compareFields(generic, fixed).maxRelative, tolerance)
+                << array->getTransducers().size() << " transducers, " << fieldPrecisionName(precision);
+        }
+    }
+}
@@ -0,0 +1,189 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "FieldWriter.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+namespace {
+    std::string readFile(std::string const & filename)
+    {
+        std::ifstream in(filename, std::ios::binary);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        return ss.str();
+    }
+
+    FieldBuffer testField()
+    {
+        FieldBuffer img(3, 2);
+        std::vector<double> values = { 0.0, 1.0, 2.0, 4.0, 0.5, 3.0 };
+        std::copy(values.begin(), values.end(), img.data());
+        return img;
+    }
+
+    std::string floats(std::vector<float> const & values)
+    {
+        return std::string(reinterpret_cast<char const *>(values.data()), values.size() * sizeof(float));
+    }
+}
+
+
+TEST(FieldWriter, PgmIsScaledToMaxValue)
+{
+    std::string filename = testing::TempDir() + "FieldWriter_Test.pgm";
+    std::vector<double> img = { 0.0, 1.0, 2.0, 4.0, 0.5, 3.0 };
+    ASSERT_TRUE(writeFieldAsPgm(filename, img.data(), 3, 2));
+
+    std::ifstream in(filename, std::ios::binary);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    std::string expected = std::string("P5\n3 2\n255\n") + char(0) + char(63) + char(127) + char(255) + char(31) + char(191);
+    EXPECT_EQ(expected, ss.str());
+
+    remove(filename.c_str());
+}
+
+TEST(FieldWriter, ParseFormat)
+{
+    FieldFormat format;
+    ASSERT_TRUE(parseFieldFormat("npy", format));
+    EXPECT_EQ(FieldFormat::NPY, format);
+    ASSERT_TRUE(parseFieldFormat("pgm16db", format));
+    EXPECT_EQ(FieldFormat::PGM16_DB, format);
+    EXPECT_FALSE(parseFieldFormat("png", format));
+
+    EXPECT_STREQ("pfm", fieldFormatExtension(FieldFormat::PFM));
+    EXPECT_STREQ("pgm", fieldFormatExtension(FieldFormat::PGM16_DB));
+}
+
+TEST(FieldWriter, Npy)
+{
+    std::string filename = testing::TempDir() + "FieldWriter_Test.npy";
+    ASSERT_TRUE(writeField(filename, FieldFormat::NPY, testField()));
+
+    std::string contents = readFile(filename);
+    // The header is padded so that the data starts 64 byte aligned
+    ASSERT_EQ(128u + 6 * sizeof(float), contents.size());
+    EXPECT_EQ(std::string("\x93NUMPY\x01\x00", 8), contents.substr(0, 8));
+    EXPECT_EQ(118, contents[8] + 256 * contents[9]);
+    EXPECT_NE(std::string::npos, contents.find("'descr': '<f4'"));
+    EXPECT_NE(std::string::npos, contents.find("'shape': (2, 3)"));
+    EXPECT_EQ('\n', contents[127]);
+    EXPECT_EQ(floats({ 0.0f, 1.0f, 2.0f, 4.0f, 0.5f, 3.0f }), contents.substr(128));
+
+    remove(filename.c_str());
+}
+
+TEST(FieldWriter, PfmStoresBottomRowFirst)
+{
+    std::string filename = testing::TempDir() + "FieldWriter_Test.pfm";
+    ASSERT_TRUE(writeField(filename, FieldFormat::PFM, testField()));
+
+    std::string header = "Pf\n3 2\n-1.0\n";
+    EXPECT_EQ(header + floats({ 4.0f, 0.5f, 3.0f, 0.0f, 1.0f, 2.0f }), readFile(filename));
+
+    remove(filename.c_str());
+}
+
+TEST(FieldWriter, Pgm16dB)
+{
+    std::string filename = testing::TempDir() + "FieldWriter_Test_dB.pgm";
+    FieldBuffer img(4, 1);
+    img.at(0, 0) = 100;   // 0 dB
+    img.at(1, 0) = 10;    // -20 dB
+    img.at(2, 0) = 0.01;  // -80 dB, below the range
+    img.at(3, 0) = 0;
+    ASSERT_TRUE(writeFieldAsPgm16dB(filename, img, 40));
+
+    std::string expected = std::string("P5\n4 1\n65535\n") +
+        char(0xff) + char(0xff) + char(0x80) + char(0x00) + std::string(4, char(0));
+    EXPECT_EQ(expected, readFile(filename));
+
+    remove(filename.c_str());
+}
+
+TEST(FieldWriter, StreamedBandsInAnyOrder)
+{
+    FieldBuffer img(37, 29);
+    for (size_t i = 0; i < img.size(); i++)
+    {
+        img.data()[i] = 0.25 * i;
+    }
+
+    for (FieldFormat format : { FieldFormat::NPY, FieldFormat::PFM })
+    {
+        std::string whole = testing::TempDir() + "FieldWriter_Test_whole";
+        std::string streamed = testing::TempDir() + "FieldWriter_Test_streamed";
+        ASSERT_TRUE(writeField(whole, format, img));
+
+        FieldStreamWriter writer(streamed, format, img.width(), img.height());
+        writer.writeRows(16, 29, img.row(16));
+        writer.writeRows(0, 8, img.row(0));
+        writer.writeRows(8, 16, img.row(8));
+        ASSERT_TRUE(writer.close());
+
+        EXPECT_EQ(readFile(whole), readFile(streamed));
+        remove(whole.c_str());
+        remove(streamed.c_str());
+    }
+}
+
+TEST(FieldWriter, StreamReportsUnwritableFile)
+{
+    FieldStreamWriter writer(testing::TempDir() + "no/such/dir.npy", FieldFormat::NPY, 4, 4);
+    FieldBuffer img(4, 4);
+    writer.writeRows(0, 4, img.data());
+    EXPECT_FALSE(writer.close());
+}
+
+TEST(FieldWriter, MappedFileMatchesWriteField)
+{
+    FieldBuffer img(37, 29);
+    for (size_t i = 0; i < img.size(); i++)
+    {
+        img.data()[i] = 0.25 * i;
+    }
+
+    for (FieldFormat format : { FieldFormat::NPY, FieldFormat::PFM })
+    {
+        std::string whole = testing::TempDir() + "FieldWriter_Test_whole";
+        std::string mapped = testing::TempDir() + "FieldWriter_Test_mapped";
+        ASSERT_TRUE(writeField(whole, format, img));
+
+        MappedFieldFile file(mapped, format, img.width(), img.height());
+        ASSERT_TRUE(file.isOpen());
+        for (int y = img.height() - 1; y >= 0; y--)
+        {
+            for (int x = 0; x < img.width(); x++)
+            {
+                file.row(y)[x] = float(img.at(x, y));
+            }
+            file.flushRows(y, y + 1);
+        }
+        ASSERT_TRUE(file.close());
+
+        EXPECT_EQ(readFile(whole), readFile(mapped));
+        remove(whole.c_str());
+        remove(mapped.c_str());
+    }
+}
+
+TEST(FieldWriter, PfmHeaderKeepsFloatsAligned)
+{
+    std::string filename = testing::TempDir() + "FieldWriter_Test_aligned.pfm";
+    FieldBuffer img(10, 2);
+    ASSERT_TRUE(writeField(filename, FieldFormat::PFM, img));
+
+    std::string contents = readFile(filename);
+    EXPECT_EQ("Pf\n10 2\n-1.0000\n", contents.substr(0, contents.size() - 20 * sizeof(float)));
+
+    remove(filename.c_str());
+}
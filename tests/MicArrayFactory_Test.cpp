@@ -0,0 +1,35 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "MicArrayFactory.hpp"
+
+#include <gtest/gtest.h>
+
+
+TEST(MicArrayFactory, BuiltInTypes)
+{
+    std::vector<std::pair<int, size_t> > expected = {
+        { RING, 48 },
+        { DOUBLE_RING, 48 },
+        { RECTANGULAR, 49 },
+        { HOMO, 52 },
+        { RESPEAKER_4_MIC_FOR_RPI, 4 },
+        { RESPEAKER_6_MIC_FOR_RPI, 7 },
+        { SPIRAL1, 48 },
+        { RANDOM, 48 },
+    };
+
+    for (auto const & e : expected)
+    {
+        std::unique_ptr<ITransducerArray> micArray = createMicArray(e.first);
+        ASSERT_TRUE(micArray != nullptr) << "type " << e.first;
+        EXPECT_EQ(e.second, micArray->getTransducers().size()) << "type " << e.first;
+    }
+}
+
+TEST(MicArrayFactory, UnknownType)
+{
+    EXPECT_TRUE(createMicArray(5) == nullptr);
+    EXPECT_TRUE(createMicArray(-1) == nullptr);
+}
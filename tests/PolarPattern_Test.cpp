@@ -0,0 +1,96 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "PolarPattern.hpp"
+#include "RenderSound.hpp"
+
+#include "arrays/SingleRingTransducerArray.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+
+TEST(PolarPattern, AnglesIncludeBothEnds)
+{
+    EXPECT_EQ(0.0, polarPatternAngle(0, 9));
+    EXPECT_EQ(180.0, polarPatternAngle(4, 9));
+    EXPECT_EQ(360.0, polarPatternAngle(8, 9));
+}
+
+TEST(PolarPattern, MatchesDirectEvaluation)
+{
+    SingleRingTransducerArray mics(48, 0.25);
+    const double z = 10;
+    const double f = 3000;
+    WorkerPool pool(3);
+
+    std::vector<double> dB;
+    computePolarPattern(z, f, mics.getTransducers(), 343, dB, pool, 5000);
+    ASSERT_EQ(5000u, dB.size());
+
+    std::vector<double> rms(dB.size());
+    for (size_t i = 0; i < rms.size(); i++)
+    {
+        double angle = polarPatternAngle(i, rms.size()) * M_PI / 180.0;
+        Pos listenerPos(z * cos(angle), 0, z * sin(angle));
+        rms[i] = phasorToRms(sumPhasors(getPhasors(mics.getTransducers(), listenerPos, f, 343)));
+    }
+    double maxval = *std::max_element(rms.begin(), rms.end());
+
+    double largest = -1e9;
+    for (size_t i = 0; i < dB.size(); i++)
+    {
+        EXPECT_NEAR(10.0 * log10(rms[i] / maxval), dB[i], 1e-9) << i;
+        largest = std::max(largest, dB[i]);
+    }
+    EXPECT_EQ(0.0, largest);
+}
+
+TEST(PolarPattern, ReusesBuffer)
+{
+    SingleRingTransducerArray mics(7, 0.05);
+    WorkerPool pool(2);
+
+    std::vector<double> dB;
+    computePolarPattern(10, 2000, mics.getTransducers(), 343, dB, pool, 3000);
+    double const * data = dB.data();
+    computePolarPattern(10, 4000, mics.getTransducers(), 343, dB, pool, 3000);
+    EXPECT_EQ(data, dB.data());
+}
+
+TEST(PolarPattern, RejectsTooFewAngles)
+{
+    SingleRingTransducerArray mics(7, 0.05);
+    WorkerPool pool(1);
+
+    std::vector<double> dB;
+    EXPECT_FALSE(computePolarPattern(10, 2000, mics.getTransducers(), 343, dB, pool, 0));
+    EXPECT_FALSE(computePolarPattern(10, 2000, mics.getTransducers(), 343, dB, pool, 1));
+    EXPECT_TRUE(dB.empty());
+    EXPECT_TRUE(computePolarPattern(10, 2000, mics.getTransducers(), 343, dB, pool, 2));
+}
+
+TEST(PolarPattern, WriteText)
+{
+    std::vector<double> dB = { 0.0, -3.5, -10.25 };
+    const std::string filename = testing::TempDir() + "PolarPattern_Test.txt";
+    ASSERT_TRUE(writePolarPatternText(filename, dB));
+
+    std::ifstream in(filename);
+    double angle, value;
+    for (size_t i = 0; i < dB.size(); i++)
+    {
+        ASSERT_TRUE(bool(in >> angle >> value));
+        EXPECT_DOUBLE_EQ(polarPatternAngle(i, dB.size()), angle);
+        EXPECT_DOUBLE_EQ(dB[i], value);
+    }
+    EXPECT_FALSE(bool(in >> angle));
+    std::remove(filename.c_str());
+
+    EXPECT_FALSE(writePolarPatternText("/nonexistent/dir/file.txt", dB));
+}
@@ -0,0 +1,84 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "RenderCache.hpp"
+#include "RenderSound.hpp"
+
+#include "arrays/SingleRingTransducerArray.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+
+
+TEST(RenderCache, KeyCoversAllParameters)
+{
+    SingleRingTransducerArray ring(48, 0.25);
+    SingleRingTransducerArray smallRing(48, 0.2);
+    std::vector<double> vals = linspace(-10, 10, 64);
+    const std::vector<Transducer> & mics = ring.getTransducers();
+
+    uint64_t key = renderCacheKey("near", vals, vals, 10, 2000, mics, 343);
+    EXPECT_EQ(key, renderCacheKey("near", vals, vals, 10, 2000, mics, 343));
+    EXPECT_NE(key, renderCacheKey("recurrence", vals, vals, 10, 2000, mics, 343));
+    EXPECT_NE(key, renderCacheKey("near", linspace(-10, 10, 65), vals, 10, 2000, mics, 343));
+    EXPECT_NE(key, renderCacheKey("near", vals, linspace(-9, 10, 64), 10, 2000, mics, 343));
+    EXPECT_NE(key, renderCacheKey("near", vals, vals, 11, 2000, mics, 343));
+    EXPECT_NE(key, renderCacheKey("near", vals, vals, 10, 2001, mics, 343));
+    EXPECT_NE(key, renderCacheKey("near", vals, vals, 10, 2000, smallRing.getTransducers(), 343));
+    EXPECT_NE(key, renderCacheKey("near", vals, vals, 10, 2000, mics, 340));
+}
+
+TEST(RenderCache, StoreAndLoad)
+{
+    SingleRingTransducerArray mics(48, 0.25);
+    std::vector<double> xvals = linspace(-10, 10, 37);
+    std::vector<double> yvals = linspace(-10, 10, 23);
+    RenderCache cache(testing::TempDir());
+    const uint64_t key = renderCacheKey("near", xvals, yvals, 10, 3000, mics.getTransducers(), 343);
+
+    FieldBuffer rendered;
+    renderSoundOnWall(xvals, yvals, 10, 3000, mics.getTransducers(), 343, rendered);
+    ASSERT_TRUE(cache.store(key, rendered));
+
+    FieldBuffer loaded;
+    ASSERT_TRUE(cache.load(key, loaded));
+    ASSERT_EQ(rendered.width(), loaded.width());
+    ASSERT_EQ(rendered.height(), loaded.height());
+    for (size_t i = 0; i < rendered.size(); i++)
+    {
+        ASSERT_EQ(rendered.data()[i], loaded.data()[i]);
+    }
+
+    EXPECT_FALSE(cache.load(key + 1, loaded));
+    remove(cache.filename(key).c_str());
+    EXPECT_FALSE(cache.load(key, loaded));
+}
+
+TEST(RenderCache, RejectsTruncatedFile)
+{
+    RenderCache cache(testing::TempDir());
+    FieldBuffer img(8, 4);
+    for (size_t i = 0; i < img.size(); i++)
+    {
+        img.data()[i] = double(i);
+    }
+    ASSERT_TRUE(cache.store(42, img));
+
+    // Simulate an interrupted copy of the cache directory
+    std::string contents;
+    {
+        std::ifstream in(cache.filename(42), std::ios::binary);
+        contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    {
+        std::ofstream out(cache.filename(42), std::ios::binary);
+        out.write(contents.data(), contents.size() - 8);
+    }
+
+    FieldBuffer loaded;
+    EXPECT_FALSE(cache.load(42, loaded));
+    remove(cache.filename(42).c_str());
+}
@@ -0,0 +1,87 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "RenderSoundAdaptive.hpp"
+#include "RenderSound.hpp"
+
+#include "arrays/RectangularTransducerArray.hpp"
+#include "arrays/SingleRingTransducerArray.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace {
+    double maxError(FieldBuffer const & expected, FieldBuffer const & actual)
+    {
+        double error = 0;
+        for (size_t i = 0; i < expected.size(); i++)
+        {
+            error = std::max(error, std::fabs(expected.data()[i] - actual.data()[i]));
+        }
+        return error;
+    }
+
+    double peak(FieldBuffer const & img)
+    {
+        return *std::max_element(img.data(), img.data() + img.size());
+    }
+}
+
+TEST(RenderSoundAdaptive, SmoothFieldNeedsFewEvaluations)
+{
+    RectangularTransducerArray mics(2, 0.058, 2, 0.058);
+    std::vector<double> vals = linspace(-10, 10, 256);
+    WorkerPool pool(2);
+
+    FieldBuffer expected;
+    FieldBuffer actual;
+    renderSoundOnWall(vals, vals, 10, 500, mics.getTransducers(), 343, expected);
+    size_t evaluations = renderSoundOnWallAdaptive(vals, vals, 10, 500, mics.getTransducers(), 343, 1e-3, actual, pool);
+
+    EXPECT_LT(evaluations, expected.size() / 10);
+    EXPECT_LT(maxError(expected, actual), 5e-3 * peak(expected));
+}
+
+TEST(RenderSoundAdaptive, DetailedFieldStaysAccurate)
+{
+    SingleRingTransducerArray mics(48, 0.25);
+    std::vector<double> vals = linspace(-10, 10, 200);
+    WorkerPool pool(2);
+
+    FieldBuffer expected;
+    FieldBuffer actual;
+    renderSoundOnWall(vals, vals, 10, 3000, mics.getTransducers(), 343, expected);
+    size_t evaluations = renderSoundOnWallAdaptive(vals, vals, 10, 3000, mics.getTransducers(), 343, 1e-3, actual, pool);
+
+    EXPECT_LT(evaluations, expected.size());
+    EXPECT_LT(maxError(expected, actual), 5e-3 * peak(expected));
+}
+
+TEST(RenderSoundAdaptive, TinyToleranceEvaluatesEverything)
+{
+    SingleRingTransducerArray mics(7, 0.0925/2);
+    WorkerPool pool(2);
+
+    // Sizes which do not fit the coarse grid, including single rows and columns
+    for (auto size : { std::make_pair(1, 1), std::make_pair(1, 40), std::make_pair(37, 1), std::make_pair(53, 18) })
+    {
+        std::vector<double> xvals = linspace(-10, 10, size.first);
+        std::vector<double> yvals = linspace(-5, 5, size.second);
+        if (size.first == 1) { xvals = { 0.3 }; }
+        if (size.second == 1) { yvals = { -0.2 }; }
+
+        FieldBuffer expected;
+        FieldBuffer actual;
+        renderSoundOnWall(xvals, yvals, 10, 8000, mics.getTransducers(), 343, expected);
+        size_t evaluations = renderSoundOnWallAdaptive(xvals, yvals, 10, 8000, mics.getTransducers(), 343, 1e-14, actual, pool);
+
+        ASSERT_EQ(expected.width(), actual.width());
+        ASSERT_EQ(expected.height(), actual.height());
+        EXPECT_GE(evaluations, expected.size());
+        EXPECT_LT(maxError(expected, actual), 1e-12 * peak(expected)) << size.first << "x" << size.second;
+    }
+}
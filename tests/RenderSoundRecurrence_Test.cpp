@@ -0,0 +1,63 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "RenderSoundRecurrence.hpp"
+#include "RenderSound.hpp"
+#include "FieldKernel.hpp"
+
+#include "arrays/HomogeneousTransducerArray.hpp"
+#include "arrays/RectangularTransducerArray.hpp"
+#include "arrays/SingleRingTransducerArray.hpp"
+
+#include <gtest/gtest.h>
+
+
+namespace {
+    void expectMatchesExact(std::vector<Transducer> const & transducers, double audioFrequency, int dimension)
+    {
+        std::vector<double> xvals = linspace(-10, 10, dimension);
+        std::vector<double> yvals = linspace(-10, 10, dimension);
+        double z = 10;
+
+        FieldKernelIsa oldIsa = getFieldKernelIsa();
+        setFieldKernelIsa(FieldKernelIsa::SCALAR);
+        FieldBuffer exact;
+        renderSoundOnWall(xvals, yvals, z, audioFrequency, transducers, 343, exact);
+        setFieldKernelIsa(oldIsa);
+
+        WorkerPool pool(2);
+        FieldBuffer fast;
+        renderSoundOnWallRecurrence(xvals, yvals, z, audioFrequency, transducers, 343, fast, pool);
+
+        ASSERT_EQ(exact.size(), fast.size());
+        for (int y = 0; y < exact.height(); y++)
+        {
+            for (int x = 0; x < exact.width(); x++)
+            {
+                // Relative to the coherent sum of all amplitudes (rms)
+                double sumOfAmplitudes = 0;
+                for (Transducer const & t : transducers)
+                {
+                    sumOfAmplitudes += 1.0 / sqr(Pos(xvals[x], yvals[y], z).dist(t.pos));
+                }
+                ASSERT_NEAR(exact.at(x, y), fast.at(x, y), 1e-9 * sumOfAmplitudes / sqrt(2.0))
+                    << "x=" << x << " y=" << y << " f=" << audioFrequency;
+            }
+        }
+    }
+}
+
+TEST(RenderSoundRecurrence, MatchesExactRenderer)
+{
+    expectMatchesExact(SingleRingTransducerArray(48, 0.25).getTransducers(), 2000, 200);
+    expectMatchesExact(RectangularTransducerArray(2, 0.058, 2, 0.058).getTransducers(), 8000, 150);
+    expectMatchesExact(HomogeneousTransducerArray(52, 0.07).getTransducers(), 10000, 512);
+}
+
+TEST(RenderSoundRecurrence, CoarseGridFallsBackToExactSteps)
+{
+    // Very few pixels, so the second phase difference is far above the Taylor limit
+    expectMatchesExact(SingleRingTransducerArray(7, 0.0925/2).getTransducers(), 20000, 9);
+    expectMatchesExact(HomogeneousTransducerArray(52, 0.07).getTransducers(), 40000, 40);
+}
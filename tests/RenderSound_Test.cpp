@@ -4,12 +4,135 @@
 
 #include "RenderSound.hpp"
 
+#include "arrays/SingleRingTransducerArray.hpp"
+
 #include <gtest/gtest.h>
 
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+
 TEST(RenderSound, DestructiveInterferenceGivesZero)
 {
-    std::vector<double> xvals = {-0.5, 0.5};
-    std::vector<double> yvals = {-0.5, 0.5};
+    std::vector<double> xvals = {0};
+    std::vector<double> yvals = {0};
     double z = 1;
-#warning "TODO: ADD TESTS"
+
+    // 4 mics 1 m and 16 mics 2 m from the pixel give equal amplitudes (1/d^2),
+    // half a wavelength apart at 171.5 Hz
+    std::vector<Transducer> mics(20);
+    for (size_t i = 0; i < mics.size(); i++)
+    {
+        mics[i].pos = Pos(0, 0, i < 4 ? 0 : -1);
+    }
+
+    double rms = -1;
+    renderSoundOnWall(xvals, yvals, z, 171.5, mics, 343, &rms);
+    EXPECT_NEAR(0, rms, 1e-12);
+}
+
+TEST(RenderSound, TiledRenderingIsBitIdenticalToSerial)
+{
+    // Odd dimensions, so that the last row and column of tiles are partial
+    std::vector<double> xvals;
+    std::vector<double> yvals;
+    for (int i = 0; i < 131; i++) { xvals.push_back(-10 + i * 0.15); }
+    for (int i = 0; i < 70; i++) { yvals.push_back(-7 + i * 0.2); }
+    double z = 10;
+
+    SingleRingTransducerArray mics(7, 0.0925/2);
+
+    std::vector<double> serial(xvals.size() * yvals.size());
+    std::vector<double> tiled(xvals.size() * yvals.size(), -1);
+    renderSoundOnWall(xvals, yvals, z, 3000, mics.getTransducers(), 343, serial.data());
+
+    WorkerPool pool(3);
+    renderSoundOnWall(xvals, yvals, z, 3000, mics.getTransducers(), 343, tiled.data(), pool);
+
+    for (size_t i = 0; i < serial.size(); i++)
+    {
+        ASSERT_EQ(serial[i], tiled[i]) << "pixel " << i;
+    }
+}
+
+TEST(RenderSound, RowsDoneReportsEveryBandOnceWhenRendered)
+{
+    std::vector<double> xvals = linspace(-10, 10, 150);
+    std::vector<double> yvals = linspace(-10, 10, 141);
+    SingleRingTransducerArray mics(7, 0.0925/2);
+
+    FieldBuffer expected;
+    renderSoundOnWall(xvals, yvals, 10, 3000, mics.getTransducers(), 343, expected);
+
+    WorkerPool pool(3);
+    FieldBuffer img;
+    std::mutex mutex;
+    std::vector<int> timesReported(yvals.size(), 0);
+    renderSoundOnWall(xvals, yvals, 10, 3000, mics.getTransducers(), 343, img, pool, [&](int y0, int y1)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int y = y0; y < y1; y++)
+        {
+            timesReported[y]++;
+            for (size_t x = 0; x < xvals.size(); x++)
+            {
+                ASSERT_EQ(expected.at(x, y), img.at(x, y));
+            }
+        }
+    });
+
+    EXPECT_EQ(std::vector<int>(yvals.size(), 1), timesReported);
+}
+
+TEST(RenderSound, OutOfCoreMatchesInMemory)
+{
+    std::vector<double> xvals = linspace(-10, 10, 150);
+    std::vector<double> yvals = linspace(-10, 10, 141);
+    SingleRingTransducerArray mics(7, 0.0925/2);
+
+    FieldBuffer img;
+    renderSoundOnWall(xvals, yvals, 10, 3000, mics.getTransducers(), 343, img);
+
+    WorkerPool pool(3);
+    for (FieldFormat format : { FieldFormat::NPY, FieldFormat::PFM })
+    {
+        std::string inMemory = testing::TempDir() + "RenderSound_Test_memory";
+        std::string outOfCore = testing::TempDir() + "RenderSound_Test_file";
+        ASSERT_TRUE(writeField(inMemory, format, img));
+        ASSERT_TRUE(renderSoundOnWallToFile(xvals, yvals, 10, 3000, mics.getTransducers(), 343, outOfCore, format, pool));
+
+        std::ifstream a(inMemory, std::ios::binary);
+        std::ifstream b(outOfCore, std::ios::binary);
+        std::stringstream sa, sb;
+        sa << a.rdbuf();
+        sb << b.rdbuf();
+        EXPECT_EQ(sa.str(), sb.str());
+
+        remove(inMemory.c_str());
+        remove(outOfCore.c_str());
+    }
+
+    EXPECT_FALSE(renderSoundOnWallToFile(xvals, yvals, 10, 3000, mics.getTransducers(), 343,
+        testing::TempDir() + "RenderSound_Test.pgm", FieldFormat::PGM, pool));
+}
+
+TEST(RenderSound, AccumulateFieldMatchesSummedPhasors)
+{
+    SingleRingTransducerArray mics(48, 0.25);
+    std::vector<Pos> listeners = { Pos(0, 0, 10), Pos(-10, 3.5, 10), Pos(7.25, -9.5, 2) };
+
+    for (Pos const & listenerPos : listeners)
+    {
+        std::complex<double> expected = sumPhasors(getPhasors(mics.getTransducers(), listenerPos, 2000, 343));
+        std::complex<double> actual = accumulateField(mics.getTransducers(), listenerPos, 2000, 343);
+        EXPECT_EQ(expected.real(), actual.real());
+        EXPECT_EQ(expected.imag(), actual.imag());
+    }
+}
+
+TEST(RenderSound, PhasorToRms)
+{
+    EXPECT_NEAR(1.0 / sqrt(2.0), phasorToRms(std::complex<double>(0.6, -0.8)), 1e-12);
+    EXPECT_NEAR(0.0, phasorToRms(std::complex<double>(0, 0)), 1e-12);
 }
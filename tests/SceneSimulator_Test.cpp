@@ -0,0 +1,96 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "SceneSimulator.hpp"
+
+#include <gtest/gtest.h>
+
+
+namespace {
+    std::vector<FakePointSoundSource> testSources()
+    {
+        return {
+            FakePointSoundSource(Pos(1, 0, 5), 2.0, 1000.0, 0.0, 343.0),
+            FakePointSoundSource(Pos(-2, 1, 4), 1.0, 2500.0, 1.0, 343.0),
+            FakePointSoundSource(Pos(0, -3, 6), 0.5, 440.0, -0.5, 343.0),
+        };
+    }
+
+    std::vector<Transducer> testMics(size_t count)
+    {
+        std::vector<Transducer> mics(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            mics[i].pos = Pos(0.01 * i, -0.02 * (i % 7), 0);
+        }
+        return mics;
+    }
+}
+
+TEST(SceneSimulator, SumOfSourcesAtEveryMic)
+{
+    // More mics than one job holds, and more samples than one time block
+    std::vector<FakePointSoundSource> sources = testSources();
+    std::vector<Transducer> mics = testMics(sceneMicsPerJob + 3);
+    const int samplerate = 48000;
+    const size_t numSamples = sceneBlockSamples + 100;
+    const int64_t firstSample = 12345;
+
+    WorkerPool pool(3);
+    SceneSimulator scene(sources, mics, samplerate);
+    ASSERT_EQ(mics.size(), scene.numChannels());
+    std::vector<double> planar = scene.render(firstSample, numSamples, SampleLayout::PLANAR, pool);
+    std::vector<double> interleaved = scene.render(firstSample, numSamples, SampleLayout::INTERLEAVED, pool);
+    ASSERT_EQ(mics.size() * numSamples, planar.size());
+
+    std::vector<double> expected(numSamples);
+    std::vector<double> single(numSamples);
+    for (size_t ch = 0; ch < mics.size(); ch++)
+    {
+        std::fill(expected.begin(), expected.end(), 0.0);
+        for (auto const & source : sources)
+        {
+            source.getSamples(mics[ch].pos, samplerate, firstSample, single.data(), numSamples);
+            for (size_t n = 0; n < numSamples; n++)
+            {
+                expected[n] += single[n];
+            }
+        }
+
+        for (size_t n = 0; n < numSamples; n++)
+        {
+            ASSERT_NEAR(expected[n], planar[ch * numSamples + n], 1e-12) << "channel " << ch << " sample " << n;
+            ASSERT_NEAR(expected[n], interleaved[n * mics.size() + ch], 1e-12) << "channel " << ch << " sample " << n;
+        }
+    }
+}
+
+TEST(SceneSimulator, BlocksAreContinuous)
+{
+    SceneSimulator scene(testSources(), testMics(5), 16000);
+    WorkerPool pool(1);
+
+    std::vector<double> whole = scene.render(0, 3000, SampleLayout::INTERLEAVED, pool);
+    std::vector<double> first = scene.render(0, 1000, SampleLayout::INTERLEAVED, pool);
+    std::vector<double> second = scene.render(1000, 2000, SampleLayout::INTERLEAVED, pool);
+
+    first.insert(first.end(), second.begin(), second.end());
+    ASSERT_EQ(whole.size(), first.size());
+    for (size_t i = 0; i < whole.size(); i++)
+    {
+        EXPECT_NEAR(whole[i], first[i], 1e-12);
+    }
+}
+
+TEST(SceneSimulator, NoSourcesIsSilence)
+{
+    SceneSimulator scene(std::vector<FakePointSoundSource>(), testMics(4), 8000);
+    WorkerPool pool(2);
+    std::vector<double> samples(4 * 100, 1.0);
+    scene.render(0, samples.data(), 100, SampleLayout::PLANAR, pool);
+    for (double s : samples)
+    {
+        EXPECT_EQ(0.0, s);
+    }
+}
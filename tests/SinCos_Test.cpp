@@ -0,0 +1,71 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "SinCos.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+
+TEST(SinCos, MatchesLibm)
+{
+    for (double x = -2000; x < 2000; x += 0.01234567)
+    {
+        double s, c;
+        sinCos(x, s, c);
+        ASSERT_NEAR(sin(x), s, 4e-16) << x;
+        ASSERT_NEAR(cos(x), c, 4e-16) << x;
+    }
+}
+
+TEST(SinCos, QuadrantBoundaries)
+{
+    for (int q = -8; q <= 8; q++)
+    {
+        for (double offset : { -1e-12, 0.0, 1e-12 })
+        {
+            double x = q * M_PI / 4 + offset;
+            double s, c;
+            sinCos(x, s, c);
+            EXPECT_NEAR(sin(x), s, 4e-16) << x;
+            EXPECT_NEAR(cos(x), c, 4e-16) << x;
+        }
+    }
+
+    double s, c;
+    sinCos(0.0, s, c);
+    EXPECT_EQ(0.0, s);
+    EXPECT_EQ(1.0, c);
+}
+
+TEST(SinCos, LargeArguments)
+{
+    for (double x : { 1e4, -3.3e4, 99999.0 })
+    {
+        double s, c;
+        sinCos(x, s, c);
+        EXPECT_NEAR(sin(x), s, 1e-15) << x;
+        EXPECT_NEAR(cos(x), c, 1e-15) << x;
+    }
+}
+
+TEST(SinCos, SinglePrecision)
+{
+    for (float x = -1000; x < 1000; x += 0.01234567f)
+    {
+        float s, c;
+        sinCos(x, s, c);
+        ASSERT_NEAR(sin(double(x)), s, 3e-7) << x;
+        ASSERT_NEAR(cos(double(x)), c, 3e-7) << x;
+    }
+
+    for (float x : { 1e4f, -3.3e4f, 99999.0f })
+    {
+        float s, c;
+        sinCos(x, s, c);
+        EXPECT_NEAR(sin(double(x)), s, 2e-6) << x;
+        EXPECT_NEAR(cos(double(x)), c, 2e-6) << x;
+    }
+}
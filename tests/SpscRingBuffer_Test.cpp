@@ -0,0 +1,92 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "SpscRingBuffer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+
+TEST(SpscRingBuffer, FifoUntilFull)
+{
+    SpscRingBuffer<int> queue(3);
+    ASSERT_EQ(4u, queue.capacity());
+
+    for (int i = 0; i < 4; i++)
+    {
+        int item = i;
+        EXPECT_TRUE(queue.tryPush(item));
+    }
+    int item = 4;
+    EXPECT_FALSE(queue.tryPush(item));
+    EXPECT_EQ(4, item);
+    EXPECT_EQ(4u, queue.size());
+
+    for (int i = 0; i < 4; i++)
+    {
+        ASSERT_TRUE(queue.tryPop(item));
+        EXPECT_EQ(i, item);
+    }
+    EXPECT_FALSE(queue.tryPop(item));
+    EXPECT_EQ(0u, queue.size());
+}
+
+TEST(SpscRingBuffer, RecyclesItems)
+{
+    SpscRingBuffer<std::vector<int> > queue(1);
+    std::vector<int> item(100, 7);
+    const int* buffer = item.data();
+    ASSERT_TRUE(queue.tryPush(item));
+
+    std::vector<int> received;
+    ASSERT_TRUE(queue.tryPop(received));
+    EXPECT_EQ(buffer, received.data());
+
+    // The slot now holds the consumer's old (empty) vector, which the next push returns
+    std::vector<int> next(5, 1);
+    ASSERT_TRUE(queue.tryPush(next));
+    EXPECT_TRUE(next.empty());
+}
+
+TEST(SpscRingBuffer, TwoThreads)
+{
+    SpscRingBuffer<size_t> queue(16);
+    const size_t count = 200000;
+
+    std::thread producer([&]
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            size_t item = i;
+            while (!queue.tryPush(item))
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    // Keep draining after a mismatch, so the producer never blocks and can be joined
+    size_t popped = 0;
+    size_t mismatches = 0;
+    while (popped < count)
+    {
+        size_t item = 0;
+        if (queue.tryPop(item))
+        {
+            if (item != popped)
+            {
+                mismatches++;
+            }
+            popped++;
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+
+    EXPECT_EQ(0u, mismatches);
+}
@@ -0,0 +1,153 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "StreamingCamera.hpp"
+#include "RenderSound.hpp"
+#include "SceneSimulator.hpp"
+
+#include "arrays/RectangularTransducerArray.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+
+
+namespace {
+    const int samplerate = 16000;
+    const double z = 3;
+
+    /** numSamples of a single source scene on mics, as a WAV file. */
+    std::string writeScene(std::string const & name, Pos const & sourcePos, std::vector<Transducer> const & mics, size_t numSamples)
+    {
+        WorkerPool pool(1);
+        SceneSimulator scene({ FakePointSoundSource(sourcePos, 10.0, 2000, 0.0, 343) }, mics, samplerate);
+        std::vector<double> samples = scene.render(0, numSamples, SampleLayout::PLANAR, pool);
+
+        Recording recording(samplerate, mics.size(), numSamples);
+        for (size_t ch = 0; ch < mics.size(); ch++)
+        {
+            std::copy(samples.begin() + ch * numSamples, samples.begin() + (ch + 1) * numSamples, recording.channel(ch));
+        }
+
+        std::string filename = testing::TempDir() + name;
+        writeWav(filename, recording);
+        return filename;
+    }
+}
+
+TEST(StreamingCamera, ImagesMatchTheWholeRecording)
+{
+    RectangularTransducerArray array(4, 0.1, 4, 0.1);
+    std::vector<double> vals = linspace(-2, 2, 9);
+    const Pos sourcePos(vals[6], vals[2], z);
+
+    StreamingSettings settings;
+    settings.spectral.frameSize = 256;
+    settings.framesPerImage = 4;
+    settings.beamformThreads = 2;
+
+    // 3 images of 4 frames (128 samples apart), plus a partial one which is never imaged
+    const size_t numSamples = (3 * 4 + 1) * 128 + 100;
+    std::string filename = writeScene("stream.wav", sourcePos, array.getTransducers(), numSamples);
+    Recording whole;
+    ASSERT_TRUE(readWav(filename, whole));
+
+    WavStream source;
+    ASSERT_TRUE(source.open(filename));
+    std::vector<FieldBuffer> received;
+    StreamingStats stats;
+    ASSERT_TRUE(runStreamingCamera(source, vals, vals, z, array.getTransducers(), 343, settings,
+        [&](FieldBuffer const & img, size_t index)
+        {
+            EXPECT_EQ(received.size(), index);
+            received.push_back(img);
+        }, stats));
+
+    ASSERT_EQ(3u, received.size());
+    EXPECT_EQ(13u, stats.blocksCaptured);
+    EXPECT_EQ(0u, stats.blocksDropped);
+    EXPECT_EQ(3u, stats.imagesProduced);
+    EXPECT_EQ(0u, stats.imagesDropped);
+    EXPECT_EQ(3u, stats.latencies.size());
+    EXPECT_DOUBLE_EQ(13 * 128.0 / samplerate, stats.audioSeconds);
+    EXPECT_LE(stats.latencyPercentile(0.5), stats.latencyPercentile(1));
+
+    // Image i is the cross-spectral image of samples [4 * 128 * i, 4 * 128 * (i + 1) + 128)
+    WorkerPool pool(1);
+    for (size_t i = 0; i < received.size(); i++)
+    {
+        Recording window(samplerate, whole.numChannels(), 5 * 128);
+        for (size_t ch = 0; ch < whole.numChannels(); ch++)
+        {
+            std::copy(whole.channel(ch) + i * 512, whole.channel(ch) + i * 512 + 640, window.channel(ch));
+        }
+        CrossSpectralMatrix csm;
+        ASSERT_TRUE(csm.compute(window, settings.spectral, pool));
+        FieldBuffer expected;
+        ASSERT_TRUE(beamformCrossSpectral(vals, vals, z, csm, array.getTransducers(), 343, false, expected, pool));
+
+        ASSERT_EQ(expected.size(), received[i].size());
+        for (size_t p = 0; p < expected.size(); p++)
+        {
+            EXPECT_NEAR(expected.data()[p], received[i].data()[p], 1e-12);
+        }
+        EXPECT_EQ(2 * 9 + 6, std::max_element(received[i].data(), received[i].data() + received[i].size()) - received[i].data());
+    }
+    std::remove(filename.c_str());
+}
+
+TEST(StreamingCamera, RealtimeDropsWhatDoesNotFit)
+{
+    RectangularTransducerArray array(2, 0.1, 2, 0.1);
+    std::vector<double> vals = linspace(-1, 1, 5);
+
+    StreamingSettings settings;
+    settings.spectral.frameSize = 64;
+    settings.framesPerImage = 2;
+    settings.realtime = true;
+    settings.imageQueue = 1;
+
+    // 0.1 s of audio, and an output stage far slower than real time
+    std::string filename = writeScene("realtime.wav", Pos(0, 0, z), array.getTransducers(), samplerate / 10);
+    WavStream source;
+    ASSERT_TRUE(source.open(filename));
+    StreamingStats stats;
+    ASSERT_TRUE(runStreamingCamera(source, vals, vals, z, array.getTransducers(), 343, settings,
+        [&](FieldBuffer const &, size_t)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        }, stats));
+
+    EXPECT_EQ(size_t(samplerate / 10 / 32), stats.blocksCaptured);
+    EXPECT_GT(stats.imagesDropped, 0u);
+    EXPECT_EQ(stats.imagesProduced - stats.imagesDropped, stats.latencies.size());
+    EXPECT_GE(stats.wallSeconds, 0.1);
+    std::remove(filename.c_str());
+}
+
+TEST(StreamingCamera, RejectsMismatchedSettings)
+{
+    RectangularTransducerArray array(2, 0.1, 2, 0.1);
+    std::vector<double> vals = linspace(-1, 1, 5);
+    std::string filename = writeScene("mismatch.wav", Pos(0, 0, z), array.getTransducers(), 1000);
+
+    StreamingSettings settings;
+    StreamingStats stats;
+    auto ignore = [](FieldBuffer const &, size_t) {};
+
+    WavStream source;
+    ASSERT_TRUE(source.open(filename));
+    RectangularTransducerArray other(3, 0.1, 1, 0.1);
+    EXPECT_FALSE(runStreamingCamera(source, vals, vals, z, other.getTransducers(), 343, settings, ignore, stats));
+    settings.spectral.frameSize = 100;
+    EXPECT_FALSE(runStreamingCamera(source, vals, vals, z, array.getTransducers(), 343, settings, ignore, stats));
+
+    // A band above Nyquist has no bins, just as for CrossSpectralMatrix::compute()
+    settings.spectral.frameSize = 256;
+    settings.spectral.minFrequency = 30000;
+    settings.spectral.maxFrequency = 40000;
+    EXPECT_FALSE(runStreamingCamera(source, vals, vals, z, array.getTransducers(), 343, settings, ignore, stats));
+    std::remove(filename.c_str());
+}
@@ -0,0 +1,49 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "StringParse.hpp"
+
+#include <gtest/gtest.h>
+
+
+TEST(StringParse, SplitString)
+{
+    EXPECT_EQ(std::vector<std::string>({"a", "", "b"}), splitString("a::b", ':'));
+    EXPECT_EQ(std::vector<std::string>({"a", "b"}), splitString("a:b:", ':'));
+}
+
+TEST(StringParse, ParseInt)
+{
+    int value = 0;
+    ASSERT_TRUE(parseInt("-42", value));
+    EXPECT_EQ(-42, value);
+
+    EXPECT_FALSE(parseInt("", value));
+    EXPECT_FALSE(parseInt("12x", value));
+    EXPECT_FALSE(parseInt("4294967297", value));
+}
+
+TEST(StringParse, ParseIntList)
+{
+    std::vector<int> values;
+    ASSERT_TRUE(parseIntList("0,1,2,3,4,6", values));
+    EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4, 6}), values);
+
+    EXPECT_FALSE(parseIntList("", values));
+    EXPECT_FALSE(parseIntList("1,,2", values));
+    EXPECT_FALSE(parseIntList("1,x", values));
+}
+
+TEST(StringParse, FormatNumberedFilename)
+{
+    std::string filename;
+    ASSERT_TRUE(formatNumberedFilename("img%d.pgm", 7, filename));
+    EXPECT_EQ("img7.pgm", filename);
+    ASSERT_TRUE(formatNumberedFilename("img.pgm", 7, filename));
+    EXPECT_EQ("img.pgm", filename);
+
+    EXPECT_FALSE(formatNumberedFilename("x%s%s%s.pgm", 7, filename));
+    EXPECT_FALSE(formatNumberedFilename("img%d_%d.pgm", 7, filename));
+    EXPECT_FALSE(formatNumberedFilename("100%.pgm", 7, filename));
+}
@@ -0,0 +1,48 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "Sweep.hpp"
+
+#include <gtest/gtest.h>
+
+
+TEST(Sweep, ParseSweepRange)
+{
+    std::vector<int> values;
+    ASSERT_TRUE(parseSweepRange("100:300:50", values));
+    EXPECT_EQ(std::vector<int>({100, 150, 200, 250, 300}), values);
+
+    // Like seq, the last value is only included when reached exactly
+    ASSERT_TRUE(parseSweepRange("100:10000:50", values));
+    EXPECT_EQ(199, values.size());
+    EXPECT_EQ(10000, values.back());
+
+    ASSERT_TRUE(parseSweepRange("100:120:50", values));
+    EXPECT_EQ(std::vector<int>({100}), values);
+}
+
+TEST(Sweep, ParseSweepRangeRejectsGarbage)
+{
+    std::vector<int> values;
+    EXPECT_FALSE(parseSweepRange("", values));
+    EXPECT_FALSE(parseSweepRange("100:200", values));
+    EXPECT_FALSE(parseSweepRange("100:200:0", values));
+    EXPECT_FALSE(parseSweepRange("200:100:10", values));
+    EXPECT_FALSE(parseSweepRange("100:2k:10", values));
+}
+
+TEST(Sweep, OutputFilenamesMatchRunmeScript)
+{
+    SweepSettings settings;
+    settings.outputDir = "output";
+
+    settings.polar = false;
+    EXPECT_EQ("output/out_wall_f000150_t3.pgm", sweepOutputFilename(settings, 150, 3));
+
+    settings.polar = true;
+    EXPECT_EQ("output/out_polar_f010000_t6.png", sweepOutputFilename(settings, 10000, 6));
+
+    settings.polarText = true;
+    EXPECT_EQ("output/out_polar_f010000_t6.txt", sweepOutputFilename(settings, 10000, 6));
+}
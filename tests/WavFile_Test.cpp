@@ -0,0 +1,147 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "WavFile.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+
+
+TEST(WavFile, FloatRoundTrip)
+{
+    Recording recording(44100, 3, 100);
+    for (size_t ch = 0; ch < 3; ch++)
+    {
+        for (size_t n = 0; n < 100; n++)
+        {
+            recording.channel(ch)[n] = 0.01f * n - 0.3f * ch;
+        }
+    }
+
+    const std::string filename = testing::TempDir() + "roundtrip.wav";
+    ASSERT_TRUE(writeWav(filename, recording));
+
+    Recording loaded;
+    ASSERT_TRUE(readWav(filename, loaded));
+    EXPECT_EQ(44100, loaded.samplerate());
+    ASSERT_EQ(3u, loaded.numChannels());
+    ASSERT_EQ(100u, loaded.numSamples());
+    for (size_t ch = 0; ch < 3; ch++)
+    {
+        for (size_t n = 0; n < 100; n++)
+        {
+            EXPECT_EQ(recording.channel(ch)[n], loaded.channel(ch)[n]);
+        }
+    }
+    std::remove(filename.c_str());
+}
+
+TEST(WavFile, Pcm16WithExtraChunk)
+{
+    // Two channels, two frames, with a LIST chunk (odd size, padded) before the data
+    const unsigned char bytes[] = {
+        'R', 'I', 'F', 'F', 48, 0, 0, 0, 'W', 'A', 'V', 'E',
+        'f', 'm', 't', ' ', 16, 0, 0, 0,
+        1, 0, 2, 0, 0x80, 0x3e, 0, 0, 0, 0xfa, 0, 0, 4, 0, 16, 0,
+        'L', 'I', 'S', 'T', 1, 0, 0, 0, 'x', 0,
+        'd', 'a', 't', 'a', 8, 0, 0, 0,
+        0x00, 0x40, 0x00, 0x80, 0xff, 0x7f, 0x00, 0x00,
+    };
+    const std::string filename = testing::TempDir() + "pcm16.wav";
+    std::ofstream(filename, std::ios::binary).write(reinterpret_cast<char const *>(bytes), sizeof(bytes));
+
+    Recording loaded;
+    ASSERT_TRUE(readWav(filename, loaded));
+    EXPECT_EQ(16000, loaded.samplerate());
+    ASSERT_EQ(2u, loaded.numChannels());
+    ASSERT_EQ(2u, loaded.numSamples());
+    EXPECT_FLOAT_EQ(0.5f, loaded.channel(0)[0]);
+    EXPECT_FLOAT_EQ(-1.0f, loaded.channel(1)[0]);
+    EXPECT_FLOAT_EQ(32767.0f / 32768, loaded.channel(0)[1]);
+    EXPECT_FLOAT_EQ(0.0f, loaded.channel(1)[1]);
+    std::remove(filename.c_str());
+}
+
+TEST(WavFile, RejectsOtherFiles)
+{
+    const std::string filename = testing::TempDir() + "not_a.wav";
+    std::ofstream(filename) << "P5\n2 2\n255\n";
+
+    Recording loaded;
+    EXPECT_FALSE(readWav(filename, loaded));
+    EXPECT_FALSE(readWav(testing::TempDir() + "does_not_exist.wav", loaded));
+    std::remove(filename.c_str());
+}
+
+TEST(WavFile, StreamOfUnknownLength)
+{
+    Recording recording(8000, 2, 1000);
+    for (size_t n = 0; n < 1000; n++)
+    {
+        recording.channel(0)[n] = 0.001f * n;
+        recording.channel(1)[n] = -0.001f * n;
+    }
+    const std::string filename = testing::TempDir() + "streamed.wav";
+    ASSERT_TRUE(writeWav(filename, recording));
+
+    // As written by a recorder which does not know the length: data size 0xffffffff
+    {
+        std::fstream file(filename, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(40);
+        file.write("\xff\xff\xff\xff", 4);
+    }
+
+    WavStream stream;
+    ASSERT_TRUE(stream.open(filename));
+    EXPECT_EQ(0u, stream.dataFrames());
+    Recording block(8000, 2, 300);
+    size_t total = 0;
+    for (;;)
+    {
+        size_t got = stream.read(block, 0, 300);
+        for (size_t n = 0; n < got; n++)
+        {
+            ASSERT_EQ(recording.channel(0)[total + n], block.channel(0)[n]);
+            ASSERT_EQ(recording.channel(1)[total + n], block.channel(1)[n]);
+        }
+        total += got;
+        if (got < 300)
+        {
+            break;
+        }
+    }
+    EXPECT_EQ(1000u, total);
+
+    Recording loaded;
+    ASSERT_TRUE(readWav(filename, loaded));
+    EXPECT_EQ(1000u, loaded.numSamples());
+    std::remove(filename.c_str());
+}
+
+TEST(WavFile, TruncatedFileClaimingHugeLength)
+{
+    Recording recording(8000, 2, 1000);
+    for (size_t n = 0; n < 1000; n++)
+    {
+        recording.channel(0)[n] = 0.001f * n;
+    }
+    const std::string filename = testing::TempDir() + "truncated.wav";
+    ASSERT_TRUE(writeWav(filename, recording));
+
+    // Data size of ~4 GB, far beyond the end of the file
+    {
+        std::fstream file(filename, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(40);
+        file.write("\xf0\xff\xff\xff", 4);
+    }
+
+    // Only what is actually in the file is allocated and returned
+    Recording loaded;
+    ASSERT_TRUE(readWav(filename, loaded));
+    ASSERT_EQ(1000u, loaded.numSamples());
+    EXPECT_EQ(recording.channel(0)[999], loaded.channel(0)[999]);
+    std::remove(filename.c_str());
+}
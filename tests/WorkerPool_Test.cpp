@@ -0,0 +1,79 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "WorkerPool.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+
+
+TEST(WorkerPool, RunsEveryJobExactlyOnce)
+{
+    WorkerPool pool(4);
+    std::vector<std::atomic<int> > counts(1001);
+    for (auto & c : counts)
+    {
+        c = 0;
+    }
+
+    pool.parallelFor(counts.size(), [&](size_t i) { counts[i]++; });
+
+    for (auto const & c : counts)
+    {
+        EXPECT_EQ(1, c);
+    }
+}
+
+TEST(WorkerPool, WorkerIndexIsNeverShared)
+{
+    WorkerPool pool(4);
+    std::vector<std::atomic<int> > busy(pool.getNumThreads());
+    for (auto & b : busy)
+    {
+        b = 0;
+    }
+    std::atomic<int> jobs(0);
+    std::atomic<int> collisions(0);
+
+    pool.parallelForWorker(1000, [&](size_t, int worker) {
+        ASSERT_GE(worker, 0);
+        ASSERT_LT(worker, pool.getNumThreads());
+        if (busy[worker]++ != 0)
+        {
+            collisions++;
+        }
+        jobs++;
+        busy[worker]--;
+    });
+
+    EXPECT_EQ(1000, jobs);
+    EXPECT_EQ(0, collisions);
+}
+
+TEST(WorkerPool, NestedCallRunsSerially)
+{
+    WorkerPool pool(3);
+    std::atomic<int> total(0);
+
+    pool.parallelFor(10, [&](size_t) {
+        pool.parallelFor(10, [&](size_t) { total++; });
+    });
+
+    EXPECT_EQ(100, total);
+}
+
+TEST(WorkerPool, RethrowsJobException)
+{
+    WorkerPool pool(2);
+    EXPECT_THROW(
+        pool.parallelFor(50, [](size_t i) { if (i == 17) { throw std::runtime_error("job failed"); } }),
+        std::runtime_error);
+
+    // The pool must still be usable afterwards
+    std::atomic<int> total(0);
+    pool.parallelFor(50, [&](size_t) { total++; });
+    EXPECT_EQ(50, total);
+}
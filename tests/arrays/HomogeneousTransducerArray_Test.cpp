@@ -0,0 +1,35 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "arrays/HomogeneousTransducerArray.hpp"
+
+#include <gtest/gtest.h>
+
+
+TEST(HomogeneousTransducerArray, ClosestToCenterAreKept)
+{
+    HomogeneousTransducerArray dut(4, 1.0);
+
+    // 8x8 grid with spacing 1, centered on origin: the four closest are at (+-0.5, +-0.5)
+    std::vector<Transducer> d = dut.getTransducers();
+    ASSERT_EQ(4, d.size());
+    for (Transducer const & t : d)
+    {
+        EXPECT_NEAR(0.5, std::abs(t.pos.x), 1e-10);
+        EXPECT_NEAR(0.5, std::abs(t.pos.y), 1e-10);
+        EXPECT_NEAR(0.0, t.pos.z, 1e-10);
+    }
+}
+
+TEST(HomogeneousTransducerArray, SortedOnRadius)
+{
+    HomogeneousTransducerArray dut(52, 0.07);
+
+    std::vector<Transducer> d = dut.getTransducers();
+    ASSERT_EQ(52, d.size());
+    for (size_t i = 1; i < d.size(); i++)
+    {
+        EXPECT_LE(d[i-1].pos.dist(Pos()), d[i].pos.dist(Pos()) + 1e-12);
+    }
+}
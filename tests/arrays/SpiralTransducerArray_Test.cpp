@@ -0,0 +1,30 @@
+//
+// Copyright(C) 2020 Simon Gustafsson (optisimon.com)
+//
+
+#include "arrays/SpiralTransducerArray.hpp"
+
+#include <gtest/gtest.h>
+
+
+TEST(SpiralTransducerArray, ArchimedeanSpiral)
+{
+    // b = 0 gives r = a * c * (1 + alpha)
+    double a = 1.0;
+    double b = 0.0;
+    double c = 0.5;
+    SpiralTransducerArray dut(a, b, c, 4, 3);
+
+    std::vector<Transducer> d = dut.getTransducers();
+    ASSERT_EQ(3, d.size());
+
+    EXPECT_NEAR(0.5, d[0].pos.x, 1e-10);
+    EXPECT_NEAR(0.0, d[0].pos.y, 1e-10);
+
+    EXPECT_NEAR(0.0, d[1].pos.x, 1e-10);
+    EXPECT_NEAR(0.5 * (1 + M_PI / 2), d[1].pos.y, 1e-10);
+
+    EXPECT_NEAR(-0.5 * (1 + M_PI), d[2].pos.x, 1e-10);
+    EXPECT_NEAR(0.0, d[2].pos.y, 1e-10);
+    EXPECT_NEAR(0.0, d[2].pos.z, 1e-10);
+}